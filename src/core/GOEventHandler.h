@@ -9,12 +9,21 @@
 #define GOEVENTHANDLER_H
 
 class GOMidiEvent;
+class GOMidiReceiverBase;
 
 class GOEventHandler {
 public:
   virtual ~GOEventHandler() {}
 
   virtual void ProcessMidi(const GOMidiEvent &event) = 0;
+  /**
+   * Returns the receiver that ProcessMidi matches the events with. Only the
+   * events the receiver may match are passed to ProcessMidi. If nullptr then
+   * all events are passed
+   */
+  virtual const GOMidiReceiverBase *GetDispatchReceiver() const {
+    return nullptr;
+  }
   virtual void HandleKey(int key) = 0;
 };
 
@@ -20,6 +20,7 @@
 #include <unistd.h>
 #endif
 #include <errno.h>
+#include <string.h>
 
 #include <wx/file.h>
 #include <wx/intl.h>
@@ -30,8 +31,25 @@
 
 static inline void touchMemory(const char *pos) { *(const volatile char *)pos; }
 
+/* Decrements the counter of live allocations. Returns false if it is zero */
+static bool releaseAlloc(std::atomic_size_t &nAllocs) {
+  size_t n = nAllocs.load(std::memory_order_relaxed);
+
+  do {
+    if (!n)
+      return false;
+  } while (!nAllocs.compare_exchange_weak(n, n - 1));
+  return true;
+}
+
+thread_local GOMemoryPool::ThreadArena GOMemoryPool::t_Arena
+  = {nullptr, 0, nullptr};
+std::atomic_uint GOMemoryPool::s_NextGeneration(1);
+
 GOMemoryPool::GOMemoryPool()
-  : m_PoolStart(0),
+  : m_Generation(0),
+    m_NCacheAllocs(0),
+    m_PoolStart(0),
     m_PoolPtr(0),
     m_PoolEnd(0),
     m_CacheStart(0),
@@ -43,7 +61,9 @@ GOMemoryPool::GOMemoryPool()
     m_MemoryLimit(0),
     m_AllocError(0),
     m_TouchPos(0),
-    m_TouchCache(false) {
+    m_TouchCache(false),
+    m_IsStreaming(false),
+    m_StreamedSize(0) {
   InitPool();
 }
 
@@ -57,31 +77,94 @@ bool inline GOMemoryPool::InMemoryPool(void *ptr) {
   return false;
 }
 
+GOMemoryPool::Arena &GOMemoryPool::GetThreadArena() {
+  ThreadArena &t = t_Arena;
+
+  if (t.p_pool != this || t.m_Generation != m_Generation) {
+    GOMutexLocker locker(m_mutex);
+
+    m_ThreadArenas.emplace_back(new Arena());
+    t.p_pool = this;
+    t.m_Generation = m_Generation;
+    t.p_arena = m_ThreadArenas.back().get();
+  }
+  return *t.p_arena;
+}
+
+void *GOMemoryPool::ArenaAllocSlow(Arena &arena, size_t length) {
+  void *data = arena.Alloc(length);
+
+  if (data)
+    return data;
+
+  const size_t nChunks = (length + ARENA_CHUNK_SIZE - 1) / ARENA_CHUNK_SIZE;
+  char *chunks = (char *)PoolAlloc(nChunks * ARENA_CHUNK_SIZE);
+
+  if (!chunks) {
+    m_MallocSize += length;
+    return malloc(length);
+  }
+
+  const size_t firstChunk = (chunks - m_PoolStart) / ARENA_CHUNK_SIZE;
+  char *end = chunks + nChunks * ARENA_CHUNK_SIZE;
+
+  for (size_t i = 0; i < nChunks; i++)
+    m_ChunkArenas[firstChunk + i] = &arena;
+  // keep bumping in the range with more space left
+  if (size_t(end - chunks - length) > size_t(arena.m_End - arena.m_Ptr)) {
+    arena.m_Ptr = chunks + length;
+    arena.m_End = end;
+  }
+  arena.m_NAllocs.fetch_add(1, std::memory_order_relaxed);
+  return chunks;
+}
+
 void *GOMemoryPool::Alloc(size_t length, bool final) {
-  if (m_MemoryLimit && m_CacheSize + m_PoolSize + m_MallocSize > m_MemoryLimit)
+  if (
+    m_MemoryLimit
+    && m_CacheSize - m_StreamedSize + m_PoolSize + m_MallocSize
+      > m_MemoryLimit)
     return NULL;
   if (!final)
     return malloc(length);
+  if (!length)
+    length++;
+  if (m_PoolStart && length <= MAX_THREAD_ALLOC) {
+    Arena &arena = GetThreadArena();
+    // only the owner thread bumps the arena, so no lock is needed
+    void *data = arena.Alloc(length);
+
+    if (data)
+      return data;
+
+    GOMutexLocker locker(m_mutex);
+
+    return ArenaAllocSlow(arena, length);
+  }
+
   GOMutexLocker locker(m_mutex);
-  void *data = PoolAlloc(length);
-  if (data) {
-    AddPoolAlloc(data);
-    return data;
+
+  if (!m_PoolStart) {
+    m_MallocSize += length;
+    return malloc(length);
   }
-  m_MallocSize += length;
-  return malloc(length);
+  return ArenaAllocSlow(m_SharedArena, length);
 }
 
 void GOMemoryPool::Free(void *data) {
   if (!data)
     return;
-  if (InMemoryPool(data)) {
-    GOMutexLocker locker(m_mutex);
-    if (m_PoolAllocs.count(data)) {
-      /* Pool memory is not individually freed */
-      m_PoolAllocs.erase(m_PoolAllocs.find(data));
-      return;
-    } else
+  /* Pool memory is not individually freed */
+  if (m_CacheStart <= data && data < m_CacheStart + m_CacheSize) {
+    if (!releaseAlloc(m_NCacheAllocs))
+      wxLogError(_("Invalid free of %p"), data);
+    return;
+  }
+  if (m_PoolStart <= data && data < m_PoolStart + m_PoolLimit) {
+    const size_t chunk = ((char *)data - m_PoolStart) / ARENA_CHUNK_SIZE;
+    Arena *arena = chunk < m_ChunkArenas.size() ? m_ChunkArenas[chunk] : NULL;
+
+    if (!arena || !releaseAlloc(arena->m_NAllocs))
       wxLogError(_("Invalid free of %p"), data);
     return;
   }
@@ -103,8 +186,6 @@ void *GOMemoryPool::MoveToPool(void *data, size_t length) {
   return new_data;
 }
 
-void GOMemoryPool::AddPoolAlloc(void *data) { m_PoolAllocs.insert(data); }
-
 void *GOMemoryPool::PoolAlloc(size_t length) {
   char *new_ptr;
 
@@ -153,21 +234,63 @@ void *GOMemoryPool::PoolAlloc(size_t length) {
   return NULL;
 }
 
-void *GOMemoryPool::GetCacheData(size_t offset, size_t length) {
+void *GOMemoryPool::GetCacheData(
+  size_t offset, size_t length, bool isToPrefetch) {
   if (!length)
     return NULL;
-  if (m_CacheStart) {
+  if (m_CacheStart && offset + length <= m_CacheSize) {
     char *data = m_CacheStart + offset;
-    for (unsigned i = 0; i < length; i += m_PageSize)
-      touchMemory(data + i);
-    if (length)
-      touchMemory(data + length - 1);
-    AddPoolAlloc(data);
+
+    if (isToPrefetch)
+      PrefetchCacheData(data, length);
+    m_NCacheAllocs.fetch_add(1, std::memory_order_relaxed);
     return data;
   }
   return NULL;
 }
 
+void GOMemoryPool::PrefetchCacheData(const void *data, size_t length) {
+  if (!length)
+    return;
+
+  const char *start = (const char *)data;
+
+#if defined __linux__ || __WXMAC__
+  // let the kernel read the pages ahead instead of faulting them in one by
+  // one. GOSoundTouchTask touches them later in the background
+  const size_t offset = start - m_CacheStart;
+  char *pageStart = m_CacheStart + offset / m_PageSize * m_PageSize;
+
+  madvise(pageStart, start + length - pageStart, MADV_WILLNEED);
+#else
+  for (size_t i = 0; i < length; i += m_PageSize)
+    touchMemory(start + i);
+  touchMemory(start + length - 1);
+#endif
+}
+
+void GOMemoryPool::AddStreamedData(const void *data, size_t length) {
+  const size_t offset = (const char *)data - m_CacheStart;
+  // only the pages lying completely inside are left to the streaming
+  const size_t start = (offset + m_PageSize - 1) / m_PageSize * m_PageSize;
+  const size_t end = (offset + length) / m_PageSize * m_PageSize;
+
+  if (start < end) {
+    GOMutexLocker locker(m_mutex);
+
+    m_StreamedRanges[start] = end;
+    m_StreamedSize += end - start;
+  }
+}
+
+bool GOMemoryPool::ReadCacheData(
+  size_t offset, void *data, size_t length) const {
+  if (!m_CacheStart || offset > m_CacheSize || length > m_CacheSize - offset)
+    return false;
+  memcpy(data, m_CacheStart + offset, length);
+  return true;
+}
+
 void GOMemoryPool::FreeCacheFile() {
   FreePool();
   InitPool();
@@ -368,10 +491,22 @@ void GOMemoryPool::InitPool() {
   }
   m_PoolPtr = m_PoolStart;
   m_PoolEnd = m_PoolStart + m_PoolSize;
+  m_ChunkArenas.assign(m_PoolLimit / ARENA_CHUNK_SIZE, NULL);
+  // invalidate the thread arenas. The generations are unique across the pools
+  m_Generation = s_NextGeneration.fetch_add(1);
+}
+
+bool GOMemoryPool::HasLiveAllocs() const {
+  if (m_NCacheAllocs.load() || m_SharedArena.m_NAllocs.load())
+    return true;
+  for (const auto &arena : m_ThreadArenas)
+    if (arena->m_NAllocs.load())
+      return true;
+  return false;
 }
 
 void GOMemoryPool::FreePool() {
-  if (m_PoolAllocs.size()) {
+  if (HasLiveAllocs()) {
     wxLogError(wxT("Freeing non-empty memory pool"));
   }
 #if defined __linux__ || __WXMAC__
@@ -389,9 +524,17 @@ void GOMemoryPool::FreePool() {
   m_PoolStart = 0;
   m_PoolSize = 0;
   m_PoolLimit = 0;
+  m_ThreadArenas.clear();
+  m_SharedArena.m_Ptr = NULL;
+  m_SharedArena.m_End = NULL;
+  m_SharedArena.m_NAllocs = 0;
+  m_ChunkArenas.clear();
+  m_NCacheAllocs = 0;
 
   m_CacheStart = 0;
   m_CacheSize = 0;
+  m_StreamedRanges.clear();
+  m_StreamedSize = 0;
 }
 
 void GOMemoryPool::GrowPool(size_t length) {
@@ -422,6 +565,15 @@ void GOMemoryPool::GrowPool(size_t length) {
 void GOMemoryPool::TouchMemory(std::atomic_bool &stop) {
   if (m_TouchCache) {
     for (int i = 0; m_TouchPos < m_CacheSize; m_TouchPos += m_PageSize, i++) {
+      // the streamed pages are read by the prefetcher only
+      auto streamed = m_StreamedRanges.upper_bound(m_TouchPos);
+
+      if (
+        streamed != m_StreamedRanges.begin()
+        && m_TouchPos < (--streamed)->second) {
+        m_TouchPos = streamed->second - m_PageSize;
+        continue;
+      }
       touchMemory(m_CacheStart + m_TouchPos);
       if (stop.load() || i > 1000)
         return;
@@ -8,15 +8,64 @@
 #ifndef GOMEMORYPOOL_H_
 #define GOMEMORYPOOL_H_
 
-#include <set>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include "threading/GOMutex.h"
 
 class wxFile;
 
 class GOMemoryPool {
+  /**
+   * A range of the pool memory for bump allocations. Each loading thread has
+   * its own arena, so the small allocations do not take m_mutex. The range is
+   * carved from the pool in whole chunks and the chunks remember their arena
+   */
+  struct Arena {
+    char *m_Ptr;
+    char *m_End;
+    // the number of the live allocations. Free() may come from any thread
+    std::atomic_size_t m_NAllocs;
+
+    Arena() : m_Ptr(nullptr), m_End(nullptr), m_NAllocs(0) {}
+
+    void *Alloc(size_t length) {
+      if (length > size_t(m_End - m_Ptr))
+        return nullptr;
+
+      void *data = m_Ptr;
+
+      m_Ptr += length;
+      m_NAllocs.fetch_add(1, std::memory_order_relaxed);
+      return data;
+    }
+  };
+
+  struct ThreadArena {
+    const GOMemoryPool *p_pool;
+    // the arena is valid only for this generation of the pool
+    unsigned m_Generation;
+    Arena *p_arena;
+  };
+
+  static constexpr size_t ARENA_CHUNK_SIZE = 4 << 20;
+  // the larger allocations are served from m_SharedArena
+  static constexpr size_t MAX_THREAD_ALLOC = ARENA_CHUNK_SIZE / 8;
+
+  static thread_local ThreadArena t_Arena;
+  static std::atomic_uint s_NextGeneration;
+
   GOMutex m_mutex;
-  std::set<void *> m_PoolAllocs;
+  // changed when the pool is reinitialised, so the thread arenas become stale
+  unsigned m_Generation;
+  std::vector<std::unique_ptr<Arena>> m_ThreadArenas;
+  // the arena for the large allocations. Used under m_mutex only
+  Arena m_SharedArena;
+  // the owner arena of each chunk of the reserved pool region
+  std::vector<Arena *> m_ChunkArenas;
+  std::atomic_size_t m_NCacheAllocs;
   char *m_PoolStart;
   char *m_PoolPtr;
   char *m_PoolEnd;
@@ -31,12 +80,18 @@ class GOMemoryPool {
   unsigned m_AllocError;
   size_t m_TouchPos;
   bool m_TouchCache;
+  bool m_IsStreaming;
+  // the page aligned cache ranges [first, second) left to the streaming
+  std::map<size_t, size_t> m_StreamedRanges;
+  size_t m_StreamedSize;
 
   void InitPool();
   void GrowPool(size_t size);
   void FreePool();
   void *PoolAlloc(size_t length);
-  void AddPoolAlloc(void *data);
+  Arena &GetThreadArena();
+  void *ArenaAllocSlow(Arena &arena, size_t length);
+  bool HasLiveAllocs() const;
 
   static size_t GetVMALimit();
   static size_t GetSystemMemory();
@@ -48,19 +103,38 @@ public:
   GOMemoryPool();
   ~GOMemoryPool();
   void SetMemoryLimit(size_t limit);
+  /* Whether long samples may be streamed from the mapped cache */
+  void SetStreaming(bool isStreaming) { m_IsStreaming = isStreaming; }
+  bool IsStreaming() const { return m_IsStreaming; }
   void TouchMemory(std::atomic_bool &stop);
 
   void *Alloc(size_t length, bool final);
   void *MoveToPool(void *data, size_t length);
   void Free(void *data);
 
-  void *GetCacheData(size_t offset, size_t length);
+  /**
+   * Returns a pointer to the sample data in the mapped cache and registers it
+   * as a pool allocation. The pages are faulted in lazily
+   * @param isToPrefetch whether to let the kernel read the data ahead. If not,
+   *   the caller decides later with PrefetchCacheData() and AddStreamedData()
+   */
+  void *GetCacheData(size_t offset, size_t length, bool isToPrefetch = true);
+  /* Lets the kernel read ahead a part of the data got with GetCacheData() */
+  void PrefetchCacheData(const void *data, size_t length);
+  /**
+   * Marks a part of the data got with GetCacheData() as streamed. It is not
+   * touched and is not counted against the memory limit
+   */
+  void AddStreamedData(const void *data, size_t length);
+  /* Copies the metadata from the mapped cache. Returns false if out of it */
+  bool ReadCacheData(size_t offset, void *data, size_t length) const;
   bool SetCacheFile(wxFile &cache_file);
   void FreeCacheFile();
 
   bool IsPoolFull();
   size_t GetAllocSize();
   size_t GetMappedSize();
+  size_t GetStreamedSize() const { return m_StreamedSize; }
   size_t GetPoolSize();
   size_t GetPoolUsage();
   size_t GetMemoryLimit();
@@ -17,14 +17,14 @@ uint8_t GORodgersChecksum(
 
 MIDI_BIT_STATE
 GORodgersGetBit(
-  unsigned stop, unsigned offset, const std::vector<uint8_t> data) {
+  unsigned stop, unsigned offset, const uint8_t *data, unsigned length) {
   unsigned start = offset * 7;
   if (stop < start)
     return MIDI_BIT_STATE::MIDI_BIT_NOT_PRESENT;
   stop -= start;
   unsigned pos = stop / 7;
   unsigned bit = stop - pos * 7;
-  if (pos >= data.size())
+  if (pos >= length)
     return MIDI_BIT_STATE::MIDI_BIT_NOT_PRESENT;
   if (data[pos] & (1 << bit))
     return MIDI_BIT_STATE::MIDI_BIT_SET;
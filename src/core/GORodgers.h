@@ -23,7 +23,7 @@ uint8_t GORodgersChecksum(
   const std::vector<uint8_t> &msg, unsigned start, unsigned len);
 
 MIDI_BIT_STATE GORodgersGetBit(
-  unsigned stop, unsigned offset, const std::vector<uint8_t> data);
+  unsigned stop, unsigned offset, const uint8_t *data, unsigned length);
 unsigned GORodgersSetBit(unsigned stop, bool state, std::vector<uint8_t> &data);
 
 #endif
@@ -7,10 +7,13 @@
 
 #include "GOTimer.h"
 
+#include <wx/thread.h>
+
 #include "GOTimerCallback.h"
 #include "threading/GOMutexLocker.h"
 
-GOTimer::GOTimer() : wxTimer(), m_Entries() {}
+GOTimer::GOTimer(std::recursive_mutex &callbackMutex)
+  : wxTimer(), r_CallbackMutex(callbackMutex), m_Entries() {}
 
 GOTimer::~GOTimer() { wxTimer::Stop(); }
 
@@ -22,6 +25,12 @@ void GOTimer::SetRelativeTimer(
 
 void GOTimer::SetTimer(
   GOTime time, GOTimerCallback *callback, unsigned interval) {
+  if (!wxIsMainThread()) {
+    // a MIDI event from the dispatch thread. wxTimer works in the GUI thread
+    CallAfter([=]() { SetTimer(time, callback, interval); });
+    return;
+  }
+
   GOTimerEntry e;
   e.time = time;
   e.callback = callback;
@@ -41,12 +50,20 @@ void GOTimer::SetTimer(
 }
 
 void GOTimer::UpdateInterval(GOTimerCallback *callback, unsigned interval) {
+  if (!wxIsMainThread()) {
+    CallAfter([=]() { UpdateInterval(callback, interval); });
+    return;
+  }
   for (unsigned i = 0; i < m_Entries.size(); i++)
     if (m_Entries[i].callback == callback)
       m_Entries[i].interval = interval;
 }
 
 void GOTimer::DeleteTimer(GOTimerCallback *callback) {
+  if (!wxIsMainThread()) {
+    CallAfter([=]() { DeleteTimer(callback); });
+    return;
+  }
   for (unsigned i = 0; i < m_Entries.size(); i++)
     if (m_Entries[i].callback == callback)
       m_Entries[i].callback = NULL;
@@ -72,6 +89,7 @@ void GOTimer::Schedule() {
 
 void GOTimer::Notify() {
   GOMutexLocker locker(m_Lock);
+  std::lock_guard<std::recursive_mutex> callbackLocker(r_CallbackMutex);
 
   GOTime now = wxGetLocalTimeMillis();
   for (unsigned i = 0; i < m_Entries.size(); i++)
@@ -10,6 +10,7 @@
 
 #include <wx/timer.h>
 
+#include <mutex>
 #include <vector>
 
 #include "GOTime.h"
@@ -25,6 +26,8 @@ class GOTimer : private wxTimer {
   } GOTimerEntry;
 
 private:
+  // the callbacks are called under it
+  std::recursive_mutex &r_CallbackMutex;
   std::vector<GOTimerEntry> m_Entries;
   GOMutex m_Lock;
 
@@ -32,7 +35,7 @@ private:
   void Notify();
 
 public:
-  GOTimer();
+  GOTimer(std::recursive_mutex &callbackMutex);
   ~GOTimer();
   void Cleanup() { m_Entries.clear(); };
 
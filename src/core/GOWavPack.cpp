@@ -13,32 +13,38 @@
 
 #include "GOAlloc.h"
 
-GOWavPack::GOWavPack(const GOBuffer<uint8_t> &file)
-  : m_data(file),
-    m_Samples(),
+GOWavPack::GOWavPack(const uint8_t *data, size_t size)
+  : m_data(data),
+    m_Size(size),
     m_Wrapper(),
     m_pos(0),
     m_OrigDataLen(0),
+    m_Channels(0),
+    m_NbSamples(0),
     m_context(0) {}
 
 GOWavPack::~GOWavPack() {
-  m_Samples.free();
   m_Wrapper.free();
+  CloseContext();
+}
+
+void GOWavPack::CloseContext() {
   if (m_context)
     WavpackCloseFile(m_context);
+  m_context = NULL;
 }
 
-bool GOWavPack::IsWavPack(const GOBuffer<uint8_t> &data) {
-  return data.GetSize() > 10 && !memcmp(data.get(), "wvpk", 4);
+bool GOWavPack::IsWavPack(const uint8_t *data, size_t size) {
+  return size > 10 && !memcmp(data, "wvpk", 4);
 }
 
-GOBuffer<uint8_t> GOWavPack::GetSamples() { return std::move(m_Samples); }
-
 GOBuffer<uint8_t> GOWavPack::GetWrapper() { return std::move(m_Wrapper); }
 
 unsigned GOWavPack::GetOrigDataLen() { return m_OrigDataLen; }
 
-bool GOWavPack::Unpack() {
+bool GOWavPack::ReadWrapper() {
+  CloseContext();
+  m_pos = 0;
   m_context
     = WavpackOpenFileInputEx(&m_Reader, this, NULL, NULL, OPEN_WRAPPER, 0);
   if (!m_context)
@@ -48,16 +54,12 @@ bool GOWavPack::Unpack() {
   if (!header)
     return false;
 
-  unsigned channels = WavpackGetNumChannels(m_context);
-  unsigned samples = WavpackGetNumSamples(m_context);
-  m_Samples.resize(channels * samples * 4);
-  unsigned res
-    = WavpackUnpackSamples(m_context, (int32_t *)m_Samples.get(), samples);
-  if (res != samples)
-    return false;
-
-  m_OrigDataLen = channels * samples * WavpackGetBytesPerSample(m_context);
+  m_Channels = WavpackGetNumChannels(m_context);
+  m_NbSamples = WavpackGetNumSamples(m_context);
+  m_OrigDataLen
+    = m_Channels * m_NbSamples * WavpackGetBytesPerSample(m_context);
 
+  // the trailer is found without decoding the samples
   WavpackSeekTrailingWrapper(m_context);
   unsigned trailer = WavpackGetWrapperBytes(m_context) - header;
 
@@ -65,12 +67,21 @@ bool GOWavPack::Unpack() {
   m_Wrapper.Append(WavpackGetWrapperData(m_context), header + trailer);
   WavpackFreeWrapper(m_context);
 
-  WavpackCloseFile(m_context);
-  m_context = NULL;
-
+  CloseContext();
   return true;
 }
 
+bool GOWavPack::StartUnpack() {
+  CloseContext();
+  m_pos = 0;
+  m_context = WavpackOpenFileInputEx(&m_Reader, this, NULL, NULL, 0, 0);
+  return m_context != NULL;
+}
+
+unsigned GOWavPack::UnpackSamples(int32_t *buffer, unsigned nSamples) {
+  return m_context ? WavpackUnpackSamples(m_context, buffer, nSamples) : 0;
+}
+
 uint32_t GOWavPack::GetLength(void *id) {
   return ((GOWavPack *)id)->GetLength();
 }
@@ -95,18 +106,18 @@ int GOWavPack::SetPosRel(void *id, int32_t delta, int mode) {
   return ((GOWavPack *)id)->SetPosRel(delta, mode);
 }
 
-uint32_t GOWavPack::GetLength() { return m_data.GetSize(); }
+uint32_t GOWavPack::GetLength() { return m_Size; }
 
 int32_t GOWavPack::ReadBytes(void *data, int32_t bcount) {
-  if (m_pos + bcount > m_data.GetSize())
-    bcount = m_data.GetSize() - m_pos;
-  memcpy(data, m_data.get() + m_pos, bcount);
+  if (m_pos + bcount > m_Size)
+    bcount = m_Size - m_pos;
+  memcpy(data, m_data + m_pos, bcount);
   m_pos += bcount;
   return bcount;
 }
 
 int GOWavPack::PushBackByte(int c) {
-  if (m_pos > 0 && m_pos < m_data.GetSize() && m_data[m_pos - 1] == c) {
+  if (m_pos > 0 && m_pos < m_Size && m_data[m_pos - 1] == c) {
     m_pos--;
     return c;
   }
@@ -118,7 +129,7 @@ uint32_t GOWavPack::GetPos() { return m_pos; }
 int GOWavPack::CanSeek() { return 1; }
 
 int GOWavPack::SetPosAbs(uint32_t pos) {
-  if (pos < m_data.GetCount()) {
+  if (pos < m_Size) {
     m_pos = pos;
     return 0;
   }
@@ -132,7 +143,7 @@ int GOWavPack::SetPosRel(int32_t delta, int mode) {
   case SEEK_CUR:
     return SetPosAbs(m_pos + delta);
   case SEEK_END:
-    return SetPosAbs(m_data.GetCount() + delta);
+    return SetPosAbs(m_Size + delta);
   default:
     return -1;
   }
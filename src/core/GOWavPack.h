@@ -12,13 +12,22 @@
 
 #include "GOBuffer.h"
 
+/**
+ * Decodes a WavPack file in memory.
+ *
+ * The file content is not copied, so it must stay valid while the object is
+ * used. The samples are decoded in chunks into the caller's buffers, so the
+ * whole decoded file is never kept in memory.
+ */
 class GOWavPack {
 private:
-  const GOBuffer<uint8_t> &m_data;
-  GOBuffer<uint8_t> m_Samples;
+  const uint8_t *m_data;
+  size_t m_Size;
   GOBuffer<uint8_t> m_Wrapper;
   unsigned m_pos;
   unsigned m_OrigDataLen;
+  unsigned m_Channels;
+  unsigned m_NbSamples;
   WavpackContext *m_context;
 
   static WavpackStreamReader m_Reader;
@@ -39,16 +48,35 @@ private:
   int SetPosAbs(uint32_t pos);
   int SetPosRel(int32_t delta, int mode);
 
+  void CloseContext();
+
 public:
-  GOWavPack(const GOBuffer<uint8_t> &file);
+  GOWavPack(const uint8_t *data, size_t size);
+  GOWavPack(const GOBuffer<uint8_t> &file)
+    : GOWavPack(file.get(), file.GetSize()) {}
   ~GOWavPack();
 
-  static bool IsWavPack(const GOBuffer<uint8_t> &data);
-  bool Unpack();
+  static bool IsWavPack(const uint8_t *data, size_t size);
+  static bool IsWavPack(const GOBuffer<uint8_t> &data) {
+    return IsWavPack(data.get(), data.GetSize());
+  }
+
+  /* Reads the RIFF wrapper and the stream parameters without decoding */
+  bool ReadWrapper();
+  /* Starts decoding the samples from the beginning */
+  bool StartUnpack();
+  /**
+   * Decodes the next samples
+   * @param buffer receives nSamples * GetChannels() 32 bit values
+   * @param nSamples the number of the samples (frames) to decode
+   * @return the number of samples decoded
+   */
+  unsigned UnpackSamples(int32_t *buffer, unsigned nSamples);
 
-  GOBuffer<uint8_t> GetSamples();
   GOBuffer<uint8_t> GetWrapper();
   unsigned GetOrigDataLen();
+  unsigned GetChannels() const { return m_Channels; }
+  unsigned GetNbSamples() const { return m_NbSamples; }
 };
 
 #endif
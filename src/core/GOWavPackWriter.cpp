@@ -1,19 +1,22 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
 #include "GOWavPackWriter.h"
 
-GOWavPackWriter::GOWavPackWriter() : m_Output(), m_Context(0) {}
+GOWavPackWriter::GOWavPackWriter()
+  : m_Output(), m_Context(0), m_FirstBlock(), m_IsStream(false) {}
 
 GOWavPackWriter::~GOWavPackWriter() { Close(); }
 
 bool GOWavPackWriter::Write(void *data, int32_t count) {
   if (count < 0)
     return false;
+  if (m_IsStream && !m_FirstBlock.GetCount())
+    m_FirstBlock.Append((const uint8_t *)data, count);
   m_Output.Append((const uint8_t *)data, count);
   return true;
 }
@@ -32,6 +35,7 @@ bool GOWavPackWriter::Init(
   unsigned sampleCount) {
   Close();
   m_Output.free();
+  m_IsStream = false;
   m_Context = WavpackOpenFileOutput(&WriteCallback, this, NULL);
   if (!m_Context)
     return false;
@@ -77,3 +81,47 @@ bool GOWavPackWriter::GetResult(GOBuffer<uint8_t> &result) {
   result = std::move(m_Output);
   return true;
 }
+
+bool GOWavPackWriter::InitStream(
+  unsigned channels,
+  unsigned bitsPerSample,
+  unsigned bytesPerSample,
+  unsigned sampleRate,
+  bool isFloat) {
+  Close();
+  m_Output.free();
+  m_FirstBlock.free();
+  m_IsStream = true;
+  m_Context = WavpackOpenFileOutput(&WriteCallback, this, NULL);
+  if (!m_Context)
+    return false;
+  WavpackConfig config;
+  memset(&config, 0, sizeof(config));
+  config.bits_per_sample = bitsPerSample;
+  config.bytes_per_sample = bytesPerSample;
+  config.sample_rate = sampleRate;
+  config.num_channels = channels;
+  config.channel_mask = channels == 1 ? 4 : 3;
+  config.float_norm_exp = isFloat ? 127 : 0;
+  // the total number of samples is unknown
+  return WavpackSetConfiguration(m_Context, &config, (uint32_t)-1) != 0
+    && WavpackPackInit(m_Context) != 0;
+}
+
+bool GOWavPackWriter::AddStreamSamples(int32_t *samples, unsigned nFrames) {
+  return m_Context && WavpackPackSamples(m_Context, samples, nFrames) != 0;
+}
+
+void GOWavPackWriter::TakeOutput(GOBuffer<uint8_t> &result) {
+  result = std::move(m_Output);
+}
+
+bool GOWavPackWriter::FinishStream(GOBuffer<uint8_t> &firstBlock) {
+  if (!m_Context || WavpackFlushSamples(m_Context) == 0)
+    return false;
+  if (m_FirstBlock.GetCount())
+    WavpackUpdateNumSamples(m_Context, m_FirstBlock.get());
+  firstBlock = std::move(m_FirstBlock);
+  m_IsStream = false;
+  return Close();
+}
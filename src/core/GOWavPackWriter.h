@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -16,6 +16,9 @@ class GOWavPackWriter {
 private:
   GOBuffer<uint8_t> m_Output;
   WavpackContext *m_Context;
+  // a copy of the first block of a stream. It is updated on FinishStream()
+  GOBuffer<uint8_t> m_FirstBlock;
+  bool m_IsStream;
 
   bool Write(void *data, int32_t count);
   static int WriteCallback(void *id, void *data, int32_t bcount);
@@ -34,6 +37,29 @@ public:
   bool AddWrapper(GOBuffer<uint8_t> &header);
   bool AddSampleData(GOBuffer<int32_t> &sampleData);
   bool GetResult(GOBuffer<uint8_t> &result);
+
+  /**
+   * Starts encoding a stream of unknown length. Unlike Init(), a faster
+   * compression mode is used, so the stream may be encoded in real time.
+   * The encoded blocks should be taken with TakeOutput() from time to time
+   * @param isFloat whether the samples are IEEE floats passed as int32_t
+   */
+  bool InitStream(
+    unsigned channels,
+    unsigned bitsPerSample,
+    unsigned bytesPerSample,
+    unsigned sampleRate,
+    bool isFloat);
+  /* Encodes nFrames of interleaved samples of the stream */
+  bool AddStreamSamples(int32_t *samples, unsigned nFrames);
+  /* Moves the blocks encoded so far to result */
+  void TakeOutput(GOBuffer<uint8_t> &result);
+  /**
+   * Flushes the rest of the stream. After TakeOutput() the caller should
+   * overwrite the beginning of the output with firstBlock that now contains
+   * the total number of samples
+   */
+  bool FinishStream(GOBuffer<uint8_t> &firstBlock);
 };
 
 #endif
@@ -7,6 +7,8 @@
 
 #include "GOWave.h"
 
+#include <algorithm>
+
 #include <wx/file.h>
 #include <wx/intl.h>
 #include <wx/log.h>
@@ -18,7 +20,10 @@
 #include "GOWaveTypes.h"
 
 void GOWave::SetInvalid() {
-  m_SampleData.free();
+  m_Pack.reset();
+  m_Content.free();
+  p_SampleData = nullptr;
+  m_SampleDataSize = 0;
   m_Channels = 0;
   m_BytesPerSample = 0;
   m_SampleRate = 0;
@@ -120,14 +125,24 @@ void GOWave::Open(GOOpenedFile *file) {
   if (!file->Open())
     throw wxString::Format(_("Failed to open file '%s'"), fileName);
 
-  // Allocate memory for wave and read it.
-  GOBuffer<uint8_t> content(file->GetSize());
-
-  if (!file->Read(content))
-    throw wxString::Format(_("Failed to read file '%s'"), fileName);
+  // a mapped file is parsed in place without reading it into a buffer. It
+  // stays mapped while the archive is open
+  const uint8_t *data = (const uint8_t *)file->GetContent();
 
+  if (data)
+    Open(data, file->GetSize(), fileName);
+  else {
+    // Allocate memory for wave and read it.
+    GOBuffer<uint8_t> content(file->GetSize());
+
+    if (!file->Read(content))
+      throw wxString::Format(_("Failed to read file '%s'"), fileName);
+    Open(content, fileName);
+    // the samples refer to the content, so keep it. Moving does not change
+    // the data address
+    m_Content = std::move(content);
+  }
   file->Close();
-  Open(content, fileName);
 }
 
 static void check_for_bounds(
@@ -154,7 +169,8 @@ static void check_for_bounds(
   }
 }
 
-void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
+void GOWave::Open(
+  const uint8_t *content, size_t size, const wxString fileName) {
   /* Close any currently open wave data */
   Close();
 
@@ -163,26 +179,24 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
   size_t start = 0;
   size_t origDataLen = 0;
   try {
-    if (content.GetSize() < 12)
+    if (size < 12)
       throw wxString::Format(_("Not a RIFF file: %s"), fileName);
 
-    const uint8_t *ptr = content.get();
-    unsigned length = content.GetSize();
+    const uint8_t *ptr = content;
+    unsigned length = size;
 
-    if (GOWavPack::IsWavPack(content)) {
-      GOWavPack pack(content);
-      if (!pack.Unpack())
+    if (GOWavPack::IsWavPack(content, size)) {
+      m_Pack.reset(new GOWavPack(content, size));
+      if (!m_Pack->ReadWrapper())
         throw wxString::Format(
           _("Failed to decode WavePack data: %s"), fileName);
 
-      m_SampleData = pack.GetSamples();
-
-      buf = pack.GetWrapper();
+      buf = m_Pack->GetWrapper();
       ptr = buf.get();
       length = buf.GetSize();
       offset = 0;
       m_isPacked = true;
-      origDataLen = pack.GetOrigDataLen();
+      origDataLen = m_Pack->GetOrigDataLen();
     }
 
     /* Read the header, get it's size and make sure that it makes sense. */
@@ -236,9 +250,9 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
         if (m_isPacked)
           size = 0;
         else {
-          m_SampleData.free();
           check_for_bounds(fileName, header, offset, length, chunkOffset);
-          m_SampleData.Append(ptr + offset, size);
+          p_SampleData = ptr + offset;
+          m_SampleDataSize = size;
         }
       }
       if (header->fccChunk == WAVE_TYPE_FMT) {
@@ -265,8 +279,10 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
 
     if (offset != length)
       throw wxString::Format(_("Invalid WAV file: %s"), fileName);
-    if (!m_SampleData.get() || !m_SampleData.GetSize())
+    if (m_isPacked ? !m_Pack->GetNbSamples() : !m_SampleDataSize)
       throw wxString::Format(_("No samples found: %s"), fileName);
+    if (m_isPacked && m_Pack->GetChannels() != m_Channels)
+      throw wxString::Format(_("Inconsitant WavPack file: %s"), fileName);
 
     // learning lesson: never ever trust the range values of outside sources to
     // be correct!
@@ -290,10 +306,7 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
 }
 
 void GOWave::Close() {
-  /* Free the wave data if it has been alloc'ed */
-  m_SampleData.free();
-
-  /* Set the wave to the invalid state.  */
+  /* Set the wave to the invalid state and free the wave data.  */
   SetInvalid();
 }
 
@@ -329,10 +342,10 @@ const GOWaveLoop &GOWave::GetLongestLoop() const {
 
 unsigned GOWave::GetLength() const {
   if (m_isPacked)
-    return m_SampleData.GetSize() / (4 * m_Channels);
+    return m_Pack->GetNbSamples();
   /* return number of samples in the stream */
-  assert((m_SampleData.GetSize() % (m_BytesPerSample * m_Channels)) == 0);
-  return m_SampleData.GetSize() / (m_BytesPerSample * m_Channels);
+  assert((m_SampleDataSize % (m_BytesPerSample * m_Channels)) == 0);
+  return m_SampleDataSize / (m_BytesPerSample * m_Channels);
 }
 
 template <class T> void GOWave::writeNext(uint8_t *&output, const T &value) {
@@ -377,10 +390,49 @@ void GOWave::ReadSamples(
   if (select_channel != 0)
     merge_count = m_Channels;
 
-  const uint8_t *input = m_SampleData.get();
   uint8_t *output = (uint8_t *)dest_buffer;
 
-  unsigned len = m_Channels * GetLength() / merge_count;
+  if (!m_isPacked) {
+    ConvertSamples(
+      p_SampleData,
+      GetLength(),
+      output,
+      read_format,
+      merge_count,
+      select_channel);
+    return;
+  }
+
+  // decode by chunks directly into the destination
+  const unsigned nFrames = GetLength();
+  GOBuffer<int32_t> chunk(UNPACK_CHUNK_FRAMES * m_Channels);
+
+  if (!m_Pack->StartUnpack())
+    throw(wxString) _("Failed to decode WavePack data");
+  for (unsigned pos = 0; pos < nFrames;) {
+    const unsigned n = std::min(nFrames - pos, UNPACK_CHUNK_FRAMES);
+
+    if (m_Pack->UnpackSamples(chunk.get(), n) != n)
+      throw(wxString) _("Failed to decode WavePack data");
+    ConvertSamples(
+      (const uint8_t *)chunk.get(),
+      n,
+      output,
+      read_format,
+      merge_count,
+      select_channel);
+    pos += n;
+  }
+}
+
+void GOWave::ConvertSamples(
+  const uint8_t *input,
+  unsigned nFrames,
+  uint8_t *&output,
+  GOWave::SAMPLE_FORMAT read_format,
+  unsigned merge_count,
+  unsigned select_channel) const {
+  unsigned len = m_Channels * nFrames / merge_count;
   for (unsigned i = 0; i < len; i++) {
     int value
       = 0; /* Value will be stored with 24 fractional bits of precision */
@@ -588,10 +640,13 @@ bool GOWave::Save(GOBuffer<uint8_t> &buf) {
     + GetLength() * m_BytesPerSample * GetChannels();
 
   GOBuffer<int32_t> data(GetLength() * GetChannels());
-  if (m_isPacked)
-    memcpy(data.get(), m_SampleData.get(), data.GetSize());
-  else {
-    const uint8_t *input = m_SampleData.get();
+  if (m_isPacked) {
+    if (
+      !m_Pack->StartUnpack()
+      || m_Pack->UnpackSamples(data.get(), GetLength()) != GetLength())
+      return false;
+  } else {
+    const uint8_t *input = p_SampleData;
     for (unsigned i = 0; i < GetLength() * GetChannels(); i++) {
       int32_t val;
       switch (m_BytesPerSample) {
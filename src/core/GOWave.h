@@ -10,16 +10,27 @@
 
 #include <wx/string.h>
 
+#include <memory>
 #include <vector>
 
 #include "GOBuffer.h"
 #include "GOWaveLoop.h"
 
 class GOOpenedFile;
+class GOWavPack;
 
 class GOWave {
 private:
-  GOBuffer<uint8_t> m_SampleData;
+  // how many frames of a WavPack file are decoded at once
+  static constexpr unsigned UNPACK_CHUNK_FRAMES = 4096;
+
+  // the file content if it has been read into memory
+  GOBuffer<uint8_t> m_Content;
+  // the data chunk of an unpacked file inside the content
+  const uint8_t *p_SampleData;
+  size_t m_SampleDataSize;
+  // the decoder of a packed file. The samples are decoded on reading
+  std::unique_ptr<GOWavPack> m_Pack;
   unsigned m_BytesPerSample;
   unsigned m_SampleRate;
   unsigned m_CuePoint;
@@ -63,7 +74,14 @@ public:
   ~GOWave();
 
   void Open(GOOpenedFile *file);
-  void Open(const GOBuffer<uint8_t> &content, const wxString fileName);
+  void Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
+    Open(content.get(), content.GetSize(), fileName);
+  }
+  /**
+   * Parses the file content in memory. The samples are not copied, so the
+   * content must stay valid until the wave is closed
+   */
+  void Open(const uint8_t *content, size_t size, const wxString fileName);
   bool Save(GOBuffer<uint8_t> &buf);
   void Close();
 
@@ -106,6 +124,16 @@ public:
 
   static bool IsWave(const GOBuffer<uint8_t> &data);
   static bool IsWaveFile(const GOBuffer<uint8_t> &data);
+
+private:
+  /* Converts nFrames frames from input and appends them to output */
+  void ConvertSamples(
+    const uint8_t *input,
+    unsigned nFrames,
+    uint8_t *&output,
+    GOWave::SAMPLE_FORMAT read_format,
+    unsigned merge_count,
+    unsigned select_channel) const;
 };
 
 #endif /* GOWAVE_H */
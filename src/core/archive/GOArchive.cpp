@@ -7,6 +7,18 @@
 
 #include "GOArchive.h"
 
+#if defined __linux__ || __WXMAC__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef __WIN32__
+#include <io.h>
+#include <windows.h>
+#endif
+#include <string.h>
+
+#include <algorithm>
+
 #include <wx/intl.h>
 #include <wx/log.h>
 
@@ -18,7 +30,14 @@
 #include "GOArchiveReader.h"
 
 GOArchive::GOArchive(const wxString &cachePath)
-  : m_CachePath(cachePath), m_ID(), m_Dependencies(), m_Entries(), m_Path() {}
+  : m_CachePath(cachePath),
+    m_ID(),
+    m_Dependencies(),
+    m_Entries(),
+    m_Path(),
+    m_Data(nullptr),
+    m_Size(0),
+    m_IsVerified(false) {}
 
 GOArchive::~GOArchive() { Close(); }
 
@@ -31,8 +50,10 @@ bool GOArchive::OpenArchive(const wxString &path) {
   }
   {
     GOArchiveIndex index(m_CachePath, m_Path);
-    if (index.ReadIndex(m_ID, m_Entries))
+    if (index.ReadIndex(m_ID, m_Entries, m_IsVerified)) {
+      MapFile();
       return true;
+    }
   }
 
   GOArchiveReader reader(m_File);
@@ -41,33 +62,133 @@ bool GOArchive::OpenArchive(const wxString &path) {
     return false;
   }
 
+  GOArchiveIndex::SortEntries(m_Entries);
+  m_IsVerified = false;
+
   GOArchiveIndex index(m_CachePath, m_Path);
-  index.WriteIndex(m_ID, m_Entries);
+  index.WriteIndex(m_ID, m_Entries, m_IsVerified);
+  MapFile();
   return true;
 }
 
 void GOArchive::Close() {
+  UnmapFile();
   m_File.Close();
   m_Entries.clear();
 }
 
-bool GOArchive::containsFile(const wxString &name) {
-  for (unsigned i = 0; i < m_Entries.size(); i++)
-    if (m_Entries[i].name == name)
-      return true;
-  return false;
+void GOArchive::MapFile() {
+  const wxFileOffset length = m_File.Length();
+
+  UnmapFile();
+  if (length <= 0)
+    return;
+#if defined __linux__ || __WXMAC__
+  void *data = mmap(NULL, length, PROT_READ, MAP_SHARED, m_File.fd(), 0);
+
+  if (data != MAP_FAILED) {
+    m_Data = (const uint8_t *)data;
+    m_Size = length;
+  }
+#endif
+#ifdef __WIN32__
+  HANDLE map = CreateFileMapping(
+    (HANDLE)_get_osfhandle(m_File.fd()), NULL, PAGE_READONLY, 0, 0, NULL);
+
+  if (map) {
+    m_Data = (const uint8_t *)MapViewOfFile(map, FILE_MAP_READ, 0, 0, length);
+    if (m_Data)
+      m_Size = length;
+    CloseHandle(map);
+  }
+#endif
+  // a large package may not fit into the address space. It is read then
+  if (!m_Data)
+    wxLogWarning(
+      _("Failed to map '%s'. It is read without mapping"), m_Path.c_str());
+}
+
+void GOArchive::UnmapFile() {
+  if (m_Data) {
+#if defined __linux__ || __WXMAC__
+    munmap((void *)m_Data, m_Size);
+#endif
+#ifdef __WIN32__
+    UnmapViewOfFile(m_Data);
+#endif
+  }
+  m_Data = nullptr;
+  m_Size = 0;
+}
+
+const GOArchiveEntry *GOArchive::FindEntry(
+  const wxString &name, uint64_t nameHash) const {
+  auto i = std::lower_bound(
+    m_Entries.begin(),
+    m_Entries.end(),
+    nameHash,
+    [](const GOArchiveEntry &e, uint64_t hash) { return e.nameHash < hash; });
+
+  for (; i != m_Entries.end() && i->nameHash == nameHash; ++i)
+    if (i->name == name)
+      return &*i;
+  return nullptr;
+}
+
+bool GOArchive::containsFile(const wxString &name) const {
+  return containsFile(name, GOArchiveIndex::HashName(name));
+}
+
+bool GOArchive::containsFile(const wxString &name, uint64_t nameHash) const {
+  return FindEntry(name, nameHash) != nullptr;
 }
 
 GOOpenedFile *GOArchive::OpenFile(const wxString &name) {
-  for (unsigned i = 0; i < m_Entries.size(); i++)
-    if (m_Entries[i].name == name) {
-      return new GOArchiveEntryFile(
-        this, m_Entries[i].name, m_Entries[i].offset, m_Entries[i].len);
-    }
+  const GOArchiveEntry *e = FindEntry(name, GOArchiveIndex::HashName(name));
+
+  if (e)
+    return new GOArchiveEntryFile(this, e->name, e->offset, e->len);
   return new GOInvalidFile(name);
 }
 
+bool GOArchive::GetEntryRange(
+  const wxString &name, size_t &offset, size_t &len, uint32_t &crc) const {
+  const GOArchiveEntry *e = FindEntry(name, GOArchiveIndex::HashName(name));
+
+  if (e) {
+    offset = e->offset;
+    len = e->len;
+    crc = e->crc;
+  }
+  return e != nullptr;
+}
+
 size_t GOArchive::ReadContent(void *buffer, size_t offset, size_t len) {
+  if (m_Data) {
+    if (offset >= m_Size)
+      return 0;
+    if (len > m_Size - offset)
+      len = m_Size - offset;
+    memcpy(buffer, m_Data + offset, len);
+    return len;
+  }
+#if defined __linux__ || __WXMAC__
+  // a positional read does not move the shared file position
+  ssize_t l = pread(m_File.fd(), buffer, len, offset);
+
+  return l < 0 ? 0 : l;
+#elif defined __WIN32__
+  OVERLAPPED overlapped;
+  DWORD l = 0;
+
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.Offset = (DWORD)offset;
+  overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+  if (!ReadFile(
+        (HANDLE)_get_osfhandle(m_File.fd()), buffer, len, &l, &overlapped))
+    return 0;
+  return l;
+#else
   GOMutexLocker lock(m_Mutex);
   ssize_t pos = m_File.Seek(offset);
   if (pos != (ssize_t)offset)
@@ -76,6 +197,20 @@ size_t GOArchive::ReadContent(void *buffer, size_t offset, size_t len) {
   if (l == wxInvalidOffset)
     return 0;
   return l;
+#endif
+}
+
+const uint8_t *GOArchive::GetContent(size_t offset, size_t len) const {
+  return m_Data && offset <= m_Size && len <= m_Size - offset
+    ? m_Data + offset
+    : nullptr;
+}
+
+void GOArchive::SetVerified() {
+  GOArchiveIndex index(m_CachePath, m_Path);
+
+  m_IsVerified = true;
+  index.WriteIndex(m_ID, m_Entries, m_IsVerified);
 }
 
 const wxString &GOArchive::GetArchiveID() { return m_ID; }
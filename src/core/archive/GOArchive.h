@@ -11,6 +11,7 @@
 #include <wx/file.h>
 #include <wx/string.h>
 
+#include <cstdint>
 #include <vector>
 
 #include "threading/GOMutex.h"
@@ -18,15 +19,33 @@
 class GOOpenedFile;
 typedef struct _GOArchiveEntry GOArchiveEntry;
 
+/**
+ * An opened organ package.
+ *
+ * The package is mapped read-only, so the entries are read by several loading
+ * threads without locking. If the mapping fails, positional reads are used.
+ */
 class GOArchive {
 private:
+  // serializes the reads only if neither mapping nor pread is available
   GOMutex m_Mutex;
   wxString m_CachePath;
   wxString m_ID;
   std::vector<wxString> m_Dependencies;
+  // sorted by the name hashes
   std::vector<GOArchiveEntry> m_Entries;
   wxFile m_File;
   wxString m_Path;
+  // the mapped package. nullptr if it is not mapped
+  const uint8_t *m_Data;
+  size_t m_Size;
+  // whether the CRCs of the entries have been checked
+  bool m_IsVerified;
+
+  void MapFile();
+  void UnmapFile();
+  const GOArchiveEntry *FindEntry(
+    const wxString &name, uint64_t nameHash) const;
 
 public:
   GOArchive(const wxString &cachePath);
@@ -35,10 +54,23 @@ public:
   bool OpenArchive(const wxString &path);
   void Close();
 
-  bool containsFile(const wxString &name);
+  bool containsFile(const wxString &name) const;
+  /* nameHash must be GOArchiveIndex::HashName(name) */
+  bool containsFile(const wxString &name, uint64_t nameHash) const;
+  const std::vector<GOArchiveEntry> &GetEntries() const { return m_Entries; }
   GOOpenedFile *OpenFile(const wxString &name);
+  /* Returns where the entry is stored in the archive and its CRC */
+  bool GetEntryRange(
+    const wxString &name, size_t &offset, size_t &len, uint32_t &crc) const;
 
+  /* Reads a part of the package. It may be called from several threads */
   size_t ReadContent(void *buffer, size_t offset, size_t len);
+  /* Returns a part of the mapped package or nullptr if it is not mapped */
+  const uint8_t *GetContent(size_t offset, size_t len) const;
+
+  bool IsVerified() const { return m_IsVerified; }
+  /* Stores in the index that the CRCs of all entries are correct */
+  void SetVerified();
 
   const wxString &GetArchiveID();
   const wxString &GetPath();
@@ -38,3 +38,7 @@ size_t GOArchiveEntryFile::Read(void *buffer, size_t len) {
   m_Pos += len;
   return len;
 }
+
+const void *GOArchiveEntryFile::GetContent() {
+  return m_archiv->GetContent(m_Offset, m_Length);
+}
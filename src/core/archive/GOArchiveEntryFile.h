@@ -31,6 +31,7 @@ public:
   bool Open();
   void Close();
   size_t Read(void *buffer, size_t len);
+  const void *GetContent();
 };
 
 #endif
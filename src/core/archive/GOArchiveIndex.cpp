@@ -7,6 +7,9 @@
 
 #include "GOArchiveIndex.h"
 
+#include <algorithm>
+
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 
@@ -16,13 +19,36 @@
 #include "GOHash.h"
 
 /* Value which is used to identify a valid cache index file. */
-#define GRANDORGUE_INDEX_MAGIC 0x43214321
+#define GRANDORGUE_INDEX_MAGIC 0x43214322
 
 GOArchiveIndex::GOArchiveIndex(const wxString &cachePath, const wxString &path)
   : m_CachePath(cachePath), m_Path(path), m_File() {}
 
 GOArchiveIndex::~GOArchiveIndex() { m_File.Close(); }
 
+uint64_t GOArchiveIndex::HashName(const wxString &name) {
+  // FNV-1a
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (wxString::const_iterator i = name.begin(); i != name.end(); ++i) {
+    hash ^= (uint32_t)(wxChar)*i;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+void GOArchiveIndex::SortEntries(std::vector<GOArchiveEntry> &entries) {
+  for (GOArchiveEntry &e : entries)
+    e.nameHash = HashName(e.name);
+  // stable, so the first one of the entries with the same name is found
+  std::stable_sort(
+    entries.begin(),
+    entries.end(),
+    [](const GOArchiveEntry &a, const GOArchiveEntry &b) {
+      return a.nameHash < b.nameHash;
+    });
+}
+
 wxString GOArchiveIndex::GenerateIndexFilename() {
   return GOStdFileName::composeFullPath(
     m_CachePath,
@@ -41,6 +67,12 @@ GOHashType GOArchiveIndex::GenerateHash() {
   hash.Update(time);
   hash.Update(size);
 
+  // a replaced file may have the same size and time
+  wxStructStat st;
+  uint64_t inode = wxStat(m_Path, &st) == 0 ? st.st_ino : 0;
+
+  hash.Update(inode);
+
   return hash.getHash();
 }
 
@@ -79,6 +111,10 @@ bool GOArchiveIndex::WriteEntry(const GOArchiveEntry &e) {
     return false;
   if (!Write(&e.len, sizeof(e.len)))
     return false;
+  if (!Write(&e.crc, sizeof(e.crc)))
+    return false;
+  if (!Write(&e.nameHash, sizeof(e.nameHash)))
+    return false;
   return true;
 }
 
@@ -89,14 +125,23 @@ bool GOArchiveIndex::ReadEntry(GOArchiveEntry &e) {
     return false;
   if (!Read(&e.len, sizeof(e.len)))
     return false;
+  if (!Read(&e.crc, sizeof(e.crc)))
+    return false;
+  if (!Read(&e.nameHash, sizeof(e.nameHash)))
+    return false;
   return true;
 }
 
 bool GOArchiveIndex::ReadContent(
-  wxString &id, std::vector<GOArchiveEntry> &entries) {
+  wxString &id, std::vector<GOArchiveEntry> &entries, bool &isVerified) {
   if (!ReadString(id))
     return false;
 
+  uint8_t verified;
+  if (!Read(&verified, sizeof(verified)))
+    return false;
+  isVerified = verified != 0;
+
   unsigned cnt;
   if (!Read(&cnt, sizeof(cnt)))
     return false;
@@ -109,7 +154,9 @@ bool GOArchiveIndex::ReadContent(
 }
 
 bool GOArchiveIndex::WriteContent(
-  const wxString &id, const std::vector<GOArchiveEntry> &entries) {
+  const wxString &id,
+  const std::vector<GOArchiveEntry> &entries,
+  bool isVerified) {
   int magic = GRANDORGUE_INDEX_MAGIC;
   if (!Write(&magic, sizeof(magic)))
     return false;
@@ -121,6 +168,10 @@ bool GOArchiveIndex::WriteContent(
   if (!WriteString(id))
     return false;
 
+  uint8_t verified = isVerified;
+  if (!Write(&verified, sizeof(verified)))
+    return false;
+
   unsigned cnt = entries.size();
   if (!Write(&cnt, sizeof(cnt)))
     return false;
@@ -132,7 +183,7 @@ bool GOArchiveIndex::WriteContent(
 }
 
 bool GOArchiveIndex::ReadIndex(
-  wxString &id, std::vector<GOArchiveEntry> &entries) {
+  wxString &id, std::vector<GOArchiveEntry> &entries, bool &isVerified) {
   wxString name = GenerateIndexFilename();
   if (!wxFileExists(name))
     return false;
@@ -157,7 +208,7 @@ bool GOArchiveIndex::ReadIndex(
     return false;
   }
 
-  if (!ReadContent(id, entries)) {
+  if (!ReadContent(id, entries, isVerified)) {
     m_File.Close();
     wxLogWarning(_("Failed to read '%s'"), name.c_str());
     return false;
@@ -167,8 +218,20 @@ bool GOArchiveIndex::ReadIndex(
   return true;
 }
 
+bool GOArchiveIndex::IsVerified() {
+  // a missing or an outdated index only means that the package is not verified
+  wxLogNull noLog;
+  wxString id;
+  std::vector<GOArchiveEntry> entries;
+  bool isVerified = false;
+
+  return ReadIndex(id, entries, isVerified) && isVerified;
+}
+
 bool GOArchiveIndex::WriteIndex(
-  const wxString &id, const std::vector<GOArchiveEntry> &entries) {
+  const wxString &id,
+  const std::vector<GOArchiveEntry> &entries,
+  bool isVerified) {
   wxString name = GenerateIndexFilename();
   if (!m_File.Create(name, true) || !m_File.IsOpened()) {
     m_File.Close();
@@ -176,7 +239,7 @@ bool GOArchiveIndex::WriteIndex(
     return false;
   }
 
-  if (!WriteContent(id, entries)) {
+  if (!WriteContent(id, entries, isVerified)) {
     m_File.Close();
     wxLogError(_("Failed to write content to '%s'"), name.c_str());
     return false;
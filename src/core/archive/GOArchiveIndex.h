@@ -11,6 +11,7 @@
 #include <wx/file.h>
 #include <wx/string.h>
 
+#include <cstdint>
 #include <vector>
 
 class GOSettingDirectory;
@@ -20,6 +21,10 @@ typedef struct _GOArchiveEntry {
   wxString name;
   size_t offset;
   size_t len;
+  // the CRC from the zip central directory. Checked by GOArchiveVerifier
+  uint32_t crc;
+  // GOArchiveIndex::HashName(name). The entries are sorted by it
+  uint64_t nameHash;
 } GOArchiveEntry;
 
 class GOArchiveIndex {
@@ -40,17 +45,43 @@ private:
   bool WriteEntry(const GOArchiveEntry &e);
   bool ReadEntry(GOArchiveEntry &e);
 
-  bool ReadContent(wxString &id, std::vector<GOArchiveEntry> &entries);
+  bool ReadContent(
+    wxString &id, std::vector<GOArchiveEntry> &entries, bool &isVerified);
   bool WriteContent(
-    const wxString &id, const std::vector<GOArchiveEntry> &entries);
+    const wxString &id,
+    const std::vector<GOArchiveEntry> &entries,
+    bool isVerified);
 
 public:
   GOArchiveIndex(const wxString &cachePath, const wxString &path);
   ~GOArchiveIndex();
 
-  bool ReadIndex(wxString &id, std::vector<GOArchiveEntry> &entries);
+  /* Returns a hash of an entry name for looking the entries up */
+  static uint64_t HashName(const wxString &name);
+  /* Fills the name hashes and sorts the entries by them */
+  static void SortEntries(std::vector<GOArchiveEntry> &entries);
+
+  /**
+   * Reads the cached content of the archive. The index is valid only while
+   * the size, the modification time and the inode of the archive are the
+   * same, so neither the archive ID nor the entries are calculated again
+   * @param id receives the archive ID
+   * @param entries receives the entries
+   * @param isVerified receives whether the CRCs of the entries have been
+   *   checked
+   * @return whether a valid index has been read
+   */
+  bool ReadIndex(
+    wxString &id, std::vector<GOArchiveEntry> &entries, bool &isVerified);
   bool WriteIndex(
-    const wxString &id, const std::vector<GOArchiveEntry> &entries);
+    const wxString &id,
+    const std::vector<GOArchiveEntry> &entries,
+    bool isVerified);
+  /**
+   * Returns whether a valid index exists and the CRCs of the entries have been
+   * checked. Does not log anything, so it may be called for displaying
+   */
+  bool IsVerified();
 };
 
 #endif
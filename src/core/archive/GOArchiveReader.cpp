@@ -10,7 +10,6 @@
 #include <wx/font.h>
 #include <wx/intl.h>
 #include <wx/log.h>
-#include <zlib.h>
 
 #include "GOArchiveIndex.h"
 #include "GOBuffer.h"
@@ -40,42 +39,21 @@ bool GOArchiveReader::Read(void *buf, size_t len) {
 bool GOArchiveReader::GenerateFileHash(wxString &id) {
   unsigned length = m_File.Length();
   GOHash hash;
-  char buf[4096];
+  GOBuffer<uint8_t> buf(HASH_BUFFER_SIZE);
   if (!Seek(0))
     return false;
-  for (unsigned pos = 0; pos < length; pos += sizeof(buf)) {
+  for (unsigned pos = 0; pos < length; pos += buf.GetSize()) {
     size_t l = length - pos;
-    if (l > sizeof(buf))
-      l = sizeof(buf);
-    if (!Read(buf, l))
+    if (l > buf.GetSize())
+      l = buf.GetSize();
+    if (!Read(buf.get(), l))
       return false;
-    hash.Update(buf, l);
+    hash.Update(buf.get(), l);
   }
   id = hash.getStringHash();
   return true;
 }
 
-uint32_t GOArchiveReader::CalculateCrc(size_t offset, size_t length) {
-  uint8_t buf[4096];
-  if (!Seek(offset)) {
-    wxLogError(_("Reading data for CRC failed"));
-    return 0;
-  }
-  uint32_t crc = crc32(0, Z_NULL, 0);
-  while (length > 0) {
-    size_t len = length;
-    if (len > sizeof(buf))
-      len = sizeof(buf);
-    if (!Read(buf, len)) {
-      wxLogError(_("Reading data for CRC failed"));
-      return 0;
-    }
-    crc = crc32(crc, buf, len);
-    length -= len;
-  }
-  return crc;
-}
-
 size_t GOArchiveReader::ExtractU64(void *ptr) {
   GOUInt64LE *p = (GOUInt64LE *)ptr;
   return *p;
@@ -333,9 +311,9 @@ bool GOArchiveReader::ReadFileRecord(
   e.offset
     = local_offset + local.name_length + local.extra_length + sizeof(local);
   e.len = central_uncompressed_size;
+  // the content is checked by GOArchiveVerifier on demand
+  e.crc = central.crc;
   entries.push_back(e);
-  if (CalculateCrc(e.offset, e.len) != central.crc)
-    wxLogError(_("CRC mismatch in organ package - file corrupted?"));
   return true;
 }
 
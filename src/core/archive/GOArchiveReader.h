@@ -19,6 +19,8 @@ typedef struct _GOArchiveEntry GOArchiveEntry;
 
 class GOArchiveReader {
 private:
+  static constexpr size_t HASH_BUFFER_SIZE = 1 << 20;
+
   wxFile &m_File;
 
   bool Seek(size_t offset);
@@ -26,7 +28,6 @@ private:
   bool GenerateFileHash(wxString &id);
   size_t ExtractU64(void *ptr);
   size_t ExtractU32(void *ptr);
-  uint32_t CalculateCrc(size_t offset, size_t length);
 
   bool ReadFileRecord(
     size_t central_offset,
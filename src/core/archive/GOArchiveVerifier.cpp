@@ -0,0 +1,112 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOArchiveVerifier.h"
+
+#include <algorithm>
+
+#include <zlib.h>
+
+#include "threading/GOMutexLocker.h"
+
+#include "GOArchive.h"
+#include "GOArchiveIndex.h"
+
+GOArchiveVerifier::GOArchiveVerifier(GOArchive &archive)
+  : r_archive(archive),
+    m_Threads(),
+    m_NextEntry(0),
+    m_NRunning(0),
+    m_BytesDone(0),
+    m_BytesTotal(0),
+    m_Mutex(),
+    m_Corrupted(),
+    m_IsFailed(false) {}
+
+void GOArchiveVerifier::Start(unsigned nThreads) {
+  Stop();
+  m_NextEntry = 0;
+  m_BytesDone = 0;
+  m_BytesTotal = 0;
+  m_Corrupted.clear();
+  m_IsFailed = false;
+  for (const GOArchiveEntry &e : r_archive.GetEntries())
+    m_BytesTotal += e.len;
+
+  nThreads = std::max(nThreads, 1u);
+  m_NRunning = nThreads;
+  for (unsigned i = 0; i < nThreads; i++)
+    m_Threads.push_back(new VerifyThread(*this));
+  for (unsigned i = 0; i < nThreads; i++)
+    m_Threads[i]->Start();
+}
+
+void GOArchiveVerifier::Stop() {
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->MarkForStop();
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->Stop();
+  m_Threads.clear();
+}
+
+bool GOArchiveVerifier::CheckEntry(
+  unsigned index, GOThread *thread, std::vector<uint8_t> &buf) {
+  const GOArchiveEntry &e = r_archive.GetEntries()[index];
+  // the entry is read directly from the mapping if it is available
+  const uint8_t *content = r_archive.GetContent(e.offset, e.len);
+  uint32_t crc = crc32(0, Z_NULL, 0);
+
+  for (size_t pos = 0; pos < e.len; pos += BUFFER_SIZE) {
+    const size_t len = std::min(e.len - pos, BUFFER_SIZE);
+    const uint8_t *data = content ? content + pos : buf.data();
+
+    if (thread->ShouldStop())
+      return false;
+    if (
+      !content
+      && r_archive.ReadContent(buf.data(), e.offset + pos, len) != len)
+      return false;
+    crc = crc32(crc, data, len);
+    m_BytesDone.fetch_add(len, std::memory_order_relaxed);
+  }
+  if (crc != e.crc) {
+    GOMutexLocker lock(m_Mutex);
+
+    m_Corrupted.push_back(e.name);
+  }
+  return true;
+}
+
+void GOArchiveVerifier::VerifyLoop(GOThread *thread) {
+  const unsigned nEntries = r_archive.GetEntries().size();
+  std::vector<uint8_t> buf(BUFFER_SIZE);
+
+  for (unsigned i = m_NextEntry.fetch_add(1); i < nEntries;
+       i = m_NextEntry.fetch_add(1))
+    if (!CheckEntry(i, thread, buf)) {
+      GOMutexLocker lock(m_Mutex);
+
+      // interrupted or a read error
+      m_IsFailed = true;
+      break;
+    }
+  m_NRunning.fetch_sub(1);
+}
+
+bool GOArchiveVerifier::Finish(std::vector<wxString> &corrupted) {
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->Wait();
+  m_Threads.clear();
+
+  GOMutexLocker lock(m_Mutex);
+  const bool isOk = !m_IsFailed && m_Corrupted.empty();
+
+  corrupted = m_Corrupted;
+  if (isOk)
+    r_archive.SetVerified();
+  return isOk;
+}
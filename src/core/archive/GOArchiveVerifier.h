@@ -0,0 +1,84 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOARCHIVEVERIFIER_H
+#define GOARCHIVEVERIFIER_H
+
+#include <wx/string.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "ptrvector.h"
+
+#include "threading/GOMutex.h"
+#include "threading/GOThread.h"
+
+class GOArchive;
+
+/**
+ * Checks the CRCs of all entries of an opened archive.
+ *
+ * Opening an archive does not read the entries. The verification reads them
+ * on several background threads with large buffers. When all CRCs are
+ * correct, the result is stored in the archive index, so it is not repeated
+ * until the archive changes.
+ */
+class GOArchiveVerifier {
+private:
+  class VerifyThread : public GOThread {
+  private:
+    GOArchiveVerifier &r_verifier;
+
+  protected:
+    void Entry() override { r_verifier.VerifyLoop(this); }
+
+  public:
+    VerifyThread(GOArchiveVerifier &verifier) : r_verifier(verifier) {}
+  };
+
+  static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+  GOArchive &r_archive;
+  ptr_vector<VerifyThread> m_Threads;
+  // the next entry to check
+  std::atomic_uint m_NextEntry;
+  std::atomic_uint m_NRunning;
+  std::atomic<uint64_t> m_BytesDone;
+  uint64_t m_BytesTotal;
+  GOMutex m_Mutex;
+  // the names of the entries with a wrong CRC
+  std::vector<wxString> m_Corrupted;
+  bool m_IsFailed;
+
+  void VerifyLoop(GOThread *thread);
+  bool CheckEntry(unsigned index, GOThread *thread, std::vector<uint8_t> &buf);
+
+public:
+  GOArchiveVerifier(GOArchive &archive);
+  ~GOArchiveVerifier() { Stop(); }
+
+  /* Starts the verification on nThreads background threads */
+  void Start(unsigned nThreads);
+  /* Interrupts the verification and waits for the threads */
+  void Stop();
+
+  bool IsRunning() const { return m_NRunning.load() > 0; }
+  uint64_t GetBytesDone() const { return m_BytesDone.load(); }
+  uint64_t GetBytesTotal() const { return m_BytesTotal; }
+
+  /**
+   * Waits for the threads and returns the result. If the verification has
+   * succeeded, it is stored in the archive index
+   * @param corrupted receives the names of the entries with a wrong CRC
+   * @return whether all entries have been read and have correct CRCs
+   */
+  bool Finish(std::vector<wxString> &corrupted);
+};
+
+#endif
@@ -23,6 +23,12 @@ public:
   virtual bool Open() = 0;
   virtual void Close() = 0;
   virtual size_t Read(void *buffer, size_t len) = 0;
+  /**
+   * Returns the whole content if it is already in memory (e.g. mapped), so it
+   * may be used without Read(). Otherwise returns nullptr. The content is
+   * valid until Close()
+   */
+  virtual const void *GetContent() { return nullptr; }
 
   template <class T> bool Read(GOBuffer<T> &buf) {
     return Read(buf.get(), buf.GetSize()) == buf.GetSize();
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOMidiDispatchIndex.h"
+
+#include <algorithm>
+
+uint64_t GOMidiDispatchIndex::makeKey(
+  unsigned device, GOMidiEvent::MidiType type, int channel, int key) {
+  // different events may get the same key. It only adds some handlers
+  return ((uint64_t)(device & 0xFFFF) << 48) | ((uint64_t)(type & 0xFF) << 40)
+    | ((uint64_t)((channel + 1) & 0xFF) << 32) | (uint32_t)(key + 1);
+}
+
+void GOMidiDispatchIndex::Clear(unsigned nHandlers) {
+  m_NHandlers = nHandlers;
+  m_Buckets.clear();
+  m_AllEvents.clear();
+}
+
+void GOMidiDispatchIndex::Add(
+  unsigned handlerN,
+  unsigned device,
+  GOMidiEvent::MidiType type,
+  int channel,
+  int key) {
+  std::vector<unsigned> &bucket
+    = m_Buckets[makeKey(device, type, channel, key)];
+
+  // a handler is added in turn, so it may repeat only at the end
+  if (bucket.empty() || bucket.back() != handlerN)
+    bucket.push_back(handlerN);
+}
+
+void GOMidiDispatchIndex::AddForAllEvents(unsigned handlerN) {
+  m_AllEvents.push_back(handlerN);
+}
+
+void GOMidiDispatchIndex::FindInBucket(
+  uint64_t key, std::vector<unsigned> &handlers) const {
+  auto it = m_Buckets.find(key);
+
+  if (it != m_Buckets.end())
+    handlers.insert(handlers.end(), it->second.begin(), it->second.end());
+}
+
+void GOMidiDispatchIndex::Find(
+  const GOMidiEvent &e, std::vector<unsigned> &handlers) const {
+  const GOMidiEvent::MidiType type = e.GetMidiType();
+
+  handlers.clear();
+  if (
+    type == GOMidiEvent::MIDI_SYSEX_GO_CLEAR
+    || type == GOMidiEvent::MIDI_SYSEX_GO_SAMPLESET
+    || type == GOMidiEvent::MIDI_SYSEX_GO_SETUP) {
+    for (unsigned i = 0; i < m_NHandlers; i++)
+      handlers.push_back(i);
+    return;
+  }
+
+  const unsigned devices[] = {e.GetDevice(), 0};
+  const int channels[] = {e.GetChannel(), ANY};
+  const int keys[] = {e.GetKey(), ANY};
+
+  handlers.insert(handlers.end(), m_AllEvents.begin(), m_AllEvents.end());
+  for (unsigned device : devices)
+    for (int channel : channels)
+      for (int key : keys)
+        FindInBucket(makeKey(device, type, channel, key), handlers);
+  // the same handler may be found under several keys
+  std::sort(handlers.begin(), handlers.end());
+  handlers.erase(std::unique(handlers.begin(), handlers.end()), handlers.end());
+}
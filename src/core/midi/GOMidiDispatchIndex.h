@@ -0,0 +1,75 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOMIDIDISPATCHINDEX_H
+#define GOMIDIDISPATCHINDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "GOMidiEvent.h"
+
+/**
+ * Finds the handlers that may match a MIDI event without asking all of them.
+ *
+ * Each handler is added under the keys (device, event type, channel, key) of
+ * the events its receiver may match. The device, the channel and the key may
+ * be ANY. The index may return more handlers than really match, so the
+ * handlers still match the events themselves.
+ *
+ * The GrandOrgue setup sysex events change the receivers, so they are sent to
+ * all handlers.
+ */
+class GOMidiDispatchIndex {
+public:
+  static constexpr int ANY = -1;
+
+private:
+  // all handlers receive the broadcast events, even without any keys
+  unsigned m_NHandlers;
+  std::unordered_map<uint64_t, std::vector<unsigned>> m_Buckets;
+  // the handlers receiving all events
+  std::vector<unsigned> m_AllEvents;
+
+  static uint64_t makeKey(
+    unsigned device, GOMidiEvent::MidiType type, int channel, int key);
+
+  void FindInBucket(uint64_t key, std::vector<unsigned> &handlers) const;
+
+public:
+  GOMidiDispatchIndex() : m_NHandlers(0) {}
+
+  /* Removes all keys and sets the number of the handlers */
+  void Clear(unsigned nHandlers);
+
+  /**
+   * Adds the handler under a key
+   * @param handlerN the index of the handler
+   * @param device the device id or 0 for any device
+   * @param type the type of the events
+   * @param channel the channel or ANY
+   * @param key the key, the controller or the (N)RPN number or ANY
+   */
+  void Add(
+    unsigned handlerN,
+    unsigned device,
+    GOMidiEvent::MidiType type,
+    int channel,
+    int key);
+  /* Adds the handler that must receive all events */
+  void AddForAllEvents(unsigned handlerN);
+
+  /**
+   * Collects the handlers that may match the event
+   * @param e the event
+   * @param handlers receives the indices of the handlers in ascending order
+   */
+  void Find(const GOMidiEvent &e, std::vector<unsigned> &handlers) const;
+};
+
+#endif /* GOMIDIDISPATCHINDEX_H */
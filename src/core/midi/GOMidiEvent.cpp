@@ -12,6 +12,7 @@
 #include "GOMidiMap.h"
 #include "GORodgers.h"
 
+#include <algorithm>
 #include <cstring>
 
 GOMidiEvent::GOMidiEvent()
@@ -20,30 +21,27 @@ GOMidiEvent::GOMidiEvent()
     m_key(-1),
     m_value(-1),
     m_time(0),
-    m_string(),
-    m_data(),
+    m_StringLength(0),
+    m_DataLength(0),
     m_IsToUseNoteOff(true) {}
 
-GOMidiEvent::GOMidiEvent(const GOMidiEvent &e)
-  : m_MidiType(e.m_MidiType),
-    m_channel(e.m_channel),
-    m_key(e.m_key),
-    m_value(e.m_value),
-    m_device(e.m_device),
-    m_time(e.m_time),
-    m_string(e.m_string.Clone()),
-    m_data(e.m_data),
-    m_IsToUseNoteOff(e.m_IsToUseNoteOff) {}
-
 void GOMidiEvent::SetString(const wxString &str, unsigned length) {
-  unsigned len = str.length();
-  if (len < length) {
-    m_string = str;
-    m_string.Pad(length - len, wxT(' '), true);
-  } else if (len == length)
-    m_string = str;
-  else
-    m_string = str.Mid(0, length);
+  const unsigned len = std::min(length, MAX_STRING_LENGTH);
+  const unsigned strLen = std::min((unsigned)str.length(), len);
+
+  for (unsigned i = 0; i < strLen; i++) {
+    const wxUniChar c = str[i];
+
+    // the same replacement as wxString::ToAscii() does
+    m_string[i] = c.IsAscii() ? (char)c.GetValue() : '_';
+  }
+  std::fill(m_string + strLen, m_string + len, ' ');
+  m_StringLength = len;
+}
+
+void GOMidiEvent::SetData(const uint8_t *data, unsigned length) {
+  m_DataLength = std::min(length, MAX_DATA_LENGTH);
+  std::copy(data, data + m_DataLength, m_data);
 }
 
 void GOMidiEvent::FromMidi(
@@ -52,6 +50,8 @@ void GOMidiEvent::FromMidi(
   SetChannel(-1);
   SetKey(-1);
   SetValue(-1);
+  m_StringLength = 0;
+  m_DataLength = 0;
 
   if (!msg.size())
     return;
@@ -152,14 +152,10 @@ void GOMidiEvent::FromMidi(
         break;
       }
       if ((msg[4] & 0xF0) == 0x10) {
-        wxCharBuffer b(msg.size() - 7);
-        char *buf = b.data();
-        for (unsigned i = 0; i < msg.size() - 8; i++)
-          buf[i] = msg[7 + i];
-        buf[msg.size() - 8] = 0;
         SetChannel((msg[4] & 0x0F) + 1);
         SetValue(((msg[5] & 0x7F) << 7) | (msg[6] & 0x7F));
-        wxString s = wxString::FromAscii(b);
+        wxString s
+          = wxString::FromAscii((const char *)&msg[7], msg.size() - 8);
         SetKey(map.GetElementByString(s));
         SetMidiType(MIDI_SYSEX_GO_SETUP);
         break;
@@ -173,9 +169,7 @@ void GOMidiEvent::FromMidi(
       && msg[msg.size() - 1] == 0xf7) {
       SetChannel(msg[2]); /* device*/
       SetKey(msg[6]);
-      m_data.resize(msg.size() - 9);
-      for (unsigned i = 0; i < m_data.size(); i++)
-        m_data[i] = msg[7 + i];
+      SetData(&msg[7], msg.size() - 9);
       SetMidiType(MIDI_SYSEX_RODGERS_STOP_CHANGE);
       break;
     }
@@ -347,9 +341,7 @@ void GOMidiEvent::ToMidi(
     return;
 
   case MIDI_SYSEX_HW_STRING: {
-    const wxString &s = GetString();
-    wxCharBuffer b = s.ToAscii();
-    unsigned len = s.length();
+    unsigned len = m_StringLength;
     if (len > 16)
       len = 16;
     m.resize(21);
@@ -358,7 +350,7 @@ void GOMidiEvent::ToMidi(
     m[2] = 0x19;
     m[3] = (GetKey()) & 0x7F;
     for (unsigned i = 0; i < len; i++)
-      m[4 + i] = b[i] & 0x7F;
+      m[4 + i] = m_string[i] & 0x7F;
     for (unsigned i = len; i < 16; i++)
       m[4 + i] = ' ';
     m[20] = 0xF7;
@@ -367,9 +359,7 @@ void GOMidiEvent::ToMidi(
     return;
 
   case MIDI_SYSEX_HW_LCD: {
-    const wxString &s = GetString();
-    wxCharBuffer b = s.ToAscii();
-    unsigned len = s.length();
+    unsigned len = m_StringLength;
     if (len > 32)
       len = 32;
     m.resize(39);
@@ -380,7 +370,7 @@ void GOMidiEvent::ToMidi(
     m[4] = (GetKey()) & 0x7F;
     m[5] = (GetChannel()) & 0x7F;
     for (unsigned i = 0; i < len; i++)
-      m[6 + i] = b[i] & 0x7F;
+      m[6 + i] = m_string[i] & 0x7F;
     for (unsigned i = len; i < 32; i++)
       m[6 + i] = ' ';
     m[38] = 0xF7;
@@ -389,7 +379,7 @@ void GOMidiEvent::ToMidi(
     return;
 
   case MIDI_SYSEX_RODGERS_STOP_CHANGE: {
-    m.resize(7 + m_data.size() + 2);
+    m.resize(7 + m_DataLength + 2);
     m[0] = 0xf0;
     m[1] = 0x41;
     m[2] = GetChannel() & 0x7f; /* device */
@@ -397,10 +387,10 @@ void GOMidiEvent::ToMidi(
     m[4] = 0x12;
     m[5] = 0x01;
     m[6] = GetKey() & 0x7f;
-    for (unsigned i = 0; i < m_data.size(); i++)
+    for (unsigned i = 0; i < m_DataLength; i++)
       m[7 + i] = m_data[i];
-    m[7 + m_data.size() + 0] = GORodgersChecksum(m, 5, m_data.size() + 2);
-    m[7 + m_data.size() + 1] = 0xf7;
+    m[7 + m_DataLength + 0] = GORodgersChecksum(m, 5, m_DataLength + 2);
+    m[7 + m_DataLength + 1] = 0xf7;
     msg.push_back(m);
     return;
   }
@@ -522,7 +512,7 @@ wxString GOMidiEvent::ToString(GOMidiMap &map) const {
   case MIDI_SYSEX_RODGERS_STOP_CHANGE: {
     wxString data_string;
 
-    for (unsigned i = 0; i < m_data.size(); i++)
+    for (unsigned i = 0; i < m_DataLength; i++)
       data_string += wxString::Format(wxT(" %02x"), m_data[i]);
     return wxString::Format(
       _("sysex Rogers stop change device: %d offset: %d data %s"),
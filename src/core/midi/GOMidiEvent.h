@@ -25,8 +25,19 @@ class GOMidiMap;
 #define MIDI_CTRL_SOUNDS_OFF 120
 #define MIDI_CTRL_NOTES_OFF 123
 
+/**
+ * A MIDI event of a known type. It has a fixed size and does not allocate
+ * memory, so it is copied along the input path from the port callback to the
+ * matching without touching the heap. The string and the sysex payload are
+ * stored inside the event
+ */
 class GOMidiEvent {
 public:
+  // the longest string: a Hauptwerk LCD line
+  static constexpr unsigned MAX_STRING_LENGTH = 32;
+  // the longest sysex payload: 448 Rodgers stops from the offset
+  static constexpr unsigned MAX_DATA_LENGTH = 64;
+
   enum MidiType {
     MIDI_NONE,
     MIDI_RESET,
@@ -54,13 +65,15 @@ private:
   int m_channel, m_key, m_value;
   unsigned m_device;
   GOTime m_time;
-  wxString m_string;
-  std::vector<uint8_t> m_data;
+  uint8_t m_StringLength;
+  uint8_t m_DataLength;
   bool m_IsToUseNoteOff;
+  // ASCII only
+  char m_string[MAX_STRING_LENGTH];
+  uint8_t m_data[MAX_DATA_LENGTH];
 
 public:
   GOMidiEvent();
-  GOMidiEvent(const GOMidiEvent &e);
 
   MidiType GetMidiType() const { return m_MidiType; }
   void SetMidiType(MidiType t) { m_MidiType = t; }
@@ -81,12 +94,18 @@ public:
   GOTime GetTime() const { return m_time; }
   void SetTime(GOTime t) { m_time = t; }
 
-  const wxString &GetString() const { return m_string; }
-  void SetString(const wxString &str) { m_string = str; }
+  wxString GetString() const {
+    return wxString::FromAscii(m_string, m_StringLength);
+  }
+  /* Stores the first MAX_STRING_LENGTH characters of str */
+  void SetString(const wxString &str) { SetString(str, str.length()); }
+  /* Stores str truncated or padded with spaces to length characters */
   void SetString(const wxString &str, unsigned length);
 
-  const std::vector<uint8_t> &GetData() const { return m_data; }
-  void SetData(const std::vector<uint8_t> &data) { m_data = data; }
+  const uint8_t *GetData() const { return m_data; }
+  unsigned GetDataLength() const { return m_DataLength; }
+  /* Stores the first MAX_DATA_LENGTH bytes of data */
+  void SetData(const uint8_t *data, unsigned length);
 
   void FromMidi(const std::vector<unsigned char> &msg, GOMidiMap &map);
   void ToMidi(
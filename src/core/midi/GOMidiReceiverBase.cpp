@@ -7,6 +7,7 @@
 
 #include "GOMidiReceiverBase.h"
 
+#include "GOMidiDispatchIndex.h"
 #include "GOMidiEvent.h"
 #include "GOMidiMap.h"
 #include "GOMidiReceiverMessageType.h"
@@ -20,8 +21,19 @@ GOMidiReceiverBase::GOMidiReceiverBase(GOMidiReceiverType type)
     m_last(),
     m_Internal() {}
 
+std::atomic_uint GOMidiReceiverBase::s_ConfigGeneration(0);
+
 void GOMidiReceiverBase::SetElementID(int id) { m_ElementID = id; }
 
+bool GOMidiReceiverBase::RenewFrom(
+  const GOMidiReceiverEventPatternList &newList) {
+  const bool isChanged = GOMidiReceiverEventPatternList::RenewFrom(newList);
+
+  if (isChanged)
+    s_ConfigGeneration.fetch_add(1);
+  return isChanged;
+}
+
 const struct IniFileEnumEntry GOMidiReceiverBase::m_MidiTypes[] = {
   {wxT("ControlChange"), MIDI_M_CTRL_CHANGE},
   {wxT("Note"), MIDI_M_NOTE},
@@ -183,6 +195,7 @@ void GOMidiReceiverBase::Load(
     m_events.resize(0);
     Preconfigure(cfg, group);
   }
+  s_ConfigGeneration.fetch_add(1);
 }
 
 void GOMidiReceiverBase::Preconfigure(GOConfigReader &cfg, wxString group) {}
@@ -247,7 +260,7 @@ void GOMidiReceiverBase::Save(
   }
 }
 
-bool GOMidiReceiverBase::HasChannel(GOMidiReceiverMessageType type) {
+bool GOMidiReceiverBase::HasChannel(GOMidiReceiverMessageType type) const {
   if (
     type == MIDI_M_NOTE || type == MIDI_M_CTRL_CHANGE
     || type == MIDI_M_PGM_CHANGE || type == MIDI_M_PGM_RANGE
@@ -441,6 +454,7 @@ void GOMidiReceiverBase::deleteInternal(unsigned device) {
     if (m_Internal[i].device == device) {
       m_Internal[i] = m_Internal[m_Internal.size() - 1];
       m_Internal.resize(m_Internal.size() - 1);
+      s_ConfigGeneration.fetch_add(1);
       break;
     }
 }
@@ -451,6 +465,7 @@ unsigned GOMidiReceiverBase::createInternal(unsigned device) {
   if (pos >= m_Internal.size()) {
     m_Internal.resize(m_Internal.size() + 1);
     m_Internal[pos].device = device;
+    s_ConfigGeneration.fetch_add(1);
   }
   return pos;
 }
@@ -877,7 +892,8 @@ GOMidiMatchType GOMidiReceiverBase::Match(
       eMidiType == GOMidiEvent::MIDI_SYSEX_RODGERS_STOP_CHANGE
       && pattern.type == MIDI_M_SYSEX_RODGERS_STOP_CHANGE
       && pattern.key == e.GetChannel()) {
-      switch (GORodgersGetBit(pattern.low_value, e.GetKey(), e.GetData())) {
+      switch (GORodgersGetBit(
+        pattern.low_value, e.GetKey(), e.GetData(), e.GetDataLength())) {
       case MIDI_BIT_STATE::MIDI_BIT_CLEAR:
         return MIDI_MATCH_OFF;
 
@@ -911,4 +927,168 @@ GOMidiMatchType GOMidiReceiverBase::Match(
   return MIDI_MATCH_NONE;
 }
 
-void GOMidiReceiverBase::PreparePlayback() { m_Internal.resize(0); }
+void GOMidiReceiverBase::PreparePlayback() {
+  if (!m_Internal.empty()) {
+    m_Internal.resize(0);
+    s_ConfigGeneration.fetch_add(1);
+  }
+}
+
+void GOMidiReceiverBase::AddToDispatchIndex(
+  GOMidiDispatchIndex &index, unsigned handlerN) const {
+  // the setup received from the device may match many events of it
+  if (!m_Internal.empty()) {
+    index.AddForAllEvents(handlerN);
+    return;
+  }
+  for (const auto &pattern : m_events) {
+    const GOMidiReceiverMessageType type = pattern.type;
+    const unsigned device = pattern.deviceId;
+    const int channel
+      = HasChannel(type) ? pattern.channel : GOMidiDispatchIndex::ANY;
+    const int key = pattern.key;
+    const int anyKey = GOMidiDispatchIndex::ANY;
+
+    if (type == MIDI_M_NONE)
+      continue;
+    if (m_type == MIDI_RECV_MANUAL) {
+      if (
+        type == MIDI_M_NOTE || type == MIDI_M_NOTE_NO_VELOCITY
+        || type == MIDI_M_NOTE_SHORT_OCTAVE || type == MIDI_M_NOTE_NORMAL) {
+        index.Add(handlerN, device, GOMidiEvent::MIDI_NOTE, channel, anyKey);
+        index.Add(
+          handlerN, device, GOMidiEvent::MIDI_AFTERTOUCH, channel, anyKey);
+        index.Add(
+          handlerN,
+          device,
+          GOMidiEvent::MIDI_CTRL_CHANGE,
+          channel,
+          MIDI_CTRL_NOTES_OFF);
+        index.Add(
+          handlerN,
+          device,
+          GOMidiEvent::MIDI_CTRL_CHANGE,
+          channel,
+          MIDI_CTRL_SOUNDS_OFF);
+      }
+      continue;
+    }
+    if (m_type == MIDI_RECV_ENCLOSURE) {
+      if (type == MIDI_M_CTRL_CHANGE)
+        index.Add(
+          handlerN, device, GOMidiEvent::MIDI_CTRL_CHANGE, channel, key);
+      else if (type == MIDI_M_RPN)
+        index.Add(handlerN, device, GOMidiEvent::MIDI_RPN, channel, key);
+      else if (type == MIDI_M_NRPN)
+        index.Add(handlerN, device, GOMidiEvent::MIDI_NRPN, channel, key);
+      else if (type == MIDI_M_PGM_RANGE)
+        index.Add(
+          handlerN, device, GOMidiEvent::MIDI_PGM_CHANGE, channel, anyKey);
+      continue;
+    }
+    switch (type) {
+    case MIDI_M_NOTE:
+    case MIDI_M_NOTE_ON:
+    case MIDI_M_NOTE_OFF:
+    case MIDI_M_NOTE_ON_OFF:
+    case MIDI_M_NOTE_FIXED_ON:
+    case MIDI_M_NOTE_FIXED_OFF:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_NOTE, channel, key);
+      break;
+
+    case MIDI_M_CTRL_CHANGE:
+    case MIDI_M_CTRL_CHANGE_ON:
+    case MIDI_M_CTRL_CHANGE_OFF:
+    case MIDI_M_CTRL_CHANGE_ON_OFF:
+    case MIDI_M_CTRL_CHANGE_FIXED:
+    case MIDI_M_CTRL_CHANGE_FIXED_ON:
+    case MIDI_M_CTRL_CHANGE_FIXED_OFF:
+    case MIDI_M_CTRL_CHANGE_FIXED_ON_OFF:
+    case MIDI_M_CTRL_BIT:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_CTRL_CHANGE, channel, key);
+      break;
+
+    case MIDI_M_RPN:
+    case MIDI_M_RPN_ON:
+    case MIDI_M_RPN_OFF:
+    case MIDI_M_RPN_ON_OFF:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_RPN, channel, key);
+      break;
+
+    case MIDI_M_NRPN:
+    case MIDI_M_NRPN_ON:
+    case MIDI_M_NRPN_OFF:
+    case MIDI_M_NRPN_ON_OFF:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_NRPN, channel, key);
+      break;
+
+    // the range patterns match the event key with the values
+    case MIDI_M_RPN_RANGE:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_RPN, channel, anyKey);
+      break;
+
+    case MIDI_M_NRPN_RANGE:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_NRPN, channel, anyKey);
+      break;
+
+    case MIDI_M_PGM_CHANGE:
+      index.Add(handlerN, device, GOMidiEvent::MIDI_PGM_CHANGE, channel, key);
+      break;
+
+    case MIDI_M_PGM_RANGE:
+      index.Add(
+        handlerN, device, GOMidiEvent::MIDI_PGM_CHANGE, channel, anyKey);
+      break;
+
+    // the sysex events are few, so they are not split by the key
+    case MIDI_M_SYSEX_JOHANNUS_ANTONIJN:
+      index.Add(
+        handlerN,
+        device,
+        GOMidiEvent::MIDI_SYSEX_JOHANNUS_ANTONIJN,
+        channel,
+        anyKey);
+      break;
+
+    case MIDI_M_SYSEX_JOHANNUS_9:
+      index.Add(
+        handlerN, device, GOMidiEvent::MIDI_SYSEX_JOHANNUS_9, channel, anyKey);
+      break;
+
+    case MIDI_M_SYSEX_JOHANNUS_11:
+      index.Add(
+        handlerN, device, GOMidiEvent::MIDI_SYSEX_JOHANNUS_11, channel, anyKey);
+      break;
+
+    case MIDI_M_SYSEX_VISCOUNT:
+    case MIDI_M_SYSEX_VISCOUNT_TOGGLE:
+      index.Add(
+        handlerN, device, GOMidiEvent::MIDI_SYSEX_VISCOUNT, channel, anyKey);
+      break;
+
+    case MIDI_M_SYSEX_RODGERS_STOP_CHANGE:
+      index.Add(
+        handlerN,
+        device,
+        GOMidiEvent::MIDI_SYSEX_RODGERS_STOP_CHANGE,
+        channel,
+        anyKey);
+      break;
+
+    case MIDI_M_SYSEX_AHLBORN_GALANTI:
+    case MIDI_M_SYSEX_AHLBORN_GALANTI_TOGGLE:
+      index.Add(
+        handlerN,
+        device,
+        GOMidiEvent::MIDI_SYSEX_AHLBORN_GALANTI,
+        channel,
+        anyKey);
+      break;
+
+    default:
+      // not matched by this kind of receiver, but keep it safe
+      index.AddForAllEvents(handlerN);
+      break;
+    }
+  }
+}
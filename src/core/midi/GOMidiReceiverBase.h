@@ -8,12 +8,15 @@
 #ifndef GOMIDIRECEIVERBASE_H
 #define GOMIDIRECEIVERBASE_H
 
+#include <atomic>
+
 #include "GOMidiMatchType.h"
 #include "GOMidiReceiverEventPatternList.h"
 #include "GOTime.h"
 
 class GOConfigReader;
 class GOConfigWriter;
+class GOMidiDispatchIndex;
 class GOMidiEvent;
 class GOMidiMap;
 struct IniFileEnumEntry;
@@ -27,6 +30,9 @@ private:
   } midi_internal_match;
 
   static const struct IniFileEnumEntry m_MidiTypes[];
+  // changed when any receiver changes the events it may match
+  static std::atomic_uint s_ConfigGeneration;
+
   int m_ElementID;
   std::vector<GOTime> m_last;
   std::vector<midi_internal_match> m_Internal;
@@ -49,13 +55,29 @@ public:
 
   void SetElementID(int id);
 
+  /* Assigns the new event list. Returns whether it is changed */
+  bool RenewFrom(const GOMidiReceiverEventPatternList &newList);
+
+  /**
+   * Returns a number that changes when the events that any receiver may match
+   * change, so GOMidiDispatchIndex has to be rebuilt
+   */
+  static unsigned GetConfigGeneration() { return s_ConfigGeneration.load(); }
+
+  /**
+   * Adds the keys of the events this receiver may match to the index
+   * @param index the index to fill
+   * @param handlerN the index of the handler that calls Match
+   */
+  void AddToDispatchIndex(GOMidiDispatchIndex &index, unsigned handlerN) const;
+
   GOMidiMatchType Match(const GOMidiEvent &e);
   GOMidiMatchType Match(const GOMidiEvent &e, int &value);
   GOMidiMatchType Match(
     const GOMidiEvent &e, const unsigned midi_map[128], int &key, int &value);
 
   bool HasDebounce(GOMidiReceiverMessageType type);
-  bool HasChannel(GOMidiReceiverMessageType type);
+  bool HasChannel(GOMidiReceiverMessageType type) const;
   bool HasKey(GOMidiReceiverMessageType type);
   bool HasLowKey(GOMidiReceiverMessageType type);
   bool HasHighKey(GOMidiReceiverMessageType type);
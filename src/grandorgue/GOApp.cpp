@@ -15,6 +15,7 @@
 #include <wx/stopwatch.h>
 
 #include "config/GOConfig.h"
+#include "document-base/GOView.h"
 #include "sound/GOSound.h"
 
 #include "GOFrame.h"
@@ -217,4 +218,34 @@ void GOApp::CleanUp() {
   }
 }
 
+void GOApp::CallEventHandler(
+  wxEvtHandler *handler, wxEventFunctor &functor, wxEvent &event) const {
+  const wxEventType eventType = event.GetEventType();
+  std::recursive_mutex *pMutex = nullptr;
+
+  // Painting only reads the organ state, so it does not delay the MIDI input
+  if (
+    eventType != wxEVT_PAINT && eventType != wxEVT_ERASE_BACKGROUND
+    && eventType != wxEVT_IDLE && eventType != wxEVT_UPDATE_UI) {
+    wxWindow *pWnd = wxDynamicCast(handler, wxWindow);
+
+    // look for the organ window containing the handler
+    while (pWnd && !pMutex) {
+      const GOView *pView = dynamic_cast<const GOView *>(pWnd);
+
+      if (pView)
+        pMutex = pView->GetInputMutex();
+      pWnd = pWnd->IsTopLevel() ? nullptr : pWnd->GetParent();
+    }
+  }
+  if (pMutex) {
+    // the organ windows change the organ model and the MIDI receivers that
+    // the MIDI dispatch thread uses
+    std::lock_guard<std::recursive_mutex> locker(*pMutex);
+
+    wxApp::CallEventHandler(handler, functor, event);
+  } else
+    wxApp::CallEventHandler(handler, functor, event);
+}
+
 void GOApp::SetRestart() { m_Restart = true; }
\ No newline at end of file
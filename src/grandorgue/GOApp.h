@@ -42,6 +42,10 @@ private:
   int OnRun() override;
   int OnExit() override;
   virtual void CleanUp() override;
+  void CallEventHandler(
+    wxEvtHandler *handler,
+    wxEventFunctor &functor,
+    wxEvent &event) const override;
 
 protected:
   GOFrame *m_Frame;
@@ -131,7 +131,8 @@ void GOAudioRecorder::StopRecording() {
     GOAskRenameFile(
       m_Filename,
       m_OrganController->GetSettings().AudioRecorderPath(),
-      _("WAV files (*.wav)|*.wav"));
+      m_recorder->IsCompressed() ? _("WavPack files (*.wv)|*.wv")
+                                 : _("WAV files (*.wav)|*.wav"));
   UpdateDisplay();
 }
 
@@ -142,7 +143,8 @@ void GOAudioRecorder::StartRecording(bool rename) {
 
   m_Filename = m_OrganController->GetSettings().AudioRecorderPath()
     + wxFileName::GetPathSeparator()
-    + wxDateTime::UNow().Format(_("%Y-%m-%d-%H-%M-%S.%l.wav"));
+    + wxDateTime::UNow().Format(_("%Y-%m-%d-%H-%M-%S.%l."))
+    + m_recorder->GetFileExtension();
   m_DoRename = rename;
 
   m_recorder->Open(m_Filename);
@@ -8,6 +8,7 @@
 #include "GODocument.h"
 
 #include <wx/app.h>
+#include <wx/thread.h>
 
 #include "config/GOConfig.h"
 #include "dialogs/GOMidiListDialog.h"
@@ -33,7 +34,8 @@ GODocument::GODocument(GOResizable *pMainWindow, GOSound *sound)
     m_sound(*sound),
     m_OrganFileReady(false),
     m_OrganController(NULL),
-    m_listener() {
+    // the organ is played from the MIDI dispatch thread
+    m_listener(true) {
   m_listener.Register(&m_sound.GetMidi());
 }
 
@@ -42,6 +44,10 @@ GODocument::~GODocument() {
   CloseOrgan();
 }
 
+std::recursive_mutex *GODocument::GetInputMutex() {
+  return m_OrganController ? &m_OrganController->GetInputMutex() : nullptr;
+}
+
 bool GODocument::IsModified() const {
   return m_OrganController && m_OrganController->IsOrganModified();
 }
@@ -158,9 +164,7 @@ void GODocument::CloseOrgan() {
   wxTheApp->GetTopWindow()->GetEventHandler()->AddPendingEvent(event);
 }
 
-void GODocument::OnMidiEvent(const GOMidiEvent &event) {
-  GOMutexLocker locker(m_lock);
-
+void GODocument::SendMidiToOrgan(const GOMidiEvent &event) {
   if (!m_OrganFileReady)
     return;
 
@@ -168,6 +172,19 @@ void GODocument::OnMidiEvent(const GOMidiEvent &event) {
     m_OrganController->ProcessMidi(event);
 }
 
+void GODocument::OnMidiEvent(const GOMidiEvent &event) {
+  if (wxIsMainThread())
+    // the organ is closed in this thread only. m_lock is not taken because the
+    // dispatch thread may hold it while waiting for the organ input mutex that
+    // a GUI handler holds
+    SendMidiToOrgan(event);
+  else {
+    GOMutexLocker locker(m_lock);
+
+    SendMidiToOrgan(event);
+  }
+}
+
 void GODocument::ShowOrganSettingsDialog() {
   if (!showWindow(GODocument::ORGAN_DIALOG, NULL) && m_OrganController) {
     registerWindow(
@@ -39,6 +39,7 @@ private:
 
   GOMidiListener m_listener;
 
+  void SendMidiToOrgan(const GOMidiEvent &event);
   void OnMidiEvent(const GOMidiEvent &event) override;
 
   void SyncState();
@@ -49,6 +50,7 @@ public:
   ~GODocument();
 
   GOOrganController *GetOrganController() const { return m_OrganController; }
+  std::recursive_mutex *GetInputMutex() override;
   bool IsModified() const;
 
   void ShowPanel(unsigned id);
@@ -89,6 +89,7 @@ EVT_MENU(ID_MIDI_MONITOR, GOFrame::OnMidiMonitor)
 EVT_MENU(ID_AUDIO_PANIC, GOFrame::OnAudioPanic)
 EVT_MENU(ID_AUDIO_MEMSET, GOFrame::OnAudioMemset)
 EVT_MENU(ID_AUDIO_STATE, GOFrame::OnAudioState)
+EVT_MENU(ID_AUDIO_STATISTICS, GOFrame::OnAudioStatistics)
 EVT_MENU(ID_SETTINGS, GOFrame::OnSettings)
 EVT_MENU(ID_MIDI_LOAD, GOFrame::OnMidiLoad)
 EVT_MENU(wxID_HELP, GOFrame::OnHelp)
@@ -244,6 +245,11 @@ GOFrame::GOFrame(
   m_audio_menu->AppendSeparator();
   m_audio_menu->Append(
     ID_AUDIO_STATE, _("&Sound Output State"), wxEmptyString, wxITEM_NORMAL);
+  m_audio_menu->Append(
+    ID_AUDIO_STATISTICS,
+    _("Save Sound &Statistics..."),
+    wxEmptyString,
+    wxITEM_NORMAL);
   m_audio_menu->AppendSeparator();
   m_audio_menu->Append(
     ID_AUDIO_PANIC, _("&Panic\tEscape"), wxEmptyString, wxITEM_NORMAL);
@@ -492,8 +498,12 @@ void GOFrame::UpdateReleaseLength(unsigned releaseLength) {
   GOOrganController *organController = GetOrganController();
   int releaseLengthIndex = releaseLength / 50;
 
-  if (organController && organController->GetReleaseTail() != releaseLength)
+  if (organController && organController->GetReleaseTail() != releaseLength) {
+    std::lock_guard<std::recursive_mutex> locker(
+      organController->GetInputMutex());
+
     organController->SetReleaseTail(releaseLength);
+  }
   if (m_ReleaseLength->GetSelection() != releaseLengthIndex)
     m_ReleaseLength->SetSelection(releaseLengthIndex);
 }
@@ -929,8 +939,12 @@ void GOFrame::OnImportCombinations(wxCommandEvent &event) {
       _("Combinations files (*.yaml)|*.yaml|Settings files (*.cmb)|*.cmb"),
       wxFD_OPEN | wxFD_FILE_MUST_EXIST);
 
-    if (dlg.ShowModal() == wxID_OK)
+    if (dlg.ShowModal() == wxID_OK) {
+      std::lock_guard<std::recursive_mutex> locker(
+        pOrganController->GetInputMutex());
+
       pOrganController->LoadCombination(dlg.GetPath());
+    }
   }
 }
 
@@ -1150,16 +1164,24 @@ void GOFrame::OnMidiLoad(wxCommandEvent &WXUNUSED(event)) {
   if (dlg.ShowModal() == wxID_OK) {
     GOOrganController *organController = GetOrganController();
 
-    if (organController)
+    if (organController) {
+      std::lock_guard<std::recursive_mutex> locker(
+        organController->GetInputMutex());
+
       organController->LoadMIDIFile(dlg.GetPath());
+    }
   }
 }
 
 void GOFrame::OnAudioMemset(wxCommandEvent &WXUNUSED(event)) {
   GOOrganController *organController = GetOrganController();
 
-  if (organController)
+  if (organController) {
+    std::lock_guard<std::recursive_mutex> locker(
+      organController->GetInputMutex());
+
     organController->GetSetter()->ToggleSetter();
+  }
 }
 
 void GOFrame::SetEventAfterSettings(
@@ -1239,6 +1261,19 @@ void GOFrame::OnAudioState(wxCommandEvent &WXUNUSED(event)) {
   GOMessageBox(m_Sound.getState(), _("Sound output"), wxOK, this);
 }
 
+void GOFrame::OnAudioStatistics(wxCommandEvent &WXUNUSED(event)) {
+  wxFileDialog dlg(
+    this,
+    _("Save Sound Statistics"),
+    m_config.ExportImportPath(),
+    wxT("sound-statistics.txt"),
+    _("Text files (*.txt)|*.txt"),
+    wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+  if (dlg.ShowModal() == wxID_OK)
+    m_Sound.GetEngine().GetTelemetry().Dump(dlg.GetPath());
+}
+
 void GOFrame::OnOrganSettings(wxCommandEvent &event) {
   if (m_doc)
     m_doc->ShowOrganSettingsDialog();
@@ -1278,16 +1313,24 @@ void GOFrame::OnSettingsMemoryEnter(wxCommandEvent &event) {
   long n = m_SetterPosition->GetValue();
   GOOrganController *organController = GetOrganController();
 
-  if (organController)
+  if (organController) {
+    std::lock_guard<std::recursive_mutex> locker(
+      organController->GetInputMutex());
+
     organController->GetSetter()->SetPosition(n);
+  }
 }
 
 void GOFrame::OnSettingsMemory(wxCommandEvent &event) {
   long n = m_SetterPosition->GetValue();
   GOOrganController *organController = GetOrganController();
 
-  if (organController)
+  if (organController) {
+    std::lock_guard<std::recursive_mutex> locker(
+      organController->GetInputMutex());
+
     organController->GetSetter()->UpdatePosition(n);
+  }
 }
 
 void GOFrame::OnSettingsTranspose(wxCommandEvent &event) {
@@ -1297,6 +1340,10 @@ void GOFrame::OnSettingsTranspose(wxCommandEvent &event) {
     long n = m_Transpose->GetValue();
 
     m_config.Transpose(n);
+
+    std::lock_guard<std::recursive_mutex> locker(
+      organController->GetInputMutex());
+
     organController->GetSetter()->SetTranspose(n);
   }
 }
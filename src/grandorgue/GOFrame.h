@@ -128,6 +128,7 @@ private:
   void OnAudioPanic(wxCommandEvent &event);
   void OnAudioMemset(wxCommandEvent &event);
   void OnAudioState(wxCommandEvent &event);
+  void OnAudioStatistics(wxCommandEvent &event);
 
   void SetEventAfterSettings(
     wxEventType eventType, int eventId, GOOrgan *pOrganFile = NULL);
@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <math.h>
+#include <string>
+#include <unordered_map>
 #include <wx/datetime.h>
 #include <wx/filename.h>
 #include <wx/log.h>
@@ -45,6 +47,7 @@
 #include "gui/GOGUIPanelCreator.h"
 #include "gui/GOGUIRecorderPanel.h"
 #include "gui/GOGUISequencerPanel.h"
+#include "loader/GOLoadPlanner.h"
 #include "loader/GOLoadThread.h"
 #include "loader/GOLoaderFilename.h"
 #include "loader/cache/GOCache.h"
@@ -127,13 +130,15 @@ GOOrganController::GOOrganController(
     m_MainWindowData(this, wxT("MainWindow")) {
   if (isAppInitialized) {
     // Load here objects that needs App (wx) to be loaded
-    m_timer = new GOTimer();
+    // the timer callbacks change the organ like the MIDI input does
+    m_timer = new GOTimer(m_InputMutex);
     m_bitmaps = new GOBitmapCache(this);
   }
   GOOrganModel::SetMidiDialogCreator(pMidiDialogCreator);
   GOOrganModel::SetModelModificationListener(this);
   m_setter = new GOSetter(this);
   m_pool.SetMemoryLimit(m_config.MemoryLimit() * 1024 * 1024);
+  m_pool.SetStreaming(m_config.StreamSamples());
 }
 
 GOOrganController::~GOOrganController() {
@@ -192,7 +197,7 @@ bool GOOrganController::IsCacheable() { return m_Cacheable; }
 GOHashType GOOrganController::GenerateCacheHash() {
   GOHash hash;
 
-  UpdateHash(hash);
+  // the settings of the objects are hashed separately by MatchCacheObjects
   hash.Update(sizeof(GOSoundAudioSection));
   hash.Update(sizeof(GOSoundingPipe));
   hash.Update(sizeof(GOSoundReleaseAlignTable));
@@ -205,6 +210,46 @@ GOHashType GOOrganController::GenerateCacheHash() {
   return hash.getHash();
 }
 
+static GOHashType generate_object_hash(
+  const GOFileStore &fileStore, const GOCacheObject *obj) {
+  GOHash hash;
+
+  obj->UpdateHash(fileStore, hash);
+  return hash.getHash();
+}
+
+static std::string hash_key(const GOHashType &hash) {
+  return std::string((const char *)hash.hash, sizeof(hash.hash));
+}
+
+unsigned GOOrganController::MatchCacheObjects(
+  const std::vector<GOCacheIndexEntry> &cacheIndex,
+  std::vector<uint64_t> &cacheOffsets,
+  std::vector<GOHashType> &hashes) {
+  const std::vector<GOCacheObject *> &objects = GetCacheObjects();
+  // the objects with equal hashes have equal cached data
+  std::unordered_map<std::string, uint64_t> cachedOffsets;
+  unsigned nStale = 0;
+
+  for (const GOCacheIndexEntry &entry : cacheIndex)
+    cachedOffsets[hash_key(entry.m_Hash)] = entry.m_Offset;
+  cacheOffsets.resize(objects.size());
+  hashes.resize(objects.size());
+  for (unsigned i = 0; i < objects.size(); i++) {
+    hashes[i] = generate_object_hash(m_FileStore, objects[i]);
+
+    auto found = cachedOffsets.find(hash_key(hashes[i]));
+
+    if (found != cachedOffsets.end())
+      cacheOffsets[i] = found->second;
+    else {
+      cacheOffsets[i] = GOLoadWorker::NOT_CACHED;
+      nStale++;
+    }
+  }
+  return nStale;
+}
+
 void GOOrganController::ReadOrganFile(GOConfigReader &cfg) {
   /* load church info */
   cfg.ReadString(
@@ -509,14 +554,17 @@ wxString GOOrganController::Load(
 
       dlg->Reset(objectDistributor.GetNObjects());
 
-      GOCacheObject *obj = nullptr;
+      // whether the objects have been loaded using the cache
+      bool areLoadedWithCache = false;
+      bool toUpdateCache = false;
 
       /* Load pipes */
       if (wxFileExists(m_CacheFilename)) {
         wxFile cache_file(m_CacheFilename);
         GOCache reader(cache_file, m_pool);
-        cache_ok = cache_file.IsOpened();
+        std::vector<GOCacheIndexEntry> cacheIndex;
 
+        cache_ok = cache_file.IsOpened();
         if (cache_ok) {
           GOHashType hash1, hash2;
           if (!reader.ReadHeader()) {
@@ -532,24 +580,35 @@ wxString GOOrganController::Load(
             wxLogWarning(_("Cache file had diffent hash bypassing cache."));
           }
         }
-
-        GOCacheObject *obj = nullptr;
+        if (cache_ok && !reader.ReadIndex(cacheIndex)) {
+          cache_ok = false;
+          reader.FreeCacheFile();
+          wxLogWarning(_("Cache file had no valid index bypassing cache."));
+        }
 
         if (cache_ok) {
-          while ((obj = objectDistributor.FetchNext())) {
-            if (!obj->LoadFromCacheWithoutExc(m_pool, reader)) {
-              wxLogWarning(_("Cache load failure: %s"), obj->GetLoadError());
-              break;
-            }
-            if (!dlg->Update(objectDistributor.GetPos(), obj->GetLoadTitle()))
-              throw GOLoadAborted(); // Skip the rest of the loading code
-          }
-          if (!obj)
+          std::vector<uint64_t> cacheOffsets;
+          std::vector<GOHashType> hashes;
+          // the stale objects are loaded from their files
+          const unsigned nStale
+            = MatchCacheObjects(cacheIndex, cacheOffsets, hashes);
+          // the objects failed to be restored are loaded from their files too
+          bool wereCacheFailures = false;
+
+          if (
+            LoadObjects(
+              dlg, objectDistributor, &reader, &cacheOffsets, wereCacheFailures)
+            && objectDistributor.IsComplete())
             m_Cacheable = true;
-          else
-            // obj points to an object with a load error. We will try to load
-            // it from the file later
-            cache_ok = false;
+          areLoadedWithCache = true;
+          cache_ok = !nStale && !wereCacheFailures;
+          // a few stale objects are appended to the cache. A broken cache or
+          // one with many stale objects is rewritten
+          if (!cache_ok && m_Cacheable && m_config.ManageCache())
+            toUpdateCache = wereCacheFailures
+              || nStale * 2 > objectDistributor.GetNObjects()
+              || reader.IsCompressed() != m_config.CompressCache()
+              || !AppendCache(dlg, reader, cacheOffsets, hashes);
         }
 
         if (!cache_ok && !m_config.ManageCache())
@@ -559,50 +618,20 @@ wxString GOOrganController::Load(
         reader.Close();
       }
 
-      if (!cache_ok) {
-        GOLoadWorker thisWorker(m_FileStore, m_pool, objectDistributor);
-        ptr_vector<GOLoadThread> threads;
-
-        // Create and run additional worker threads
-        for (unsigned i = 0; i < m_config.LoadConcurrency(); i++)
-          threads.push_back(
-            new GOLoadThread(m_FileStore, m_pool, objectDistributor));
-        for (unsigned i = 0; i < threads.size(); i++)
-          threads[i]->Run();
-
-        // try to load the object that we could not load from cache
-        if (obj)
-          thisWorker.LoadObjectNoExc(obj);
-
-        while (thisWorker.LoadNextObject(obj))
-          // show the progress and process possible Cancel
-          if (!dlg->Update(objectDistributor.GetPos(), obj->GetLoadTitle()))
-            throw GOLoadAborted(); // skip the rest of loading code
-        // rethrow exception if any occured in thisWorker.LoadNextObject
-        bool wereExceptions = thisWorker.WereExceptions();
-
-        for (unsigned i = 0; i < threads.size(); i++)
-          wereExceptions |= threads[i]->CheckExceptions();
-        if (wereExceptions) {
-          for (auto obj : GetCacheObjects()) {
-            if (!obj->IsReady())
-              wxLogError(obj->GetLoadError());
-          }
-          GOMessageBox(
-            _("There are errors while loading the organ. See Log Messages."),
-            _("Load error"),
-            wxOK | wxICON_ERROR,
-            NULL);
-        } else {
-          if (objectDistributor.IsComplete())
-            m_Cacheable = true;
-          if (m_config.ManageCache() && m_Cacheable)
-            UpdateCache(dlg, m_config.CompressCache());
-        }
+      if (!areLoadedWithCache) {
+        bool wereCacheFailures;
 
-        // Despite a possible exception automatic calling ~GOLoadThread from
-        // ~ptr_vector stops all additional worker threads
+        if (
+          LoadObjects(
+            dlg, objectDistributor, nullptr, nullptr, wereCacheFailures)
+          && objectDistributor.IsComplete()) {
+          m_Cacheable = true;
+          toUpdateCache = m_config.ManageCache();
+        }
       }
+      // the cache file has been closed, so it may be replaced
+      if (toUpdateCache)
+        UpdateCache(dlg, m_config.CompressCache());
     } catch (const GOOutOfMemory &e) {
       GOMessageBox(
         _("Out of memory - only parts of the organ are loaded. Please "
@@ -808,6 +837,83 @@ void GOOrganController::LoadCombination(const wxString &file) {
   }
 }
 
+bool GOOrganController::LoadObjects(
+  GOProgressDialog *dlg,
+  GOCacheObjectDistributor &distributor,
+  GOCache *pCache,
+  const std::vector<uint64_t> *pCacheOffsets,
+  bool &wereCacheFailures) {
+  // the objects are fetched in the order of their location on the disk
+  GOLoadPlanner planner(
+    GetCacheObjects(),
+    m_FileStore,
+    pCacheOffsets,
+    m_config.LoadConcurrency() + 1);
+
+  distributor.SetOrder(&planner.GetOrder());
+
+  GOLoadWorker thisWorker(
+    m_FileStore, m_pool, distributor, pCache, pCacheOffsets, &planner);
+  // each additional thread reads the cache with its own reader
+  ptr_vector<wxFile> cacheFiles;
+  ptr_vector<GOCache> cacheReaders;
+  ptr_vector<GOLoadThread> threads;
+
+  // Create and run additional worker threads
+  for (unsigned i = 0; i < m_config.LoadConcurrency(); i++) {
+    GOCache *pThreadCache = nullptr;
+
+    if (pCache) {
+      wxFile *pFile = new wxFile(m_CacheFilename);
+
+      cacheFiles.push_back(pFile);
+      if (!pFile->IsOpened())
+        break;
+      pThreadCache = new GOCache(*pFile, m_pool, pCache->IsMapable());
+      cacheReaders.push_back(pThreadCache);
+    }
+    threads.push_back(new GOLoadThread(
+      m_FileStore,
+      m_pool,
+      distributor,
+      pThreadCache,
+      pCacheOffsets,
+      &planner));
+  }
+  for (unsigned i = 0; i < threads.size(); i++)
+    threads[i]->Run();
+
+  GOCacheObject *obj = nullptr;
+
+  while (thisWorker.LoadNextObject(obj))
+    // show the progress and process possible Cancel
+    if (!dlg->Update(distributor.GetPos(), obj->GetLoadTitle()))
+      throw GOLoadAborted(); // skip the rest of loading code
+  // rethrow exception if any occured in thisWorker.LoadNextObject
+  bool wereExceptions = thisWorker.WereExceptions();
+
+  wereCacheFailures = thisWorker.WereCacheFailures();
+  for (unsigned i = 0; i < threads.size(); i++) {
+    wereExceptions |= threads[i]->CheckExceptions();
+    wereCacheFailures |= threads[i]->WereCacheFailures();
+  }
+  if (wereExceptions) {
+    for (auto obj : GetCacheObjects()) {
+      if (!obj->IsReady())
+        wxLogError(obj->GetLoadError());
+    }
+    GOMessageBox(
+      _("There are errors while loading the organ. See Log Messages."),
+      _("Load error"),
+      wxOK | wxICON_ERROR,
+      NULL);
+  }
+  // Despite a possible exception automatic calling ~GOLoadThread from
+  // ~ptr_vector stops all additional worker threads before the readers are
+  // destroyed
+  return !wereExceptions;
+}
+
 bool GOOrganController::CachePresent() { return wxFileExists(m_CacheFilename); }
 
 bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
@@ -819,7 +925,8 @@ bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
   dlg->Setup(objectDistributor.GetNObjects(), _("Creating sample cache"));
 
   wxFileOutputStream file(m_CacheFilename);
-  GOCacheWriter writer(file, compress);
+  // the frames of a compressed cache are compressed by the loading threads
+  GOCacheWriter writer(file, compress, m_config.LoadConcurrency() + 1);
 
   /* Save pipes to cache */
   bool cache_save_ok = writer.WriteHeader();
@@ -828,12 +935,19 @@ bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
   if (!writer.Write(&hash, sizeof(hash)))
     cache_save_ok = false;
 
+  // the offsets and the hashes of the objects for loading them in parallel
+  std::vector<GOCacheIndexEntry> entries;
+
   for (unsigned i = 0; cache_save_ok; i++) {
     GOCacheObject *obj = objectDistributor.FetchNext();
 
     if (!obj)
       break;
-    if (!obj->SaveCache(writer)) {
+    if (!writer.StartFrame())
+      cache_save_ok = false;
+    entries.push_back(
+      {writer.GetPos(), generate_object_hash(m_FileStore, obj)});
+    if (cache_save_ok && !obj->SaveCache(writer)) {
       cache_save_ok = false;
       wxLogError(
         _("Save of %s to the cache failed"), obj->GetLoadTitle().c_str());
@@ -845,6 +959,8 @@ bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
     }
   }
 
+  if (cache_save_ok && !writer.WriteIndex(entries))
+    cache_save_ok = false;
   writer.Close();
   if (!cache_save_ok) {
     DeleteCache();
@@ -853,6 +969,56 @@ bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
   return true;
 }
 
+bool GOOrganController::AppendCache(
+  GOProgressDialog *dlg,
+  const GOCache &reader,
+  const std::vector<uint64_t> &cacheOffsets,
+  const std::vector<GOHashType> &hashes) {
+  const std::vector<GOCacheObject *> &objects = GetCacheObjects();
+  wxFile cacheFile(m_CacheFilename, wxFile::read_write);
+
+  if (
+    !cacheFile.IsOpened()
+    || cacheFile.Seek(reader.GetIndexOffset()) == wxInvalidOffset)
+    return false;
+
+  const wxFileOffset fileSize = cacheFile.Length();
+  wxFileOutputStream file(cacheFile);
+  GOCacheWriter writer(
+    file, reader.IsCompressed(), m_config.LoadConcurrency() + 1);
+  std::vector<GOCacheIndexEntry> entries(objects.size());
+  bool isOk = fileSize != wxInvalidOffset;
+
+  writer.InitAppend(
+    reader.GetObjectsEnd(),
+    reader.GetIndexOffset(),
+    reader.GetFrames(),
+    fileSize);
+  dlg->Setup(objects.size(), _("Updating sample cache"));
+  for (unsigned i = 0; isOk && i < objects.size(); i++) {
+    GOCacheObject *obj = objects[i];
+
+    entries[i] = {cacheOffsets[i], hashes[i]};
+    if (cacheOffsets[i] != GOLoadWorker::NOT_CACHED)
+      continue;
+    isOk = writer.StartFrame();
+    entries[i].m_Offset = writer.GetPos();
+    if (isOk && !obj->SaveCache(writer)) {
+      isOk = false;
+      wxLogError(_("Save of %s to the cache failed"), obj->GetLoadTitle());
+    }
+    if (!dlg->Update(i + 1, obj->GetLoadTitle())) {
+      // the index has been overwritten
+      writer.Close();
+      DeleteCache();
+      return true;
+    }
+  }
+  isOk = isOk && writer.WriteIndex(entries);
+  writer.Close();
+  return isOk;
+}
+
 void GOOrganController::DeleteCache() {
   if (CachePresent())
     wxRemoveFile(m_CacheFilename);
@@ -1097,6 +1263,15 @@ void GOOrganController::Update() {
 }
 
 void GOOrganController::ProcessMidi(const GOMidiEvent &event) {
+  ProcessMidi(
+    event, m_soundengine ? m_soundengine->GetPeriodOffset(event.GetTime()) : 0);
+}
+
+void GOOrganController::ProcessMidi(
+  const GOMidiEvent &event, unsigned frameOffset) {
+  // it may be called from the MIDI dispatch thread
+  std::lock_guard<std::recursive_mutex> locker(m_InputMutex);
+
   if (event.GetMidiType() == GOMidiEvent::MIDI_SYSEX_JOHANNUS_ANTONIJN)
   {
     // Need to be translated
@@ -1191,10 +1366,17 @@ void GOOrganController::ProcessMidi(const GOMidiEvent &event) {
       return;
   }
 
+  // the pipes start and stop at the offset of the event inside the period
+  if (m_soundengine)
+    m_soundengine->SetEventOffset(frameOffset);
   GOEventDistributor::SendMidi(event);
+  if (m_soundengine)
+    m_soundengine->SetEventOffset(0);
 }
 
 void GOOrganController::Reset() {
+  std::lock_guard<std::recursive_mutex> locker(m_InputMutex);
+
   for (unsigned l = 0; l < GetSwitchCount(); l++)
     GetSwitch(l)->Reset();
   for (unsigned k = GetFirstManualIndex(); k <= GetManualAndPedalCount(); k++)
@@ -1209,6 +1391,8 @@ void GOOrganController::Reset() {
 }
 
 void GOOrganController::SetTemperament(const GOTemperament &temperament) {
+  std::lock_guard<std::recursive_mutex> locker(m_InputMutex);
+
   m_TemperamentLabel.SetContent(wxGetTranslation(temperament.GetName()));
   for (unsigned k = 0; k < m_ranks.size(); k++)
     m_ranks[k]->SetTemperament(temperament);
@@ -1224,6 +1408,8 @@ void GOOrganController::SetTemperament(wxString name) {
 wxString GOOrganController::GetTemperament() { return m_Temperament; }
 
 void GOOrganController::AllNotesOff() {
+  std::lock_guard<std::recursive_mutex> locker(m_InputMutex);
+
   for (unsigned k = GetFirstManualIndex(); k <= GetManualAndPedalCount(); k++)
     GetManual(k)->AllNotesOff();
 }
@@ -8,6 +8,7 @@
 #ifndef GOORGANCONTROLLER_H
 #define GOORGANCONTROLLER_H
 
+#include <mutex>
 #include <vector>
 
 #include <wx/string.h>
@@ -18,6 +19,7 @@
 #include "control/GOEventDistributor.h"
 #include "control/GOLabelControl.h"
 #include "gui/GOGUIMouseState.h"
+#include "loader/GOCacheObjectDistributor.h"
 #include "loader/GOFileStore.h"
 #include "model/GOOrganModel.h"
 #include "modification/GOModificationProxy.h"
@@ -53,6 +55,7 @@ class GOSoundEngine;
 class GOSoundProvider;
 class GOSoundRecorder;
 typedef struct _GOHashType GOHashType;
+struct GOCacheIndexEntry;
 
 class GOOrganController : public GOEventDistributor,
                           public GOOrganModel,
@@ -102,6 +105,9 @@ private:
   std::vector<bool> m_MidiSamplesetMatch;
   int m_SampleSetId1, m_SampleSetId2;
   GOGUIMouseState m_MouseState;
+  // serialises the MIDI input from the dispatch thread with the GUI input.
+  // Recursive because a GUI action may play MIDI events itself
+  std::recursive_mutex m_InputMutex;
 
   GOMemoryPool m_pool;
   GOBitmapCache *m_bitmaps;
@@ -117,8 +123,50 @@ private:
 
   void ReadOrganFile(GOConfigReader &cfg);
   GOHashType GenerateCacheHash();
+  /**
+   * Finds the cached data of each object by the hash of its settings
+   * @param cacheIndex the index read with GOCache::ReadIndex
+   * @param cacheOffsets receives the offset of each object in the cache or
+   *   GOLoadWorker::NOT_CACHED if the object is not cached or stale
+   * @param hashes receives the hash of each object
+   * @return the number of the objects that are not cached
+   */
+  unsigned MatchCacheObjects(
+    const std::vector<GOCacheIndexEntry> &cacheIndex,
+    std::vector<uint64_t> &cacheOffsets,
+    std::vector<GOHashType> &hashes);
+  /**
+   * Appends the objects not found in the cache to it and replaces the index.
+   * The objects already cached stay at their places
+   * @param reader the reader of the cache having read the index
+   * @return false if the cache could not be updated and has to be rewritten.
+   *   If the user cancels the update then the cache is deleted
+   */
+  bool AppendCache(
+    GOProgressDialog *dlg,
+    const GOCache &reader,
+    const std::vector<uint64_t> &cacheOffsets,
+    const std::vector<GOHashType> &hashes);
   wxString GenerateSettingFileName();
   wxString GenerateCacheFileName();
+
+  /**
+   * Loads the objects of the distributor in this thread and in
+   * LoadConcurrency() additional threads. Shows the errors if any
+   * @param dlg the progress dialog
+   * @param distributor the objects to load
+   * @param pCache if not null then the objects are restored from the cache
+   * @param pCacheOffsets the index of the cache. Used only with pCache
+   * @param wereCacheFailures receives whether any object could not be
+   *   restored from the cache and has been loaded from its file
+   * @return whether all objects have been loaded without errors
+   */
+  bool LoadObjects(
+    GOProgressDialog *dlg,
+    GOCacheObjectDistributor &distributor,
+    GOCache *pCache,
+    const std::vector<uint64_t> *pCacheOffsets,
+    bool &wereCacheFailures);
   void SetTemperament(const GOTemperament &temperament);
   void PreconfigRecorder();
 
@@ -177,7 +225,18 @@ public:
   void PrepareRecording();
   void Update();
   void Reset();
+  /**
+   * Processes an event received in real time. The samplers start and stop at
+   * the offset of the event time inside the next period
+   */
   void ProcessMidi(const GOMidiEvent &event);
+  /**
+   * Processes an event at a known frame offset inside the next period, so the
+   * event time is not used for timing the samplers
+   */
+  void ProcessMidi(const GOMidiEvent &event, unsigned frameOffset);
+  /* Must be locked while the GUI thread plays the organ */
+  std::recursive_mutex &GetInputMutex() { return m_InputMutex; }
   void AllNotesOff();
   // GODocument *GetDocument();
 
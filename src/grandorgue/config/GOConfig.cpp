@@ -151,11 +151,13 @@ GOConfig::GOConfig(wxString instance)
     InterpolationType(this, wxT("General"), wxT("InterpolationType"), 0, 1, 0),
     WaveFormatBytesPerSample(this, wxT("General"), wxT("WaveFormat"), 1, 4, 4),
     RecordDownmix(this, wxT("General"), wxT("RecordDownmix"), false),
+    RecordCompressed(this, wxT("General"), wxT("RecordCompressed"), false),
     AttackLoad(this, wxT("General"), wxT("AttackLoad"), 0, 1, 1),
     LoopLoad(this, wxT("General"), wxT("LoopLoad"), 0, 2, 2),
     ReleaseLoad(this, wxT("General"), wxT("ReleaseLoad"), 0, 1, 1),
     ManageCache(this, wxT("General"), wxT("ManageCache"), true),
     CompressCache(this, wxT("General"), wxT("CompressCache"), false),
+    StreamSamples(this, wxT("General"), wxT("StreamSamples"), false),
     LoadLastFile(
       this,
       wxT("General"),
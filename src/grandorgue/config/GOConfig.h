@@ -80,6 +80,7 @@ public:
   GOSettingUnsigned InterpolationType;
   GOSettingUnsigned WaveFormatBytesPerSample;
   GOSettingBool RecordDownmix;
+  GOSettingBool RecordCompressed;
 
   GOSettingUnsigned AttackLoad;
   GOSettingUnsigned LoopLoad;
@@ -87,6 +88,7 @@ public:
 
   GOSettingBool ManageCache;
   GOSettingBool CompressCache;
+  GOSettingBool StreamSamples;
   GOSettingEnum<GOInitialLoadType> LoadLastFile;
   GOSettingBool ODFCheck;
   GOSettingBool ODFHw1Check;
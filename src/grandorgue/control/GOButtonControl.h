@@ -48,6 +48,9 @@ protected:
   bool m_IsPiston;
 
   void ProcessMidi(const GOMidiEvent &event) override;
+  const GOMidiReceiverBase *GetDispatchReceiver() const override {
+    return &m_midi;
+  }
   void HandleKey(int key) override;
 
   void Save(GOConfigWriter &cfg) override;
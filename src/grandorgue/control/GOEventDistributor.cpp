@@ -7,6 +7,7 @@
 
 #include "GOEventDistributor.h"
 
+#include "midi/GOMidiReceiverBase.h"
 #include "model/GOCacheObject.h"
 #include "model/GOEventHandlerList.h"
 #include "sound/GOSoundStateHandler.h"
@@ -15,9 +16,32 @@
 #include "GOEventHandler.h"
 #include "GOSaveableObject.h"
 
+void GOEventDistributor::BuildMidiIndex() {
+  const auto &handlers = p_model->GetMidiEventHandlers();
+
+  m_MidiIndexGeneration = GOMidiReceiverBase::GetConfigGeneration();
+  m_MidiIndexHandlerCount = handlers.size();
+  m_MidiIndex.Clear(handlers.size());
+  for (unsigned i = 0; i < handlers.size(); i++) {
+    const GOMidiReceiverBase *pReceiver = handlers[i]->GetDispatchReceiver();
+
+    if (pReceiver)
+      pReceiver->AddToDispatchIndex(m_MidiIndex, i);
+    else
+      m_MidiIndex.AddForAllEvents(i);
+  }
+}
+
 void GOEventDistributor::SendMidi(const GOMidiEvent &event) {
-  for (auto handler : p_model->GetMidiEventHandlers())
-    handler->ProcessMidi(event);
+  const auto &handlers = p_model->GetMidiEventHandlers();
+
+  if (
+    m_MidiIndexGeneration != GOMidiReceiverBase::GetConfigGeneration()
+    || m_MidiIndexHandlerCount != handlers.size())
+    BuildMidiIndex();
+  m_MidiIndex.Find(event, m_MidiHandlersFound);
+  for (unsigned i : m_MidiHandlersFound)
+    handlers[i]->ProcessMidi(event);
 }
 
 void GOEventDistributor::HandleKey(int key) {
@@ -40,11 +64,6 @@ void GOEventDistributor::ResolveReferences() {
     obj->InitWithoutExc();
 }
 
-void GOEventDistributor::UpdateHash(GOHash &hash) {
-  for (auto obj : p_model->GetCacheObjects())
-    obj->UpdateHash(hash);
-}
-
 void GOEventDistributor::PreparePlayback(GOSoundEngine *pSoundEngine) {
   for (auto handler : p_model->GetSoundStateHandlers())
     handler->PreparePlaybackExt(pSoundEngine);
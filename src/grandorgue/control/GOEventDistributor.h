@@ -10,16 +10,25 @@
 
 #include <vector>
 
+#include "midi/GOMidiDispatchIndex.h"
+
 class GOConfigReader;
 class GOConfigWriter;
 class GOEventHandlerList;
-class GOHash;
 class GOMidiEvent;
 class GOSoundEngine;
 
 class GOEventDistributor {
 private:
   GOEventHandlerList *p_model;
+  GOMidiDispatchIndex m_MidiIndex;
+  // the receiver generation and the number of handlers m_MidiIndex is for
+  unsigned m_MidiIndexGeneration;
+  unsigned m_MidiIndexHandlerCount;
+  // the handlers found for the current event. Kept for reusing the memory
+  std::vector<unsigned> m_MidiHandlersFound;
+
+  void BuildMidiIndex();
 
 protected:
   void SendMidi(const GOMidiEvent &event);
@@ -28,7 +37,6 @@ protected:
   void Save(GOConfigWriter &cfg);
 
   void ResolveReferences();
-  void UpdateHash(GOHash &hash);
 
   void PreparePlayback(GOSoundEngine *pSoundEngine);
   void StartPlayback();
@@ -36,7 +44,8 @@ protected:
   void PrepareRecording();
 
 public:
-  GOEventDistributor(GOEventHandlerList *pModel) { p_model = pModel; }
+  GOEventDistributor(GOEventHandlerList *pModel)
+    : p_model(pModel), m_MidiIndexGeneration(0), m_MidiIndexHandlerCount(0) {}
   ~GOEventDistributor() { p_model = nullptr; }
 
   void HandleKey(int key);
@@ -12,6 +12,7 @@
 #include "GODocument.h"
 #include "GOOrganController.h"
 #include "config/GOConfig.h"
+#include "threading/GOMutexLocker.h"
 
 GOLabelControl::GOLabelControl(GOOrganController *organController)
   : GOMidiConfigurator(*organController),
@@ -43,11 +44,19 @@ void GOLabelControl::Save(GOConfigWriter &cfg) {
   m_sender.Save(cfg, m_group, m_OrganController->GetSettings().GetMidiMap());
 }
 
-const wxString &GOLabelControl::GetContent() { return m_Content; }
+wxString GOLabelControl::GetContent() {
+  GOMutexLocker locker(m_ContentMutex);
+
+  return m_Content;
+}
 
 void GOLabelControl::SetContent(wxString name) {
-  m_Content = name;
-  m_sender.SetLabel(m_Content);
+  {
+    GOMutexLocker locker(m_ContentMutex);
+
+    m_Content = name;
+  }
+  m_sender.SetLabel(name);
   m_OrganController->SendControlChanged(this);
 }
 
@@ -69,7 +78,7 @@ const wxString &GOLabelControl::GetMidiTypeCode() const {
 
 const wxString &GOLabelControl::GetMidiType() const { return WX_MIDI_TYPE; }
 
-wxString GOLabelControl::GetElementStatus() { return m_Content; }
+wxString GOLabelControl::GetElementStatus() { return GetContent(); }
 
 std::vector<wxString> GOLabelControl::GetElementActions() {
   std::vector<wxString> actions;
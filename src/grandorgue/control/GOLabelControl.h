@@ -14,6 +14,8 @@
 #include "midi/GOMidiSender.h"
 #include "sound/GOSoundStateHandler.h"
 
+#include "threading/GOMutex.h"
+
 #include "GOControl.h"
 #include "GOSaveableObject.h"
 
@@ -28,6 +30,8 @@ class GOLabelControl : public GOControl,
 protected:
   wxString m_Name;
   wxString m_Content;
+  // the content may be set from the MIDI dispatch thread while it is drawn
+  GOMutex m_ContentMutex;
   wxString m_group;
   GOOrganController *m_OrganController;
   GOMidiSender m_sender;
@@ -44,7 +48,7 @@ public:
   void Init(GOConfigReader &cfg, wxString group, wxString name);
   void Load(GOConfigReader &cfg, wxString group, wxString name);
   const wxString &GetName() const { return m_Name; }
-  const wxString &GetContent();
+  wxString GetContent();
   void SetContent(wxString name);
 
   const wxString &GetMidiTypeCode() const override;
@@ -36,13 +36,15 @@ private:
 
 public:
   GOProgressDialog();
-  ~GOProgressDialog();
+  virtual ~GOProgressDialog();
 
-  void Setup(
+  /* The methods are virtual so the tools without GUI may report the progress
+   * in another way */
+  virtual void Setup(
     long max, const wxString &title, const wxString &msg = wxEmptyString);
-  void Reset(long max, const wxString &msg = wxEmptyString);
+  virtual void Reset(long max, const wxString &msg = wxEmptyString);
 
-  bool Update(unsigned value, const wxString &msg);
+  virtual bool Update(unsigned value, const wxString &msg);
 };
 
 #endif
@@ -10,6 +10,7 @@
 #include <wx/checkbox.h>
 #include <wx/intl.h>
 #include <wx/sizer.h>
+#include <wx/thread.h>
 
 #include "model/GOCoupler.h"
 #include "model/GODivisionalCoupler.h"
@@ -143,6 +144,12 @@ void GOStopsDialog::OnElementChanging(wxCommandEvent &event) {
 }
 
 void GOStopsDialog::ControlChanged(GOControl *pControl) {
+  if (!wxIsMainThread()) {
+    // a MIDI event from the dispatch thread
+    CallAfter([this, pControl]() { ControlChanged(pControl); });
+    return;
+  }
+
   auto pElement = dynamic_cast<GOCombinationElement *>(pControl);
 
   if (pElement) {
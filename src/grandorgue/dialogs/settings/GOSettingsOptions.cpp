@@ -212,6 +212,12 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
     0,
     wxEXPAND | wxALL,
     5);
+  item6->Add(
+    m_RecordCompressed = new wxCheckBox(
+      this, ID_RECORD_COMPRESSED, _("Compress recordings with WavPack")),
+    0,
+    wxEXPAND | wxALL,
+    5);
 
   item6 = new wxStaticBoxSizer(wxVERTICAL, this, _("&Default volume"));
   grid = new wxFlexGridSizer(2, 5, 5);
@@ -236,6 +242,7 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
   m_LoadConcurrency->Select(m_config.LoadConcurrency());
   m_WaveFormat->Select(m_config.WaveFormatBytesPerSample() - 1);
   m_RecordDownmix->SetValue(m_config.RecordDownmix());
+  m_RecordCompressed->SetValue(m_config.RecordCompressed());
 
   item9 = new wxBoxSizer(wxVERTICAL);
 
@@ -356,8 +363,17 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
     0,
     wxEXPAND | wxALL,
     5);
+  item6->Add(
+    m_StreamSamples = new wxCheckBox(
+      this,
+      ID_STREAM_SAMPLES,
+      _("Stream long samples from the uncompressed cache")),
+    0,
+    wxEXPAND | wxALL,
+    5);
   m_CompressCache->SetValue(m_config.CompressCache());
   m_ManageCache->SetValue(m_config.ManageCache());
+  m_StreamSamples->SetValue(m_config.StreamSamples());
 
   item9->Add(
     m_ODFCheck = new wxCheckBox(this, ID_ODF_CHECK, _("Perform strict ODF")),
@@ -430,10 +446,12 @@ bool GOSettingsOptions::TransferDataFromWindow() {
   m_config.ManagePolyphony(m_Limit->IsChecked());
   m_config.CompressCache(m_CompressCache->IsChecked());
   m_config.ManageCache(m_ManageCache->IsChecked());
+  m_config.StreamSamples(m_StreamSamples->IsChecked());
   m_config.LoadLastFile(m_LoadLastFile->GetCurrentSelection());
   m_config.ODFCheck(m_ODFCheck->IsChecked());
   m_config.ODFHw1Check(m_ODFHw1Check->IsChecked());
   m_config.RecordDownmix(m_RecordDownmix->IsChecked());
+  m_config.RecordCompressed(m_RecordCompressed->IsChecked());
   m_config.Volume(m_Volume->GetValue());
   m_config.ScaleRelease(m_Scale->IsChecked());
   m_config.RandomizeSpeaking(m_Random->IsChecked());
@@ -28,6 +28,7 @@ class GOSettingsOptions : public wxPanel {
     ID_MANAGE_POLYPHONY,
     ID_COMPRESS_CACHE,
     ID_MANAGE_CACHE,
+    ID_STREAM_SAMPLES,
     ID_SCALE_RELEASE,
     ID_LOAD_LAST_FILE,
     ID_RANDOMIZE,
@@ -40,6 +41,7 @@ class GOSettingsOptions : public wxPanel {
     ID_MEMORY_LIMIT,
     ID_ODF_CHECK,
     ID_RECORD_DOWNMIX,
+    ID_RECORD_COMPRESSED,
     ID_VOLUME,
     ID_LANGUAGE,
     ID_METRONOME_MEASURE,
@@ -56,12 +58,14 @@ private:
   wxCheckBox *m_Limit;
   wxCheckBox *m_CompressCache;
   wxCheckBox *m_ManageCache;
+  wxCheckBox *m_StreamSamples;
   GOChoice<GOInitialLoadType> *m_LoadLastFile;
   wxCheckBox *m_Scale;
   wxCheckBox *m_Random;
   wxCheckBox *m_ODFCheck;
   wxCheckBox *m_ODFHw1Check;
   wxCheckBox *m_RecordDownmix;
+  wxCheckBox *m_RecordCompressed;
   wxSpinCtrl *m_Volume;
   wxChoice *m_BitsPerSample;
   wxChoice *m_LoopLoad;
@@ -24,10 +24,14 @@
 #include <wx/sizer.h>
 #include <wx/stattext.h>
 #include <wx/textctrl.h>
+#include <wx/utils.h>
 
+#include "archive/GOArchive.h"
 #include "archive/GOArchiveFile.h"
 #include "archive/GOArchiveIndex.h"
+#include "archive/GOArchiveVerifier.h"
 #include "config/GOConfig.h"
+#include "dialogs/GOProgressDialog.h"
 #include "dialogs/midi-event/GOMidiEventDialog.h"
 #include "files/GOStdFileName.h"
 #include "size/GOAdditionalSizeKeeperProxy.h"
@@ -48,6 +52,7 @@ EVT_BUTTON(ID_ORGAN_TOP, GOSettingsOrgans::OnOrganTop)
 EVT_BUTTON(ID_ORGAN_DEL, GOSettingsOrgans::OnOrganDel)
 EVT_BUTTON(ID_ORGAN_MIDI, GOSettingsOrgans::OnOrganMidi)
 EVT_BUTTON(ID_ORGAN_RELOCATE, GOSettingsOrgans::OnOrganRelocate)
+EVT_BUTTON(ID_VERIFY_PACKAGE, GOSettingsOrgans::OnVerifyPackage)
 EVT_BUTTON(ID_DEL_CACHE, GOSettingsOrgans::OnDelCache)
 EVT_BUTTON(ID_DEL_PRESET, GOSettingsOrgans::OnDelPreset)
 END_EVENT_TABLE()
@@ -202,11 +207,14 @@ GOSettingsOrgans::GOSettingsOrgans(
   m_OrganTop = new wxButton(this, ID_ORGAN_TOP, _("&Top"));
   m_OrganMidi = new wxButton(this, ID_ORGAN_MIDI, _("&MIDI..."));
   m_OrganRelocate = new wxButton(this, ID_ORGAN_RELOCATE, _("&Relocate..."));
+  m_VerifyPackage
+    = new wxButton(this, ID_VERIFY_PACKAGE, _("&Verify package..."));
   buttonSizer->Add(m_OrganDown, 0, wxALIGN_LEFT | wxALL, 5);
   buttonSizer->Add(m_OrganUp, 0, wxALIGN_LEFT | wxALL, 5);
   buttonSizer->Add(m_OrganTop, 0, wxALIGN_LEFT | wxALL, 5);
   buttonSizer->Add(m_OrganMidi, 0, wxALIGN_LEFT | wxALL, 5);
   buttonSizer->Add(m_OrganRelocate, 0, wxALIGN_LEFT | wxALL, 5);
+  buttonSizer->Add(m_VerifyPackage, 0, wxALIGN_LEFT | wxALL, 5);
   gbSizer->Add(buttonSizer, wxGBPosition(5, 0), wxGBSpan(1, 4), wxALL);
 
   buttonSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -414,6 +422,11 @@ void GOSettingsOrgans::RefreshFocused(const int currOrganIndex) {
           archiveInfo += wxString::Format(
             _("requires '%s' "), a->GetDependencyTitles()[i]);
     }
+    if (a->IsUsable()) {
+      GOArchiveIndex index(m_config.OrganCachePath(), a->GetPath());
+
+      archiveInfo += index.IsVerified() ? _("verified") : _("not verified");
+    }
   }
 
   m_Builder->ChangeValue(o ? o->GetOrganBuilder() : EMPTY_STRING);
@@ -454,12 +467,23 @@ GOSettingsOrgans::VisibleOrganRecs GOSettingsOrgans::GetCurrentOrganRecs() {
 }
 
 void GOSettingsOrgans::RefreshButtons() {
-  if (m_GridOrgans->GetGridCursorRow() >= 0) {
+  const int iFocused = m_GridOrgans->GetGridCursorRow();
+
+  if (iFocused >= 0) {
     m_OrganMidi->Enable();
   } else {
     m_OrganMidi->Disable();
   }
 
+  const OrganSlot *pFocusedSlot = iFocused >= 0
+      && iFocused < (int)m_OrganSlotPtrsByGridLine.size()
+    ? m_OrganSlotPtrsByGridLine[iFocused]
+    : nullptr;
+
+  m_VerifyPackage->Enable(
+    pFocusedSlot && pFocusedSlot->p_PackageSlot
+    && pFocusedSlot->p_PackageSlot->p_CurrentPkg->IsUsable());
+
   int iFirstSelected = -1;
   int iLastSelected = -1;
   bool isAnyCacheExisting = false;
@@ -640,6 +664,70 @@ void GOSettingsOrgans::OnOrganMidi(wxCommandEvent &event) {
   }
 }
 
+void GOSettingsOrgans::OnVerifyPackage(wxCommandEvent &event) {
+  const int currOrganIndex = m_GridOrgans->GetGridCursorRow();
+  const OrganSlot *pOrganSlot = currOrganIndex >= 0
+    ? m_OrganSlotPtrsByGridLine[currOrganIndex]
+    : nullptr;
+
+  if (!pOrganSlot || !pOrganSlot->p_PackageSlot)
+    return;
+
+  const GOArchiveFile *pPkg = pOrganSlot->p_PackageSlot->p_CurrentPkg;
+  GOArchive archive(m_config.OrganCachePath());
+
+  if (!archive.OpenArchive(pPkg->GetPath())) {
+    wxLogError(_("Failed to open the organ package '%s'"), pPkg->GetPath());
+    return;
+  }
+
+  // the package is read by the background threads. Here only the progress is
+  // shown
+  GOArchiveVerifier verifier(archive);
+  GOProgressDialog dlg;
+  bool isCancelled = false;
+
+  verifier.Start(m_config.LoadConcurrency());
+  dlg.Setup(
+    std::max<uint64_t>(verifier.GetBytesTotal() >> 20, 1),
+    _("Verifying the organ package"),
+    pPkg->GetName());
+  while (verifier.IsRunning()) {
+    wxMilliSleep(100);
+    if (!dlg.Update(verifier.GetBytesDone() >> 20, pPkg->GetName())) {
+      verifier.Stop();
+      isCancelled = true;
+    }
+  }
+
+  std::vector<wxString> corrupted;
+  const bool isOk = verifier.Finish(corrupted);
+
+  archive.Close();
+  if (isCancelled)
+    return;
+  if (isOk) {
+    // the package info shows the verification state
+    RefreshFocused(currOrganIndex);
+    wxMessageBox(
+      wxString::Format(_("The organ package '%s' is correct"), pPkg->GetName()),
+      _("Verify package"),
+      wxOK | wxICON_INFORMATION,
+      this);
+  } else if (corrupted.empty())
+    wxLogError(_("Failed to read the organ package '%s'"), pPkg->GetPath());
+  else {
+    wxString names;
+
+    for (const wxString &name : corrupted)
+      names += wxT("\n") + name;
+    wxLogError(
+      _("CRC mismatch in organ package '%s' - files corrupted:%s"),
+      pPkg->GetName(),
+      names);
+  }
+}
+
 void GOSettingsOrgans::ReplaceOrganPath(
   const unsigned index, const wxString &newPath) {
   OrganSlot *pOrganSlot = m_OrganSlotPtrsByGridLine[index];
@@ -39,6 +39,7 @@ public:
     ID_ORGAN_TOP,
     ID_ORGAN_MIDI,
     ID_ORGAN_RELOCATE,
+    ID_VERIFY_PACKAGE,
     ID_DEL_CACHE,
     ID_DEL_PRESET
   };
@@ -101,6 +102,7 @@ private:
   wxButton *m_OrganDel;
   wxButton *m_OrganMidi;
   wxButton *m_OrganRelocate;
+  wxButton *m_VerifyPackage;
   wxButton *m_DelCache;
   wxButton *m_DelPreset;
 
@@ -132,6 +134,7 @@ private:
   void OnOrganDel(wxCommandEvent &event) { DelSelectedOrgans(); }
   void OnOrganMidi(wxCommandEvent &event);
   void OnOrganRelocate(wxCommandEvent &event);
+  void OnVerifyPackage(wxCommandEvent &event);
   void OnDelCache(wxCommandEvent &event);
   void OnDelPreset(wxCommandEvent &event);
 
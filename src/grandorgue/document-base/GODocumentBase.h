@@ -8,6 +8,7 @@
 #ifndef GODOCUMENTBASE_H
 #define GODOCUMENTBASE_H
 
+#include <mutex>
 #include <vector>
 
 class GOView;
@@ -33,6 +34,10 @@ public:
   GODocumentBase();
   ~GODocumentBase();
 
+  // the mutex serialising the changes of the document with other threads.
+  // The GUI events of the document windows are handled under it
+  virtual std::recursive_mutex *GetInputMutex() { return nullptr; }
+
   bool WindowExists(WindowType type, void *data);
   bool showWindow(WindowType type, void *data);
   void registerWindow(WindowType type, void *data, GOView *window);
@@ -19,6 +19,10 @@ GOView::~GOView() {
   m_doc = NULL;
 }
 
+std::recursive_mutex *GOView::GetInputMutex() const {
+  return m_doc ? m_doc->GetInputMutex() : nullptr;
+}
+
 void GOView::RemoveView() {
   m_doc = NULL;
 
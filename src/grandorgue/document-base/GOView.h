@@ -10,6 +10,8 @@
 
 #include <wx/window.h>
 
+#include <mutex>
+
 class GODocumentBase;
 
 class GOView {
@@ -22,6 +24,7 @@ public:
   virtual ~GOView();
 
   bool HasDocument() const { return m_doc != NULL; }
+  std::recursive_mutex *GetInputMutex() const;
 
   virtual void RemoveView();
   void ShowView();
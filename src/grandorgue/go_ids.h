@@ -59,6 +59,7 @@ enum {
   ID_AUDIO_MEMSET,
   ID_AUDIO_PANIC,
   ID_AUDIO_STATE,
+  ID_AUDIO_STATISTICS,
   ID_SETTINGS,
 
   ID_PRESET_0,
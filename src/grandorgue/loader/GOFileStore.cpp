@@ -9,8 +9,11 @@
 
 #include <wx/intl.h>
 
+#include <algorithm>
+
 #include "archive/GOArchive.h"
 #include "archive/GOArchiveFile.h"
+#include "archive/GOArchiveIndex.h"
 #include "archive/GOArchiveManager.h"
 #include "config/GOConfig.h"
 
@@ -22,9 +25,23 @@ GOFileStore::GOFileStore(const GOConfig &config)
 void GOFileStore::SetDirectory(const wxString &directory) {
   // we do not support if both m_directory and m_archives are filled
   m_archives.clear();
+  m_NameIndex.clear();
   m_directory = directory;
 }
 
+void GOFileStore::BuildNameIndex() {
+  m_NameIndex.clear();
+  for (auto a : m_archives)
+    for (const GOArchiveEntry &e : a->GetEntries())
+      m_NameIndex.emplace_back(e.nameHash, a);
+  std::stable_sort(
+    m_NameIndex.begin(),
+    m_NameIndex.end(),
+    [](
+      const std::pair<uint64_t, GOArchive *> &a,
+      const std::pair<uint64_t, GOArchive *> &b) { return a.first < b.first; });
+}
+
 bool GOFileStore::LoadArchive(
   GOOrganList &organList,
   const wxString &cacheDir,
@@ -77,15 +94,27 @@ bool GOFileStore::LoadArchives(
       if (!isOk)
         break;
     }
+  if (isOk)
+    BuildNameIndex();
   return isOk;
 }
 
 GOArchive *GOFileStore::FindArchiveContaining(const wxString fileName) const {
+  const uint64_t nameHash = GOArchiveIndex::HashName(fileName);
   GOArchive *aFound = nullptr;
 
-  for (auto a : m_archives) {
-    if (a->containsFile(fileName)) {
-      aFound = a;
+  for (auto i = std::lower_bound(
+         m_NameIndex.begin(),
+         m_NameIndex.end(),
+         nameHash,
+         [](const std::pair<uint64_t, GOArchive *> &p, uint64_t hash) {
+           return p.first < hash;
+         });
+       i != m_NameIndex.end() && i->first == nameHash;
+       ++i) {
+    // another name may have the same hash
+    if (i->second->containsFile(fileName, nameHash)) {
+      aFound = i->second;
       break;
     }
   }
@@ -93,6 +122,7 @@ GOArchive *GOFileStore::FindArchiveContaining(const wxString fileName) const {
 }
 
 void GOFileStore::CloseArchives() {
+  m_NameIndex.clear();
   for (auto a : m_archives)
     a->Close();
 }
@@ -10,6 +10,10 @@
 
 #include <wx/string.h>
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "ptrvector.h"
 
 class GOArchive;
@@ -28,6 +32,14 @@ private:
 
   wxString m_directory;
   ptr_vector<GOArchive> m_archives;
+  /**
+   * The name hashes of the entries of all archives with the archives
+   * containing them. Sorted by the hash, the archives of the same hash are in
+   * the m_archives order
+   */
+  std::vector<std::pair<uint64_t, GOArchive *>> m_NameIndex;
+
+  void BuildNameIndex();
   bool LoadArchive(
     GOOrganList &organList,
     const wxString &cacheDir,
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOLoadPlanner.h"
+
+#if defined __linux__ || __WXMAC__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+
+#include "model/GOCacheObject.h"
+
+#include "GOLoadWorker.h"
+
+GOLoadPlanner::GOLoadPlanner(
+  const std::vector<GOCacheObject *> &objects,
+  const GOFileStore &fileStore,
+  const std::vector<uint64_t> *pCacheOffsets,
+  unsigned nWorkers)
+  : m_ReadAheadDistance(std::max(nWorkers, 1u) * READ_AHEAD_PER_WORKER),
+    m_ReadAheadPos(0) {
+  const unsigned nObjects = objects.size();
+  std::vector<const GOLoaderFilename *> files;
+
+  m_Plans.resize(nObjects);
+  for (unsigned i = 0; i < nObjects; i++) {
+    ObjectPlan &plan = m_Plans[i];
+
+    plan.m_index = i;
+    plan.m_kind = NOT_LOCATED;
+    plan.m_order = 0;
+    plan.m_size = 0;
+    plan.m_FirstLocation = m_Locations.size();
+    if (pCacheOffsets && (*pCacheOffsets)[i] != GOLoadWorker::NOT_CACHED) {
+      plan.m_kind = CACHED;
+      plan.m_order = (*pCacheOffsets)[i];
+    } else {
+      files.clear();
+      objects[i]->CollectLoadFiles(files);
+      for (const GOLoaderFilename *pFilename : files) {
+        GOLoaderFilename::Location location;
+
+        if (pFilename->Locate(fileStore, location)) {
+          m_Locations.push_back(location);
+          plan.m_size += location.m_length;
+        }
+      }
+      if (plan.m_FirstLocation < m_Locations.size()) {
+        const GOLoaderFilename::Location &first
+          = m_Locations[plan.m_FirstLocation];
+
+        plan.m_kind = first.m_kind == GOLoaderFilename::Location::IN_ARCHIVE
+          ? IN_ARCHIVE
+          : PLAIN_FILE;
+        plan.m_order = first.m_order;
+      }
+    }
+    plan.m_EndLocation = m_Locations.size();
+  }
+
+  std::stable_sort(
+    m_Plans.begin(),
+    m_Plans.end(),
+    [this](const ObjectPlan &a, const ObjectPlan &b) {
+      return IsBefore(a, b);
+    });
+
+  // the largest objects of a window first, so the small ones fill the gaps
+  const unsigned window
+    = std::max(MIN_WINDOW_OBJECTS, nWorkers * WINDOW_OBJECTS_PER_WORKER);
+
+  for (unsigned start = 0; start < nObjects; start += window)
+    std::stable_sort(
+      m_Plans.begin() + start,
+      m_Plans.begin() + std::min(start + window, nObjects),
+      [](const ObjectPlan &a, const ObjectPlan &b) {
+        return a.m_size > b.m_size;
+      });
+
+  m_Order.reserve(nObjects);
+  for (const ObjectPlan &plan : m_Plans)
+    m_Order.push_back(plan.m_index);
+}
+
+bool GOLoadPlanner::IsBefore(const ObjectPlan &a, const ObjectPlan &b) const {
+  if (a.m_kind != b.m_kind)
+    return a.m_kind < b.m_kind;
+  if (a.m_kind == IN_ARCHIVE) {
+    const wxString &pathA = m_Locations[a.m_FirstLocation].m_path;
+    const wxString &pathB = m_Locations[b.m_FirstLocation].m_path;
+
+    if (pathA != pathB)
+      return pathA < pathB;
+  }
+  return a.m_order < b.m_order;
+}
+
+void GOLoadPlanner::adviseWillNeed(
+  const GOLoaderFilename::Location &location) {
+  // other platforms rely on their own read ahead
+#if defined __linux__ || __WXMAC__
+  const int fd = open(location.m_path.fn_str(), O_RDONLY);
+
+  if (fd < 0)
+    return;
+#ifdef __linux__
+  posix_fadvise(
+    fd, location.m_offset, location.m_length, POSIX_FADV_WILLNEED);
+#else
+  struct radvisory ra;
+
+  ra.ra_offset = location.m_offset;
+  ra.ra_count = std::min<uint64_t>(location.m_length, INT_MAX);
+  fcntl(fd, F_RDADVISE, &ra);
+#endif
+  close(fd);
+#endif
+}
+
+void GOLoadPlanner::ReadAhead(unsigned seqPos) {
+  const unsigned end
+    = std::min<size_t>(seqPos + m_ReadAheadDistance + 1, m_Plans.size());
+
+  // each object is announced once by the worker that claims its position
+  for (unsigned pos = m_ReadAheadPos.load(); pos < end;) {
+    if (m_ReadAheadPos.compare_exchange_weak(pos, pos + 1)) {
+      const ObjectPlan &plan = m_Plans[pos];
+
+      for (unsigned i = plan.m_FirstLocation; i < plan.m_EndLocation; i++)
+        adviseWillNeed(m_Locations[i]);
+      pos++;
+    }
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOLOADPLANNER_H
+#define GOLOADPLANNER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "GOLoaderFilename.h"
+
+class GOCacheObject;
+class GOFileStore;
+
+/**
+ * Plans the order of loading the objects so the disk is read sequentially.
+ *
+ * The objects are sorted by the location of their first file on the disk:
+ * by the offset in the archive for the archive entries and by the inode for
+ * the plain files. The objects restored from the cache are sorted by their
+ * cache offsets. The sorted sequence is split into windows and the largest
+ * objects of each window go first, so the worker threads finish nearly
+ * together.
+ *
+ * While loading, the workers call ReadAhead() and the files of the next
+ * objects are announced to the OS for reading ahead.
+ */
+class GOLoadPlanner {
+private:
+  // the kinds in the order of loading
+  enum Kind { NOT_LOCATED, CACHED, IN_ARCHIVE, PLAIN_FILE };
+
+  struct ObjectPlan {
+    unsigned m_index;
+    Kind m_kind;
+    // the location on the disk inside the kind
+    uint64_t m_order;
+    uint64_t m_size;
+    // the range of m_Locations with the files of the object. The first one is
+    // used for sorting
+    unsigned m_FirstLocation;
+    unsigned m_EndLocation;
+  };
+
+  // the minimal number of objects in a window
+  static constexpr unsigned MIN_WINDOW_OBJECTS = 32;
+  // the number of objects in a window per worker
+  static constexpr unsigned WINDOW_OBJECTS_PER_WORKER = 8;
+  // how many objects per worker are read ahead
+  static constexpr unsigned READ_AHEAD_PER_WORKER = 2;
+
+  std::vector<GOLoaderFilename::Location> m_Locations;
+  // the object indices in the order of loading
+  std::vector<unsigned> m_Order;
+  // the objects in the order of loading
+  std::vector<ObjectPlan> m_Plans;
+  unsigned m_ReadAheadDistance;
+  // the next position in m_Order to read ahead
+  std::atomic_uint m_ReadAheadPos;
+
+  bool IsBefore(const ObjectPlan &a, const ObjectPlan &b) const;
+
+  static void adviseWillNeed(const GOLoaderFilename::Location &location);
+
+public:
+  /**
+   * Plans the loading
+   * @param objects the objects to load
+   * @param fileStore for locating the files of the objects
+   * @param pCacheOffsets if not null then the offsets of the objects in the
+   *   cache, with GOLoadWorker::NOT_CACHED for the objects loaded from their
+   *   files
+   * @param nWorkers the number of the loading threads
+   */
+  GOLoadPlanner(
+    const std::vector<GOCacheObject *> &objects,
+    const GOFileStore &fileStore,
+    const std::vector<uint64_t> *pCacheOffsets,
+    unsigned nWorkers);
+
+  /* The object indices for GOCacheObjectDistributor */
+  const std::vector<unsigned> &GetOrder() const { return m_Order; }
+
+  /**
+   * Called by a worker after fetching an object. Announces the files of the
+   * objects ahead to the OS. It may be called from several threads
+   * @param seqPos the position of the fetched object in GetOrder()
+   */
+  void ReadAhead(unsigned seqPos);
+};
+
+#endif /* GOLOADPLANNER_H */
@@ -23,8 +23,12 @@ public:
   GOLoadThread(
     const GOFileStore &fileStore,
     GOMemoryPool &pool,
-    GOCacheObjectDistributor &distributor)
-    : GOLoadWorker(fileStore, pool, distributor) {}
+    GOCacheObjectDistributor &distributor,
+    GOCache *pCache = nullptr,
+    const std::vector<uint64_t> *pCacheOffsets = nullptr,
+    GOLoadPlanner *pPlanner = nullptr)
+    : GOLoadWorker(
+      fileStore, pool, distributor, pCache, pCacheOffsets, pPlanner) {}
   ~GOLoadThread() { Stop(); }
 
   void Run() { Start(); }
@@ -34,6 +38,8 @@ public:
    * @return true if any exceptions occured. Otherwise - false
    */
   bool CheckExceptions();
+
+  using GOLoadWorker::WereCacheFailures;
 };
 
 #endif
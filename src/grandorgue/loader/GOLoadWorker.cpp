@@ -7,21 +7,33 @@
 
 #include "GOLoadWorker.h"
 
+#include <wx/intl.h>
+#include <wx/log.h>
+
+#include "loader/cache/GOCache.h"
 #include "model/GOCacheObject.h"
 
 #include "GOAlloc.h"
 #include "GOCacheObjectDistributor.h"
+#include "GOLoadPlanner.h"
 #include "GOMemoryPool.h"
 
 GOLoadWorker::GOLoadWorker(
   const GOFileStore &fileStore,
   GOMemoryPool &pool,
-  GOCacheObjectDistributor &distributor)
+  GOCacheObjectDistributor &distributor,
+  GOCache *pCache,
+  const std::vector<uint64_t> *pCacheOffsets,
+  GOLoadPlanner *pPlanner)
   : m_FileStore(fileStore),
     m_pool(pool),
     m_distributor(distributor),
+    p_cache(pCacheOffsets ? pCache : nullptr),
+    p_CacheOffsets(pCacheOffsets),
+    p_planner(pPlanner),
     m_WereExceptions(false),
-    m_OutOfMemory(false) {}
+    m_OutOfMemory(false),
+    m_WereCacheFailures(false) {}
 
 void GOLoadWorker::LoadObjectNoExc(GOCacheObject *obj) {
   try {
@@ -32,10 +44,43 @@ void GOLoadWorker::LoadObjectNoExc(GOCacheObject *obj) {
   }
 }
 
+void GOLoadWorker::LoadObjectFromCacheNoExc(
+  GOCacheObject *obj, unsigned index) {
+  const uint64_t offset = (*p_CacheOffsets)[index];
+
+  if (offset == NOT_CACHED) {
+    LoadObjectNoExc(obj);
+    return;
+  }
+  try {
+    if (
+      p_cache->Seek(offset)
+      && obj->LoadFromCacheWithoutExc(m_pool, *p_cache))
+      return;
+  } catch (GOOutOfMemory e) {
+    m_OutOfMemory = true;
+    m_WereExceptions = true;
+    return;
+  }
+  wxLogWarning(_("Cache load failure: %s"), obj->GetLoadError());
+  m_WereCacheFailures = true;
+  LoadObjectNoExc(obj);
+}
+
 bool GOLoadWorker::LoadNextObject(GOCacheObject *&obj) {
+  unsigned index;
+  unsigned seqPos;
+
   if (
-    !m_OutOfMemory && !m_pool.IsPoolFull() && (obj = m_distributor.FetchNext()))
-    LoadObjectNoExc(obj);
+    !m_OutOfMemory && !m_pool.IsPoolFull()
+    && (obj = m_distributor.FetchNext(index, seqPos))) {
+    if (p_planner)
+      p_planner->ReadAhead(seqPos);
+    if (p_cache)
+      LoadObjectFromCacheNoExc(obj, index);
+    else
+      LoadObjectNoExc(obj);
+  }
   return obj && !m_OutOfMemory;
 }
 
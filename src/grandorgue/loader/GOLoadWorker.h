@@ -7,9 +7,14 @@
 
 #include "GOCacheObjectDistributor.h"
 
+#include <cstdint>
+#include <vector>
+
 #include <wx/string.h>
 
+class GOCache;
 class GOFileStore;
+class GOLoadPlanner;
 class GOMemoryPool;
 
 #ifndef GOLOADWORKER_H
@@ -22,14 +27,26 @@ class GOMemoryPool;
  */
 
 class GOLoadWorker {
+public:
+  // the cache offset of an object that is not cached or is stale
+  static constexpr uint64_t NOT_CACHED = UINT64_MAX;
+
 private:
   const GOFileStore &m_FileStore;
   GOMemoryPool &m_pool;
   GOCacheObjectDistributor &m_distributor;
+  // if not null then the objects are restored from the cache
+  GOCache *p_cache;
+  const std::vector<uint64_t> *p_CacheOffsets;
+  // if not null then the files of the next objects are read ahead
+  GOLoadPlanner *p_planner;
 
   GOCacheObject *m_LastObject;
   bool m_WereExceptions; // any exception included GOOutOfMemory
   bool m_OutOfMemory;
+  bool m_WereCacheFailures;
+
+  void LoadObjectFromCacheNoExc(GOCacheObject *obj, unsigned index);
 
 public:
   /**
@@ -38,11 +55,22 @@ public:
    *  objects from
    * @param fileStore - passed to GOCacheObject::LoadData
    * @param pool - passed to GOCacheObject::LoadData
+   * @param pCache - if not null then the objects are restored from this
+   *   reader of the cache. The objects failed to restore are loaded from
+   *   their files
+   * @param pCacheOffsets - the offsets of the objects in the cache read with
+   *   GOCache::ReadIndex. The objects with NOT_CACHED are loaded from their
+   *   files. Used only with pCache
+   * @param pPlanner - if not null then the planner the distributor order is
+   *   taken from. It is told about each fetched object for reading ahead
    */
   GOLoadWorker(
     const GOFileStore &fileStore,
     GOMemoryPool &pool,
-    GOCacheObjectDistributor &distributor);
+    GOCacheObjectDistributor &distributor,
+    GOCache *pCache = nullptr,
+    const std::vector<uint64_t> *pCacheOffsets = nullptr,
+    GOLoadPlanner *pPlanner = nullptr);
 
   /**
    * Load the object. If an exception occured then remembers it for
@@ -68,6 +96,11 @@ public:
    * @return whether any exceptions were occured
    */
   bool WereExceptions() const;
+
+  /**
+   * @return whether any object could not be restored from the cache
+   */
+  bool WereCacheFailures() const { return m_WereCacheFailures; }
 };
 
 #endif /* GOLOADWORKER_H */
@@ -7,6 +7,7 @@
 
 #include "GOLoaderFilename.h"
 
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 
@@ -27,9 +28,15 @@ void GOLoaderFilename::Assign(const RootKind rootKind, const wxString &path) {
       _("Filename '%s' not compatible with case sensitive systems"), m_path);
 }
 
-void GOLoaderFilename::Hash(GOHash &hash) const {
+void GOLoaderFilename::Hash(const GOFileStore &fileStore, GOHash &hash) const {
+  Location location;
+
   hash.Update(m_RootKind);
   hash.Update(m_path);
+  if (Locate(fileStore, location)) {
+    hash.Update(location.m_length);
+    hash.Update(location.m_stamp);
+  }
 }
 
 std::unique_ptr<GOOpenedFile> GOLoaderFilename::Open(
@@ -63,6 +70,46 @@ std::unique_ptr<GOOpenedFile> GOLoaderFilename::Open(
   return std::unique_ptr<GOOpenedFile>(file);
 }
 
+bool GOLoaderFilename::Locate(
+  const GOFileStore &fileStore, Location &location) const {
+  if (m_RootKind == ROOT_ODF && fileStore.AreArchivesUsed()) {
+    GOArchive *const archive = fileStore.FindArchiveContaining(m_path);
+    size_t offset, length;
+    uint32_t crc;
+
+    if (!archive || !archive->GetEntryRange(m_path, offset, length, crc))
+      return false;
+    location.m_kind = Location::IN_ARCHIVE;
+    location.m_path = archive->GetPath();
+    location.m_offset = offset;
+    location.m_length = length;
+    location.m_order = offset;
+    location.m_stamp = crc;
+    return true;
+  }
+
+  wxString baseDir;
+
+  if (m_RootKind == ROOT_ODF)
+    baseDir = fileStore.GetDirectory();
+  else if (m_RootKind == ROOT_RESOURCE)
+    baseDir = fileStore.GetResourceDirectory();
+
+  const wxString fullPath = generateFullPath(m_path, baseDir);
+  wxStructStat st;
+
+  if (fullPath.IsEmpty() || wxStat(fullPath, &st) != 0)
+    return false;
+  location.m_kind = Location::PLAIN_FILE;
+  location.m_path = fullPath;
+  location.m_offset = 0;
+  location.m_length = st.st_size;
+  // the inodes of the files written together are usually allocated nearby
+  location.m_order = st.st_ino;
+  location.m_stamp = st.st_mtime;
+  return true;
+}
+
 wxString GOLoaderFilename::generateFullPath(
   const wxString &relPath, const wxString &baseDir) {
   wxString res = relPath;
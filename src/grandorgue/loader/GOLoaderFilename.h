@@ -8,6 +8,7 @@
 #ifndef GOLOADERFILENAME_H
 #define GOLOADERFILENAME_H
 
+#include <cstdint>
 #include <memory>
 
 #include <wx/string.h>
@@ -30,6 +31,23 @@ class GOHash;
  */
 
 class GOLoaderFilename {
+public:
+  /* Where the file is stored on the disk */
+  struct Location {
+    enum Kind { IN_ARCHIVE, PLAIN_FILE };
+
+    Kind m_kind;
+    // the file to read: the archive for an archive entry
+    wxString m_path;
+    // the range of m_path to read
+    uint64_t m_offset;
+    uint64_t m_length;
+    // the order on the disk: the offset in the archive or the inode
+    uint64_t m_order;
+    // changes with the content: the CRC of the entry or the modification time
+    uint64_t m_stamp;
+  };
+
 private:
   enum RootKind { ROOT_UNKNOWN, ROOT_ODF, ROOT_RESOURCE, ROOT_ABSOLUTE };
 
@@ -44,7 +62,15 @@ public:
   void AssignAbsolute(const wxString &path) { Assign(ROOT_ABSOLUTE, path); }
 
   const wxString &GetPath() const { return m_path; }
-  void Hash(GOHash &hash) const;
+
+  /**
+   * Hashes the name and the identity of the file: its length and either the
+   * CRC of the archive entry or the modification time of the plain file. So
+   * the hash changes when the file is replaced
+   * @param fileStore a GOFileStore object for searching the file against
+   * @param hash the hash to update
+   */
+  void Hash(const GOFileStore &fileStore, GOHash &hash) const;
 
   /**
    * Opens Searches the file and opens it. If the file does not exist then
@@ -54,6 +80,14 @@ public:
    */
   std::unique_ptr<GOOpenedFile> Open(const GOFileStore &fileStore) const;
 
+  /**
+   * Searches the file without opening it
+   * @param fileStore a GOFileStore object for searching the file against
+   * @param location receives where the file is stored
+   * @return whether the file has been found
+   */
+  bool Locate(const GOFileStore &fileStore, Location &location) const;
+
   wxString GenerateMessage(const wxString &srcMsg) const {
     return wxString::Format("%s: %s", m_path, srcMsg);
   }
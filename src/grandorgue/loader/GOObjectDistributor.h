@@ -18,13 +18,18 @@
 template <class T> class GOObjectDistributor {
 private:
   const std::vector<T *> &m_objects;
+  // if not null then the objects are fetched in this order of their indices
+  const std::vector<unsigned> *p_order;
   const unsigned m_NObjects;
   std::atomic_uint m_pos;
   std::atomic_bool m_IsBroken;
 
 public:
-  GOObjectDistributor(const std::vector<T *> &objects)
+  GOObjectDistributor(
+    const std::vector<T *> &objects,
+    const std::vector<unsigned> *pOrder = nullptr)
     : m_objects(objects),
+      p_order(pOrder),
       m_NObjects(objects.size()),
       m_pos(0),
       m_IsBroken(false) {}
@@ -38,18 +43,49 @@ public:
 
   bool IsComplete() const { return m_pos.load() >= m_NObjects; }
 
+  /**
+   * Sets the order of fetching the objects. Must be called before fetching
+   * @param pOrder the indices of all objects in the order of fetching. If null
+   *   then the objects are fetched in the vector order
+   */
+  void SetOrder(const std::vector<unsigned> *pOrder) { p_order = pOrder; }
+
   /**
    * The main method for fetching the next object. Each object can be fetched
    * only once. Returns nullptr when no unfetched objects exist or if m_IsBroken
    */
   T *FetchNext() {
+    unsigned pos;
+
+    return FetchNext(pos);
+  }
+
+  /**
+   * The same as FetchNext() but also returns the index of the object
+   * @param pos receives the index of the object in the vector
+   */
+  T *FetchNext(unsigned &pos) {
+    unsigned seqPos;
+
+    return FetchNext(pos, seqPos);
+  }
+
+  /**
+   * The same as FetchNext() but also returns the index of the object and how
+   * many objects had been fetched before it
+   * @param pos receives the index of the object in the vector
+   * @param seqPos receives the number of the objects fetched before
+   */
+  T *FetchNext(unsigned &pos, unsigned &seqPos) {
     T *obj = nullptr;
 
     if (!m_IsBroken.load()) {
-      unsigned pos = m_pos.fetch_add(1);
+      seqPos = m_pos.fetch_add(1);
 
-      if (pos < m_NObjects)
+      if (seqPos < m_NObjects) {
+        pos = p_order ? (*p_order)[seqPos] : seqPos;
         obj = m_objects[pos];
+      }
     }
     return obj;
   }
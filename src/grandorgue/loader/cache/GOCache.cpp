@@ -7,88 +7,288 @@
 
 #include "GOCache.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <wx/wfstream.h>
-#include <wx/zstream.h>
 
 #include "GOAlloc.h"
+#include "GOCompress.h"
 #include "GOMemoryPool.h"
 #include "go_defs.h"
 
 GOCache::GOCache(wxFile &cache_file, GOMemoryPool &pool)
-  : m_stream(0),
-    m_fstream(0),
-    m_zstream(0),
+  : m_fstream(0),
     m_pool(pool),
     m_Mapable(false),
-    m_OK(false) {
+    m_OK(false),
+    m_Pos(0),
+    m_IsFramed(false),
+    m_FrameIndex(0),
+    m_FramePos(0),
+    m_IndexEnd(0),
+    m_IndexOffset(0),
+    m_ObjectsEnd(0) {
   int magic;
 
-  m_stream = m_fstream = new wxFileInputStream(cache_file);
+  m_fstream = new wxFileInputStream(cache_file);
+  m_IndexEnd = m_fstream->GetLength();
 
   m_fstream->Read(&magic, sizeof(magic));
   if (
     m_fstream->LastRead() == sizeof(magic) && magic == GRANDORGUE_CACHE_MAGIC) {
     m_Mapable = true;
     m_OK = true;
-  } else {
-    m_fstream->SeekI(0, wxFromStart);
-    m_stream = m_zstream = new wxZlibInputStream(*m_fstream);
-    if (m_fstream->IsOk() && m_zstream->IsOk()) {
-      m_zstream->Read(&magic, sizeof(magic));
-      if (
-        m_zstream->LastRead() == sizeof(magic)
-        && magic == GRANDORGUE_CACHE_MAGIC) {
-        m_Mapable = false;
-        m_OK = true;
-      }
-    }
-  }
+    m_Pos = sizeof(magic);
+  } else if (
+    m_fstream->LastRead() == sizeof(magic)
+    && magic == GRANDORGUE_CACHE_FRAMED_MAGIC && ReadFrames() && LoadFrame(0)
+    && Read(&magic, sizeof(magic)) && magic == GRANDORGUE_CACHE_MAGIC)
+    m_OK = true;
 
-  if (!m_OK || m_stream->TellI() == wxInvalidOffset)
+  if (!m_OK || m_IsFramed || m_fstream->TellI() == wxInvalidOffset)
     m_Mapable = false;
   if (m_Mapable)
     m_Mapable = m_pool.SetCacheFile(cache_file);
 }
 
+GOCache::GOCache(wxFile &cache_file, GOMemoryPool &pool, bool isMapped)
+  : m_fstream(0),
+    m_pool(pool),
+    m_Mapable(isMapped),
+    m_OK(false),
+    m_Pos(0),
+    m_IsFramed(false),
+    m_FrameIndex(0),
+    m_FramePos(0),
+    m_IndexEnd(0),
+    m_IndexOffset(0),
+    m_ObjectsEnd(0) {
+  int magic;
+
+  m_fstream = new wxFileInputStream(cache_file);
+  m_IndexEnd = m_fstream->GetLength();
+  m_fstream->Read(&magic, sizeof(magic));
+  if (
+    m_fstream->LastRead() == sizeof(magic)
+    && magic == GRANDORGUE_CACHE_FRAMED_MAGIC)
+    m_OK = ReadFrames();
+  else
+    m_OK = m_fstream->IsOk();
+}
+
 GOCache::~GOCache() { Close(); }
 
 bool GOCache::ReadHeader() { return m_OK; }
 
 void GOCache::Close() {
-  if (m_zstream)
-    delete m_zstream;
-  m_zstream = 0;
   if (m_fstream)
     delete m_fstream;
   m_fstream = 0;
+  m_Frame.free();
+}
+
+bool GOCache::ReadFrames() {
+  const wxFileOffset length = m_fstream->GetLength();
+  // the number of the frames and the magic
+  uint32_t trailer[2];
+
+  if (
+    length == wxInvalidOffset || length < (wxFileOffset)sizeof(trailer)
+    || m_fstream->SeekI(length - sizeof(trailer)) == wxInvalidOffset
+    || m_fstream->Read(trailer, sizeof(trailer)).LastRead() != sizeof(trailer)
+    || trailer[1] != GRANDORGUE_CACHE_FRAMED_MAGIC || !trailer[0])
+    return false;
+
+  const wxFileOffset indexSize
+    = (wxFileOffset)trailer[0] * sizeof(GOCacheFrame) + sizeof(trailer);
+
+  if (length < indexSize)
+    return false;
+  m_Frames.resize(trailer[0]);
+  if (
+    m_fstream->SeekI(length - indexSize) == wxInvalidOffset
+    || m_fstream->Read(m_Frames.data(), m_Frames.size() * sizeof(GOCacheFrame))
+        .LastRead()
+      != m_Frames.size() * sizeof(GOCacheFrame)) {
+    m_Frames.clear();
+    return false;
+  }
+
+  uint64_t pos = 0;
+
+  m_FramePositions.resize(m_Frames.size());
+  for (unsigned i = 0; i < m_Frames.size(); i++) {
+    const GOCacheFrame &frame = m_Frames[i];
+
+    if (
+      frame.m_Offset + frame.m_CompressedSize
+      > (uint64_t)(length - indexSize)) {
+      m_Frames.clear();
+      m_FramePositions.clear();
+      return false;
+    }
+    m_FramePositions[i] = pos;
+    pos += frame.m_Size;
+  }
+  m_IsFramed = true;
+  m_IndexEnd = length - indexSize;
+  m_ObjectsEnd = pos;
+  m_FrameIndex = m_Frames.size();
+  return true;
+}
+
+bool GOCache::LoadFrame(unsigned index) {
+  if (index >= m_Frames.size())
+    return false;
+
+  const GOCacheFrame &frame = m_Frames[index];
+
+  m_FrameIndex = m_Frames.size();
+  m_Frame.resize(frame.m_CompressedSize);
+  if (
+    m_fstream->SeekI(frame.m_Offset, wxFromStart) == wxInvalidOffset
+    || m_fstream->Read(m_Frame.get(), m_Frame.GetSize()).LastRead()
+      != m_Frame.GetSize()
+    || !uncompressBuffer(m_Frame) || m_Frame.GetSize() != frame.m_Size) {
+    m_Frame.free();
+    return false;
+  }
+  m_FrameIndex = index;
+  m_FramePos = 0;
+  return true;
 }
 
 bool GOCache::Read(void *data, unsigned length) {
-  m_stream->Read(data, length);
-  if (m_stream->LastRead() != length)
+  // the metadata of a mapped cache is copied without the stream
+  if (m_Mapable) {
+    if (!m_pool.ReadCacheData(m_Pos, data, length))
+      return false;
+  } else if (m_IsFramed) {
+    uint8_t *dest = (uint8_t *)data;
+    unsigned rest = length;
+
+    while (rest) {
+      // an object may continue in the next frame if read sequentially
+      if (
+        m_FramePos == m_Frame.GetSize()
+        && (m_FrameIndex >= m_Frames.size() || !LoadFrame(m_FrameIndex + 1)))
+        return false;
+
+      const unsigned chunk
+        = std::min((size_t)rest, m_Frame.GetSize() - m_FramePos);
+
+      memcpy(dest, m_Frame.get() + m_FramePos, chunk);
+      m_FramePos += chunk;
+      dest += chunk;
+      rest -= chunk;
+    }
+  } else {
+    m_fstream->Read(data, length);
+    if (m_fstream->LastRead() != length)
+      return false;
+  }
+  m_Pos += length;
+  return true;
+}
+
+bool GOCache::ReadIndex(std::vector<GOCacheIndexEntry> &entries) {
+  const wxFileOffset pos = m_fstream->TellI();
+  // the number of the objects and the magic
+  uint32_t trailer[2];
+  bool isOk = m_OK && m_IndexEnd >= sizeof(trailer)
+    && m_fstream->SeekI(m_IndexEnd - sizeof(trailer)) != wxInvalidOffset
+    && m_fstream->Read(trailer, sizeof(trailer)).LastRead() == sizeof(trailer)
+    && trailer[1] == GRANDORGUE_CACHE_INDEX_MAGIC;
+  const uint64_t indexSize
+    = isOk ? trailer[0] * sizeof(GOCacheIndexEntry) + sizeof(trailer) : 0;
+
+  isOk = isOk && indexSize <= m_IndexEnd;
+  if (isOk) {
+    m_IndexOffset = m_IndexEnd - indexSize;
+    // the uncompressed objects end where the index starts
+    if (!m_IsFramed)
+      m_ObjectsEnd = m_IndexOffset;
+    entries.resize(trailer[0]);
+    isOk = m_fstream->SeekI(m_IndexOffset) != wxInvalidOffset
+      && m_fstream->Read(entries.data(), trailer[0] * sizeof(GOCacheIndexEntry))
+          .LastRead()
+        == trailer[0] * sizeof(GOCacheIndexEntry);
+    for (unsigned i = 0; isOk && i < entries.size(); i++)
+      isOk = entries[i].m_Offset <= m_ObjectsEnd;
+  }
+  m_fstream->SeekI(pos);
+  if (!isOk)
+    entries.clear();
+  return isOk;
+}
+
+bool GOCache::Seek(uint64_t offset) {
+  if (!m_OK)
+    return false;
+  if (m_IsFramed) {
+    // the last frame starting not after the offset
+    const unsigned index = std::upper_bound(
+                             m_FramePositions.begin(),
+                             m_FramePositions.end(),
+                             offset)
+      - m_FramePositions.begin() - 1;
+
+    if (index != m_FrameIndex && !LoadFrame(index))
+      return false;
+    if (offset - m_FramePositions[index] > m_Frame.GetSize())
+      return false;
+    m_FramePos = offset - m_FramePositions[index];
+  } else if (
+    !m_Mapable && m_fstream->SeekI(offset, wxFromStart) == wxInvalidOffset)
     return false;
+  m_Pos = offset;
   return true;
 }
 
 void GOCache::FreeCacheFile() {
+  if (m_Mapable)
+    // continue reading from the file
+    m_fstream->SeekI(m_Pos, wxFromStart);
   m_Mapable = false;
   m_pool.FreeCacheFile();
 }
 
-void *GOCache::ReadBlock(unsigned length) {
+bool GOCache::Skip(unsigned length) {
   if (m_Mapable) {
-    void *data = m_pool.GetCacheData(m_stream->TellI(), length);
+    m_Pos += length;
+    return true;
+  }
+
+  char buffer[1024];
+
+  while (length) {
+    const unsigned chunk = std::min(length, (unsigned)sizeof(buffer));
+
+    if (!Read(buffer, chunk))
+      return false;
+    length -= chunk;
+  }
+  return true;
+}
+
+void *GOCache::ReadBlock(unsigned length, bool isToPrefetch) {
+  if (!Skip(GOCacheWriter::getBlockPadding(m_Pos, length)))
+    return NULL;
+  if (m_Mapable) {
+    void *data = m_pool.GetCacheData(m_Pos, length, isToPrefetch);
     if (data) {
-      m_stream->SeekI(length, wxFromCurrent);
+      m_Pos += length;
       return data;
     }
+    // the mapping does not cover the block
+    return NULL;
   }
   void *data = m_pool.Alloc(length, true);
   if (data == NULL)
     throw GOOutOfMemory();
 
-  m_stream->Read(data, length);
-  if (m_stream->LastRead() != length) {
+  if (!Read(data, length)) {
     m_pool.Free(data);
     return NULL;
   }
@@ -8,28 +8,86 @@
 #ifndef GOCACHE_H_
 #define GOCACHE_H_
 
+#include <cstdint>
+#include <vector>
+
+#include "GOBuffer.h"
+#include "GOCacheWriter.h"
+
 class GOMemoryPool;
 class wxFile;
 class wxInputStream;
 
 class GOCache {
-  wxInputStream *m_stream;
   wxInputStream *m_fstream;
-  wxInputStream *m_zstream;
   GOMemoryPool &m_pool;
   bool m_Mapable;
   bool m_OK;
+  // the logical offset from the beginning of the cache
+  uint64_t m_Pos;
+
+  // the frames of a compressed cache
+  bool m_IsFramed;
+  std::vector<GOCacheFrame> m_Frames;
+  // the logical offset of the beginning of each frame
+  std::vector<uint64_t> m_FramePositions;
+  // the number of the unpacked frame. m_Frames.size() if none
+  unsigned m_FrameIndex;
+  GOBuffer<uint8_t> m_Frame;
+  size_t m_FramePos;
+
+  // where the object index ends. The frame index follows it if any
+  uint64_t m_IndexEnd;
+  // filled by ReadIndex()
+  uint64_t m_IndexOffset;
+  uint64_t m_ObjectsEnd;
+
+  /* Reads the magic and the frame index if the file is a compressed cache */
+  bool ReadFrames();
+  bool LoadFrame(unsigned index);
 
 public:
   GOCache(wxFile &cache_file, GOMemoryPool &pool);
+  /**
+   * Creates an additional reader of a cache file that is already open by
+   * another GOCache. The header is not read and the file is not mapped again
+   * @param isMapped whether the main reader has mapped the file to the pool
+   */
+  GOCache(wxFile &cache_file, GOMemoryPool &pool, bool isMapped);
   virtual ~GOCache();
 
   bool ReadHeader();
   void FreeCacheFile();
+  bool IsMapable() const { return m_Mapable; }
+
+  bool IsCompressed() const { return m_IsFramed; }
+
+  /**
+   * Reads the index of the objects written by GOCacheWriter::WriteIndex
+   * without changing the current position
+   * @param entries receives the offsets and the hashes of the objects
+   * @return false if the cache has no valid index
+   */
+  bool ReadIndex(std::vector<GOCacheIndexEntry> &entries);
+  /* Where new objects may be appended. Valid after ReadIndex() */
+  uint64_t GetIndexOffset() const { return m_IndexOffset; }
+  uint64_t GetObjectsEnd() const { return m_ObjectsEnd; }
+  const std::vector<GOCacheFrame> &GetFrames() const { return m_Frames; }
+  /**
+   * Moves to the offset from the index. A compressed cache unpacks the frame
+   * containing the offset
+   */
+  bool Seek(uint64_t offset);
 
   bool Read(void *data, unsigned length);
-  /* Allocate and read a block written by WriteBlock */
-  void *ReadBlock(unsigned length);
+  /* Skips the padding before a block */
+  bool Skip(unsigned length);
+  /**
+   * Allocate and read a block written by WriteBlock
+   * @param isToPrefetch whether to read ahead a mapped block. See
+   *   GOMemoryPool::GetCacheData()
+   */
+  void *ReadBlock(unsigned length, bool isToPrefetch = true);
 
   void Close();
 };
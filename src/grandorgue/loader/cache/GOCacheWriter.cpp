@@ -7,21 +7,47 @@
 
 #include "GOCacheWriter.h"
 
-#include <wx/zstream.h>
+#include <algorithm>
+#include <cstring>
 
+#include <wx/stream.h>
+
+#include "GOCompress.h"
 #include "go_defs.h"
 
-GOCacheWriter::GOCacheWriter(wxOutputStream &stream, bool compressed)
-  : m_zstream(0), m_stream(&stream) {
+GOCacheWriter::GOCacheWriter(
+  wxOutputStream &stream, bool compressed, unsigned nThreads)
+  : m_stream(&stream),
+    m_IsCompressed(compressed),
+    m_Pos(0),
+    m_BatchSize(0),
+    m_NextFrame(0),
+    m_FileOffset(0),
+    m_MinFileSize(0) {
   if (compressed) {
-    m_zstream = new wxZlibOutputStream(stream);
-    m_stream = m_zstream;
+    // the calling thread compresses too
+    for (unsigned i = 1; i < nThreads; i++)
+      m_Threads.push_back(new CompressThread(*this));
+    m_Batch.emplace_back();
   }
 }
 
 GOCacheWriter::~GOCacheWriter() { Close(); }
 
+bool GOCacheWriter::WriteFile(const void *data, size_t length) {
+  m_stream->Write(data, length);
+  m_FileOffset += m_stream->LastWrite();
+  return m_stream->LastWrite() == length;
+}
+
 bool GOCacheWriter::WriteHeader() {
+  if (m_IsCompressed) {
+    const uint32_t framedMagic = GRANDORGUE_CACHE_FRAMED_MAGIC;
+
+    if (!WriteFile(&framedMagic, sizeof(framedMagic)))
+      return false;
+  }
+
   int magic = GRANDORGUE_CACHE_MAGIC;
   if (!Write(&magic, sizeof(magic)))
     return false;
@@ -29,24 +55,147 @@ bool GOCacheWriter::WriteHeader() {
 }
 
 bool GOCacheWriter::Write(const void *data, unsigned length) {
+  if (m_IsCompressed) {
+    std::vector<uint8_t> &frame = m_Batch.back().m_Data;
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    frame.insert(frame.end(), bytes, bytes + length);
+    m_BatchSize += length;
+    m_Pos += length;
+    return true;
+  }
   m_stream->Write(data, length);
+  m_Pos += m_stream->LastWrite();
   if (m_stream->LastWrite() != length)
     return false;
   return true;
 }
 
+static constexpr unsigned BLOCK_ALIGN = 16384;
+static constexpr unsigned MIN_ALIGNED_BLOCK = 65536;
+static const char ZEROS[BLOCK_ALIGN] = {0};
+
+unsigned GOCacheWriter::getBlockPadding(uint64_t pos, unsigned length) {
+  if (length < MIN_ALIGNED_BLOCK)
+    return 0;
+  return (BLOCK_ALIGN - pos % BLOCK_ALIGN) % BLOCK_ALIGN;
+}
+
+bool GOCacheWriter::WritePadding(unsigned length) {
+  return !length || Write(ZEROS, length);
+}
+
 bool GOCacheWriter::WriteBlock(const void *data, unsigned length) {
-  m_stream->Write(data, length);
-  if (m_stream->LastWrite() != length)
+  if (!WritePadding(getBlockPadding(m_Pos, length)))
     return false;
-  return true;
+  return Write(data, length);
+}
+
+void GOCacheWriter::CompressFrames() {
+  unsigned i;
+
+  while ((i = m_NextFrame.fetch_add(1)) < m_Batch.size()) {
+    Frame &frame = m_Batch[i];
+
+    frame.m_Size = frame.m_Data.size();
+    frame.m_IsOk = true;
+    if (frame.m_Size) {
+      frame.m_Packed.resize(frame.m_Size);
+      memcpy(frame.m_Packed.get(), frame.m_Data.data(), frame.m_Size);
+      std::vector<uint8_t>().swap(frame.m_Data);
+      frame.m_IsOk = compressBuffer(frame.m_Packed);
+    }
+  }
+}
+
+bool GOCacheWriter::FlushBatch() {
+  m_NextFrame.store(0);
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->Start();
+  CompressFrames();
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->Wait();
+
+  bool isOk = true;
+
+  for (const Frame &frame : m_Batch) {
+    if (!frame.m_Size)
+      continue;
+
+    const GOCacheFrame entry
+      = {m_FileOffset, (uint32_t)frame.m_Packed.GetSize(), frame.m_Size};
+
+    isOk = isOk && frame.m_IsOk
+      && WriteFile(frame.m_Packed.get(), frame.m_Packed.GetSize());
+    m_Frames.push_back(entry);
+  }
+  m_Batch.clear();
+  m_BatchSize = 0;
+  return isOk;
+}
+
+void GOCacheWriter::InitAppend(
+  uint64_t pos,
+  uint64_t fileOffset,
+  const std::vector<GOCacheFrame> &frames,
+  uint64_t fileSize) {
+  m_Pos = pos;
+  m_FileOffset = fileOffset;
+  m_Frames = frames;
+  m_MinFileSize = fileSize;
+}
+
+bool GOCacheWriter::StartFrame() {
+  // empty objects do not need own frames
+  if (!m_IsCompressed || m_Batch.back().m_Data.empty())
+    return true;
+
+  bool isOk = true;
+
+  if (m_BatchSize >= BATCH_SIZE_PER_THREAD * (m_Threads.size() + 1))
+    isOk = FlushBatch();
+  m_Batch.emplace_back();
+  return isOk;
+}
+
+bool GOCacheWriter::WriteIndex(const std::vector<GOCacheIndexEntry> &entries) {
+  if (m_IsCompressed && !FlushBatch())
+    return false;
+
+  // the number of the objects and the magic
+  const uint32_t trailer[2]
+    = {(uint32_t)entries.size(), GRANDORGUE_CACHE_INDEX_MAGIC};
+  // the number of the frames and the magic
+  const uint32_t framesTrailer[2]
+    = {(uint32_t)m_Frames.size(), GRANDORGUE_CACHE_FRAMED_MAGIC};
+  const uint64_t indexSize = entries.size() * sizeof(GOCacheIndexEntry)
+    + sizeof(trailer)
+    + (m_IsCompressed
+         ? m_Frames.size() * sizeof(GOCacheFrame) + sizeof(framesTrailer)
+         : 0);
+  const uint64_t fileOffset = m_IsCompressed ? m_FileOffset : m_Pos;
+  // the rest of the file is overwritten with zeros
+  uint64_t padding = fileOffset + indexSize < m_MinFileSize
+    ? m_MinFileSize - fileOffset - indexSize
+    : 0;
+
+  for (unsigned chunk; padding; padding -= chunk) {
+    chunk = std::min(padding, (uint64_t)BLOCK_ALIGN);
+    if (!WriteFile(ZEROS, chunk))
+      return false;
+  }
+  if (
+    !WriteFile(entries.data(), entries.size() * sizeof(GOCacheIndexEntry))
+    || !WriteFile(trailer, sizeof(trailer)))
+    return false;
+  return !m_IsCompressed
+    || (WriteFile(m_Frames.data(), m_Frames.size() * sizeof(GOCacheFrame))
+        && WriteFile(framesTrailer, sizeof(framesTrailer)));
 }
 
 void GOCacheWriter::Close() {
   if (m_stream)
     m_stream->Close();
-  if (m_zstream)
-    delete m_zstream;
-  m_zstream = 0;
   m_stream = 0;
+  m_Batch.clear();
 }
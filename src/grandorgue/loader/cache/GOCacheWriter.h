@@ -8,20 +8,132 @@
 #ifndef GOCACHEWRITER_H_
 #define GOCACHEWRITER_H_
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "threading/GOThread.h"
+
+#include "GOBuffer.h"
+#include "GOHash.h"
+#include "ptrvector.h"
+
 class wxOutputStream;
 
+/* An entry of the frame index at the end of a compressed cache */
+struct GOCacheFrame {
+  // the offset of the compressed frame from the beginning of the file
+  uint64_t m_Offset;
+  uint32_t m_CompressedSize;
+  uint32_t m_Size;
+};
+
+/* An entry of the object index at the end of a cache */
+struct GOCacheIndexEntry {
+  // the logical offset of the object from the beginning of the cache
+  uint64_t m_Offset;
+  // the hash of the object settings the cached data was generated with
+  GOHashType m_Hash;
+};
+
+/**
+ * Writes a cache file.
+ *
+ * A compressed cache consists of frames that are compressed independently.
+ * The frames are collected in memory and compressed by several threads in
+ * batches, then they are written in order followed by the frame index.
+ */
 class GOCacheWriter {
-  wxOutputStream *m_zstream;
+  class CompressThread : public GOThread {
+  private:
+    GOCacheWriter &r_writer;
+
+  protected:
+    void Entry() override { r_writer.CompressFrames(); }
+
+  public:
+    CompressThread(GOCacheWriter &writer) : r_writer(writer) {}
+  };
+
+  struct Frame {
+    // released after compressing
+    std::vector<uint8_t> m_Data;
+    GOBuffer<uint8_t> m_Packed;
+    uint32_t m_Size;
+    bool m_IsOk;
+  };
+
+  // how many uncompressed bytes per thread are collected before compressing
+  static constexpr unsigned BATCH_SIZE_PER_THREAD = 16 * 1024 * 1024;
+
   wxOutputStream *m_stream;
+  bool m_IsCompressed;
+  // the number of bytes written before compression
+  uint64_t m_Pos;
+
+  // the frames not yet compressed. The last one is being filled
+  std::vector<Frame> m_Batch;
+  size_t m_BatchSize;
+  std::atomic_uint m_NextFrame;
+  ptr_vector<CompressThread> m_Threads;
+  std::vector<GOCacheFrame> m_Frames;
+  // the number of bytes written to the file
+  uint64_t m_FileOffset;
+
+  // the index is padded up to this file size
+  uint64_t m_MinFileSize;
+
+  bool WritePadding(unsigned length);
+  bool WriteFile(const void *data, size_t length);
+  void CompressFrames();
+  bool FlushBatch();
 
 public:
-  GOCacheWriter(wxOutputStream &stream, bool compressed);
+  /**
+   * Returns how many zero bytes precede a block of the length written at the
+   * position. Big sample blocks start on a page boundary, so they are mapped
+   * directly without copying and the kernel may read them ahead
+   */
+  static unsigned getBlockPadding(uint64_t pos, unsigned length);
+
+  /**
+   * @param compressed whether to write a compressed cache
+   * @param nThreads how many threads compress the frames
+   */
+  GOCacheWriter(wxOutputStream &stream, bool compressed, unsigned nThreads = 1);
   virtual ~GOCacheWriter();
 
   bool WriteHeader();
   bool Write(const void *data, unsigned length);
   /* Write an bigger malloced block */
   bool WriteBlock(const void *data, unsigned length);
+  /**
+   * Continues an existing cache instead of writing a new one. The stream must
+   * be positioned at GOCache::GetIndexOffset(). The header is not written
+   * @param pos the logical end of the objects (GOCache::GetObjectsEnd())
+   * @param fileOffset the offset of the stream from the file start
+   * @param frames the frames of a compressed cache (GOCache::GetFrames())
+   * @param fileSize the current file size. The new index ends not earlier,
+   *   so no garbage remains after it
+   */
+  void InitAppend(
+    uint64_t pos,
+    uint64_t fileOffset,
+    const std::vector<GOCacheFrame> &frames,
+    uint64_t fileSize);
+  /**
+   * Starts a new frame of a compressed cache, so the next object may be
+   * unpacked independently. Does nothing for an uncompressed cache
+   */
+  bool StartFrame();
+  /* Returns the current offset from the beginning of the cache */
+  uint64_t GetPos() const { return m_Pos; }
+  /**
+   * Writes the index of the objects, so they may be read in parallel and
+   * checked one by one. The offsets are got with GetPos() just after
+   * StartFrame(). A compressed cache also gets the index of its frames
+   */
+  bool WriteIndex(const std::vector<GOCacheIndexEntry> &entries);
 
   void Close();
 };
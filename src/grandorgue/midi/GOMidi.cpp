@@ -7,6 +7,9 @@
 
 #include "GOMidi.h"
 
+#include <chrono>
+#include <thread>
+
 #include "GOEvent.h"
 #include "GOMidiListener.h"
 #include "config/GOConfig.h"
@@ -14,13 +17,23 @@
 #include "midi/GOMidiWXEvent.h"
 #include "ports/GOMidiInPort.h"
 #include "ports/GOMidiOutPort.h"
+#include "threading/GOMutexLocker.h"
 
 BEGIN_EVENT_TABLE(GOMidi, wxEvtHandler)
 EVT_MIDI(GOMidi::OnMidiEvent)
 END_EVENT_TABLE()
 
 GOMidi::GOMidi(GOConfig &config)
-  : m_config(config), m_MidiMap(config.GetMidiMap()) {}
+  : m_config(config),
+    m_MidiMap(config.GetMidiMap()),
+    m_DispatchingListener(nullptr),
+    m_DispatchQueue(QUEUE_SIZE_BITS),
+    m_IsSpilling(false),
+    m_IsDispatchSleeping(false),
+    m_DispatchCondition(m_DispatchMutex),
+    m_DispatchThread(*this) {
+  m_DispatchThread.Start();
+}
 
 void GOMidi::UpdateDevices(const GOPortsConfig &portsConfig) {
   m_MidiFactory.addMissingInDevices(this, portsConfig, m_midi_in_devices);
@@ -30,6 +43,11 @@ void GOMidi::UpdateDevices(const GOPortsConfig &portsConfig) {
 GOMidi::~GOMidi() {
   m_midi_in_devices.clear();
   m_midi_out_devices.clear();
+  // no port calls Recv() any more
+  m_DispatchThread.MarkForStop();
+  m_IsDispatchSleeping.store(true);
+  WakeDispatchThread();
+  m_DispatchThread.Wait();
 }
 
 void GOMidi::Open() {
@@ -90,15 +108,109 @@ bool GOMidi::HasActiveDevice() {
   return false;
 }
 
+bool GOMidi::IsRealtimeEvent(const GOMidiEvent &e) {
+  // it controls the application: the timers, the recorder and so on
+  return e.GetMidiType() != GOMidiEvent::MIDI_SYSEX_JOHANNUS_ANTONIJN;
+}
+
+void GOMidi::WakeDispatchThread() {
+  // the dispatch thread checks the queue after setting the flag, so either it
+  // sees the new event or the flag is seen here
+  if (m_IsDispatchSleeping.exchange(false)) {
+    GOMutexLocker locker(m_DispatchMutex);
+
+    m_DispatchCondition.Signal();
+  }
+}
+
 void GOMidi::Recv(const GOMidiEvent &e) {
-  wxMidiEvent event(e);
+  // while there are spilled events, the new ones must follow them
+  if (m_IsSpilling.load() || !m_DispatchQueue.Push(e)) {
+    GOMutexLocker locker(m_SpillMutex);
+
+    m_SpilledEvents.push_back(e);
+    m_IsSpilling.store(true);
+  }
+  WakeDispatchThread();
+}
+
+void GOMidi::SendToRealtimeListeners(const GOMidiEvent &e) {
+  for (unsigned i = 0;; i++) {
+    GOMidiListener *listener = nullptr;
+
+    {
+      GOMutexLocker locker(m_ListenersMutex);
+
+      if (i >= m_Listeners.size())
+        break;
+      listener = m_Listeners[i];
+      if (!listener || !listener->IsRealtime())
+        continue;
+      m_DispatchingListener.store(listener);
+    }
+    // the listener takes the organ locks, and the GUI thread may hold them
+    // while registering another listener, so m_ListenersMutex is not held
+    listener->Send(e);
+    m_DispatchingListener.store(nullptr);
+  }
+}
+
+void GOMidi::DispatchEvent(const GOMidiEvent &e) {
+  if (IsRealtimeEvent(e))
+    SendToRealtimeListeners(e);
+
+  wxMidiEvent event(e, DISPATCHED_EVENT_ID);
+
   AddPendingEvent(event);
 }
 
+void GOMidi::DispatchLoop(GOThread *thread) {
+  GOMidiEvent e;
+
+  while (!thread->ShouldStop()) {
+    // the queued events are older than the spilled ones
+    while (m_DispatchQueue.Pop(e))
+      DispatchEvent(e);
+    if (m_IsSpilling.load()) {
+      {
+        GOMutexLocker locker(m_SpillMutex);
+
+        // the events received from now are queued again. They are sent after
+        // this batch
+        m_SpilledBatch.swap(m_SpilledEvents);
+        m_IsSpilling.store(false);
+      }
+      for (const GOMidiEvent &spilled : m_SpilledBatch)
+        DispatchEvent(spilled);
+      m_SpilledBatch.clear();
+      continue;
+    }
+
+    m_IsDispatchSleeping.store(true);
+    if (!m_DispatchQueue.IsEmpty() || m_IsSpilling.load()) {
+      m_IsDispatchSleeping.store(false);
+      continue;
+    }
+
+    GOMutexLocker locker(m_DispatchMutex);
+
+    // a producer clears the flag before signalling under the mutex, so no
+    // signal is lost
+    if (m_IsDispatchSleeping.load())
+      m_DispatchCondition.WaitOrStop(NULL, thread);
+    m_IsDispatchSleeping.store(false);
+  }
+}
+
 void GOMidi::OnMidiEvent(wxMidiEvent &event) {
   GOMidiEvent e = event.GetMidiEvent();
+  // the dispatch thread has already sent it to the realtime listeners
+  const bool isDispatched
+    = event.GetId() == DISPATCHED_EVENT_ID && IsRealtimeEvent(e);
+
+  // m_Listeners is changed in this thread only, so no lock is needed
   for (unsigned i = 0; i < m_Listeners.size(); i++)
-    if (m_Listeners[i])
+    if (m_Listeners[i] && !(isDispatched && m_Listeners[i]->IsRealtime()))
       m_Listeners[i]->Send(e);
 }
 
@@ -110,6 +222,9 @@ void GOMidi::Send(const GOMidiEvent &e) {
 void GOMidi::Register(GOMidiListener *listener) {
   if (!listener)
     return;
+
+  GOMutexLocker locker(m_ListenersMutex);
+
   for (unsigned i = 0; i < m_Listeners.size(); i++)
     if (m_Listeners[i] == listener)
       return;
@@ -122,8 +237,16 @@ void GOMidi::Register(GOMidiListener *listener) {
 }
 
 void GOMidi::Unregister(GOMidiListener *listener) {
-  for (unsigned i = 0; i < m_Listeners.size(); i++)
-    if (m_Listeners[i] == listener) {
-      m_Listeners[i] = NULL;
-    }
+  {
+    GOMutexLocker locker(m_ListenersMutex);
+
+    for (unsigned i = 0; i < m_Listeners.size(); i++)
+      if (m_Listeners[i] == listener) {
+        m_Listeners[i] = NULL;
+      }
+  }
+  // the dispatch thread cannot take the listener any more. Wait until it
+  // leaves the listener if it is calling it now
+  while (m_DispatchingListener.load() == listener)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
 }
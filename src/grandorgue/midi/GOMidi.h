@@ -10,10 +10,18 @@
 
 #include <wx/event.h>
 
+#include <atomic>
+#include <vector>
+
 #include "config/GOPortsConfig.h"
 #include "ports/GOMidiPortFactory.h"
+#include "threading/GOCondition.h"
+#include "threading/GOMutex.h"
+#include "threading/GOThread.h"
 #include "ptrvector.h"
 
+#include "GOMidiEventQueue.h"
+
 class GOMidiEvent;
 class GOMidiPort;
 class GOMidiListener;
@@ -22,8 +30,39 @@ class GOConfig;
 class GOOrganController;
 class wxMidiEvent;
 
+/**
+ * Receives the MIDI events from the input ports and sends them to the
+ * listeners.
+ *
+ * The port callbacks put the events to a queue without locks. A dispatch
+ * thread sends the key and stop events from it to the realtime listeners
+ * directly, so they do not wait for the GUI thread. All events are then
+ * posted to the GUI thread for the other listeners.
+ *
+ * The port callbacks never wait and never drop an event. If the queue is full,
+ * the events are put to a spill list under a mutex until the dispatch thread
+ * has taken it. The dispatch thread sends the spilled events before the
+ * events pushed to the queue later, so the order is kept. The dispatch thread
+ * is woken without a lock unless it is sleeping.
+ */
 class GOMidi : public wxEvtHandler {
 private:
+  class DispatchThread : public GOThread {
+  private:
+    GOMidi &r_midi;
+
+  protected:
+    void Entry() override { r_midi.DispatchLoop(this); }
+
+  public:
+    DispatchThread(GOMidi &midi) : r_midi(midi) {}
+  };
+
+  // the queue capacity is 2^QUEUE_SIZE_BITS events
+  static constexpr unsigned QUEUE_SIZE_BITS = 10;
+  // marks the wx events that have passed the dispatch thread
+  static constexpr int DISPATCHED_EVENT_ID = 1;
+
   GOConfig &m_config;
   GOMidiMap &m_MidiMap;
 
@@ -31,8 +70,37 @@ private:
   ptr_vector<GOMidiPort> m_midi_out_devices;
 
   int m_transpose;
+  // changed in the GUI thread only under m_ListenersMutex
   std::vector<GOMidiListener *> m_Listeners;
+  GOMutex m_ListenersMutex;
+  // the listener the dispatch thread is calling without m_ListenersMutex.
+  // It is set under m_ListenersMutex, so Unregister() may wait for it
+  std::atomic<GOMidiListener *> m_DispatchingListener;
   GOMidiPortFactory m_MidiFactory;
+
+  GOMidiEventQueue m_DispatchQueue;
+  // the events received while the queue was full. Used under m_SpillMutex
+  std::vector<GOMidiEvent> m_SpilledEvents;
+  GOMutex m_SpillMutex;
+  // whether m_SpilledEvents is not empty. New events are spilled after them
+  std::atomic_bool m_IsSpilling;
+  // the spilled events being sent. Used by the dispatch thread only
+  std::vector<GOMidiEvent> m_SpilledBatch;
+  // whether the dispatch thread is going to sleep or sleeping. Only then a
+  // producer takes m_DispatchMutex to wake it
+  std::atomic_bool m_IsDispatchSleeping;
+  GOMutex m_DispatchMutex;
+  GOCondition m_DispatchCondition;
+  DispatchThread m_DispatchThread;
+
+  /* Whether the event may be processed outside the GUI thread */
+  static bool IsRealtimeEvent(const GOMidiEvent &e);
+
+  void WakeDispatchThread();
+  void DispatchEvent(const GOMidiEvent &e);
+  void DispatchLoop(GOThread *thread);
+  /* Sends the event to the realtime listeners without m_ListenersMutex held */
+  void SendToRealtimeListeners(const GOMidiEvent &e);
   void OnMidiEvent(wxMidiEvent &event);
 
 public:
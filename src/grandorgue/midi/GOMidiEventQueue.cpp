@@ -0,0 +1,64 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOMidiEventQueue.h"
+
+GOMidiEventQueue::GOMidiEventQueue(unsigned sizeBits, unsigned initialPos)
+  : m_Mask((1u << sizeBits) - 1),
+    m_Cells(new Cell[1u << sizeBits]),
+    m_PushPos(initialPos),
+    m_PopPos(initialPos) {
+  for (unsigned i = 0; i <= m_Mask; i++) {
+    const unsigned pos = initialPos + i;
+
+    m_Cells[pos & m_Mask].m_Sequence.store(pos, std::memory_order_relaxed);
+  }
+}
+
+bool GOMidiEventQueue::Push(const GOMidiEvent &e) {
+  unsigned pos = m_PushPos.load(std::memory_order_relaxed);
+  Cell *cell;
+
+  for (;;) {
+    cell = &m_Cells[pos & m_Mask];
+
+    const int diff
+      = (int)(cell->m_Sequence.load(std::memory_order_acquire) - pos);
+
+    if (!diff) {
+      // the cell is free. Try to take the position
+      if (m_PushPos.compare_exchange_weak(
+            pos, pos + 1, std::memory_order_relaxed))
+        break;
+    } else if (diff < 0)
+      // the cell has not been popped yet since the previous round
+      return false;
+    else
+      // another producer has taken the position
+      pos = m_PushPos.load(std::memory_order_relaxed);
+  }
+  cell->m_Event = e;
+  cell->m_Sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool GOMidiEventQueue::Pop(GOMidiEvent &e) {
+  Cell *cell = &m_Cells[m_PopPos & m_Mask];
+
+  if (cell->m_Sequence.load(std::memory_order_acquire) != m_PopPos + 1)
+    return false;
+  e = cell->m_Event;
+  // free the cell for the next round
+  cell->m_Sequence.store(m_PopPos + m_Mask + 1, std::memory_order_release);
+  m_PopPos++;
+  return true;
+}
+
+bool GOMidiEventQueue::IsEmpty() const {
+  return m_Cells[m_PopPos & m_Mask].m_Sequence.load(std::memory_order_acquire)
+    != m_PopPos + 1;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOMIDIEVENTQUEUE_H
+#define GOMIDIEVENTQUEUE_H
+
+#include <atomic>
+#include <memory>
+
+#include "midi/GOMidiEvent.h"
+
+/**
+ * A bounded queue of MIDI events without locks.
+ *
+ * Several MIDI input callbacks may push concurrently. Only one thread may pop.
+ * Each cell carries a sequence number telling whether it is free for the
+ * producer of the given position or filled for the consumer.
+ */
+class GOMidiEventQueue {
+private:
+  struct Cell {
+    std::atomic_uint m_Sequence;
+    GOMidiEvent m_Event;
+  };
+
+  const unsigned m_Mask;
+  std::unique_ptr<Cell[]> m_Cells;
+  std::atomic_uint m_PushPos;
+  unsigned m_PopPos; // used by the consumer only
+
+public:
+  /* @param sizeBits the capacity is 2^sizeBits events
+   * @param initialPos the sequence number of the first event. Allows testing
+   *   the wrap-around of the sequence numbers */
+  GOMidiEventQueue(unsigned sizeBits, unsigned initialPos = 0);
+
+  /* Returns false if the queue is full */
+  bool Push(const GOMidiEvent &e);
+  /* Returns false if the queue is empty */
+  bool Pop(GOMidiEvent &e);
+  /* May be called by the consumer only */
+  bool IsEmpty() const;
+};
+
+#endif /* GOMIDIEVENTQUEUE_H */
@@ -7,15 +7,22 @@
 
 #include "GOMidiListener.h"
 
+#include <wx/thread.h>
+
 #include "GOMidi.h"
 #include "midi/GOMidiCallback.h"
 #include "midi/GOMidiEvent.h"
+#include "threading/GOMutexLocker.h"
 
-GOMidiListener::GOMidiListener() : m_Callback(NULL), m_midi(NULL) {}
+GOMidiListener::GOMidiListener(bool isRealtime)
+  : m_Callback(NULL), m_midi(NULL), m_IsRealtime(isRealtime) {}
 
 GOMidiListener::~GOMidiListener() { Unregister(); }
 
 void GOMidiListener::SetCallback(GOMidiCallback *callback) {
+  // waits until the dispatch thread leaves the previous callback
+  GOMutexLocker locker(m_CallbackMutex);
+
   m_Callback = callback;
 }
 
@@ -34,6 +41,16 @@ void GOMidiListener::Unregister() {
 }
 
 void GOMidiListener::Send(const GOMidiEvent &event) {
+  if (wxIsMainThread()) {
+    // m_Callback is changed in this thread only. Do not wait for the dispatch
+    // thread here: it may wait for the organ input mutex held by a GUI handler
+    if (m_Callback)
+      m_Callback->OnMidiEvent(event);
+    return;
+  }
+
+  GOMutexLocker locker(m_CallbackMutex);
+
   if (m_Callback)
     m_Callback->OnMidiEvent(event);
 }
@@ -8,18 +8,30 @@
 #ifndef GOMIDILISTENER_H
 #define GOMIDILISTENER_H
 
+#include "threading/GOMutex.h"
+
 class GOMidi;
 class GOMidiCallback;
 class GOMidiEvent;
 
 class GOMidiListener {
+  // protects m_Callback while it is called from the MIDI dispatch thread
+  GOMutex m_CallbackMutex;
   GOMidiCallback *m_Callback;
   GOMidi *m_midi;
+  bool m_IsRealtime;
 
 public:
-  GOMidiListener();
+  /**
+   * @param isRealtime whether the key and stop events are sent from the MIDI
+   *   dispatch thread instead of from the GUI thread. The callback must be
+   *   thread safe then
+   */
+  GOMidiListener(bool isRealtime = false);
   virtual ~GOMidiListener();
 
+  bool IsRealtime() const { return m_IsRealtime; }
+
   void SetCallback(GOMidiCallback *callback);
   void Register(GOMidi *midi);
   void Unregister();
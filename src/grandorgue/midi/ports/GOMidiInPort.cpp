@@ -25,7 +25,7 @@ GOMidiInPort::GOMidiInPort(
 
 GOMidiInPort::~GOMidiInPort() {}
 
-void GOMidiInPort::Receive(const std::vector<unsigned char> msg) {
+void GOMidiInPort::Receive(const std::vector<unsigned char> &msg) {
   if (!IsActive())
     return;
 
@@ -19,7 +19,7 @@ protected:
 
   virtual const wxString GetMyNativePortName() const;
 
-  void Receive(const std::vector<unsigned char> msg);
+  void Receive(const std::vector<unsigned char> &msg);
 
 public:
   GOMidiInPort(
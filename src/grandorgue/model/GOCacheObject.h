@@ -10,6 +10,8 @@
 
 #include <wx/string.h>
 
+#include <vector>
+
 #include "loader/GOLoaderFilename.h"
 
 class GOCache;
@@ -69,8 +71,12 @@ public:
   bool LoadFromCacheWithoutExc(GOMemoryPool &pool, GOCache &cache);
 
   virtual bool SaveCache(GOCacheWriter &cache) const = 0;
-  virtual void UpdateHash(GOHash &hash) const = 0;
+  /* Hashes everything the cached data depend on, including the files */
+  virtual void UpdateHash(const GOFileStore &fileStore, GOHash &hash) const = 0;
   virtual const wxString &GetLoadTitle() const = 0;
+  /* Adds the files read by LoadData for planning the reads */
+  virtual void CollectLoadFiles(
+    std::vector<const GOLoaderFilename *> &files) const {}
 
   // Returns the message string prefixed with group and keyPrefix
   const wxString GenerateMessage(const wxString &srcMsg) const;
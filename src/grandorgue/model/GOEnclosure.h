@@ -46,6 +46,9 @@ private:
   bool m_Displayed2;
 
   void ProcessMidi(const GOMidiEvent &event) override;
+  const GOMidiReceiverBase *GetDispatchReceiver() const override {
+    return &m_midi;
+  }
   void HandleKey(int key) override;
 
   void Save(GOConfigWriter &cfg) override;
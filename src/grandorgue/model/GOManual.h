@@ -82,6 +82,9 @@ private:
   void Resize();
 
   void ProcessMidi(const GOMidiEvent &event) override;
+  const GOMidiReceiverBase *GetDispatchReceiver() const override {
+    return &m_midi;
+  }
   void HandleKey(int key) override;
   void SetOutput(unsigned note, unsigned velocity);
 
@@ -24,7 +24,7 @@ private:
   void LoadData(const GOFileStore &fileStore, GOMemoryPool &pool) override {}
   bool LoadCache(GOMemoryPool &pool, GOCache &cache) override { return true; }
   bool SaveCache(GOCacheWriter &cache) const override { return true; }
-  void UpdateHash(GOHash &hash) const override {}
+  void UpdateHash(const GOFileStore &fileStore, GOHash &hash) const override {}
   const wxString &GetLoadTitle() const override { return m_Filename; }
 
   void VelocityChanged(unsigned velocity, unsigned old_velocity) override;
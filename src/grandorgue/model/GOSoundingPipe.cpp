@@ -326,7 +326,8 @@ bool GOSoundingPipe::SaveCache(GOCacheWriter &cache) const {
   return m_SoundProvider.SaveCache(cache);
 }
 
-void GOSoundingPipe::UpdateHash(GOHash &hash) const {
+void GOSoundingPipe::UpdateHash(
+  const GOFileStore &fileStore, GOHash &hash) const {
   hash.Update(m_Filename);
   hash.Update(m_PipeConfigNode.GetEffectiveBitsPerSample());
   hash.Update(m_PipeConfigNode.GetEffectiveCompress());
@@ -339,7 +340,7 @@ void GOSoundingPipe::UpdateHash(GOHash &hash) const {
 
   hash.Update(m_AttackFileInfos.size());
   for (const auto &a : m_AttackFileInfos) {
-    a.filename.Hash(hash);
+    a.filename.Hash(fileStore, hash);
     hash.Update(a.m_WaveTremulantStateFor);
     hash.Update(a.max_playback_time);
     hash.Update(a.load_release);
@@ -358,7 +359,7 @@ void GOSoundingPipe::UpdateHash(GOHash &hash) const {
 
   hash.Update(m_ReleaseFileInfos.size());
   for (const auto &r : m_ReleaseFileInfos) {
-    r.filename.Hash(hash);
+    r.filename.Hash(fileStore, hash);
     hash.Update(r.m_WaveTremulantStateFor);
     hash.Update(r.max_playback_time);
     hash.Update(r.cue_point);
@@ -367,6 +368,14 @@ void GOSoundingPipe::UpdateHash(GOHash &hash) const {
   }
 }
 
+void GOSoundingPipe::CollectLoadFiles(
+  std::vector<const GOLoaderFilename *> &files) const {
+  for (const auto &a : m_AttackFileInfos)
+    files.push_back(&a.filename);
+  for (const auto &r : m_ReleaseFileInfos)
+    files.push_back(&r.filename);
+}
+
 float GOSoundingPipe::GetManualTuningPitchOffset() const {
   return m_PipeConfigNode.GetEffectivePitchTuning()
     + m_PipeConfigNode.GetEffectiveManualTuning();
@@ -81,7 +81,9 @@ private:
   void LoadData(const GOFileStore &fileStore, GOMemoryPool &pool) override;
   bool LoadCache(GOMemoryPool &pool, GOCache &cache) override;
   bool SaveCache(GOCacheWriter &cache) const override;
-  void UpdateHash(GOHash &hash) const override;
+  void UpdateHash(const GOFileStore &fileStore, GOHash &hash) const override;
+  void CollectLoadFiles(
+    std::vector<const GOLoaderFilename *> &files) const override;
 
   // Callbacks from GOPipeConfigNode
   void UpdateAmplitude() override;
@@ -44,7 +44,7 @@ private:
   void LoadData(const GOFileStore &fileStore, GOMemoryPool &pool) override;
   bool LoadCache(GOMemoryPool &pool, GOCache &cache) override;
   bool SaveCache(GOCacheWriter &cache) const override { return true; }
-  void UpdateHash(GOHash &hash) const override {}
+  void UpdateHash(const GOFileStore &fileStore, GOHash &hash) const override {}
   const wxString &GetLoadTitle() const override { return m_Name; };
 
   void AbortPlayback() override;
@@ -50,8 +50,12 @@ void GOSound::StartThreads() {
   unsigned n_cpus = m_config.Concurrency();
 
   GOMutexLocker thread_locker(m_thread_lock);
+  GOSoundScheduler &scheduler = GetEngine().GetScheduler();
+
+  // each thread has its own deque of work items in the scheduler
+  scheduler.SetWorkerCount(n_cpus);
   for (unsigned i = 0; i < n_cpus; i++)
-    m_Threads.push_back(new GOSoundThread(&GetEngine().GetScheduler()));
+    m_Threads.push_back(new GOSoundThread(&scheduler, i));
 
   for (unsigned i = 0; i < m_Threads.size(); i++)
     m_Threads[i]->Run();
@@ -124,6 +128,7 @@ void GOSound::OpenSound() {
   m_SoundEngine.SetAudioGroupCount(audio_group_count);
   unsigned sample_rate = m_config.SampleRate();
   m_AudioRecorder.SetBytesPerSample(m_config.WaveFormatBytesPerSample());
+  m_AudioRecorder.SetCompressed(m_config.RecordCompressed());
   GetEngine().SetSampleRate(sample_rate);
   m_AudioRecorder.SetSampleRate(sample_rate);
   m_SoundEngine.SetAudioOutput(engine_config);
@@ -166,6 +171,7 @@ void GOSound::OpenSound() {
     }
 
     OpenMidi();
+    m_SoundEngine.GetTelemetry().Reset();
     m_NCallbacksEntered.store(0);
     StartStreams();
     StartThreads();
@@ -360,6 +366,7 @@ void GOSound::UpdateMeter() {
 
 bool GOSound::AudioCallback(
   unsigned dev_index, float *output_buffer, unsigned int n_frames) {
+  const auto callbackStart = GOSoundTelemetry::Clock::now();
   bool wasEntered = false;
 
   if (m_IsRunning.load()) {
@@ -398,6 +405,8 @@ bool GOSound::AudioCallback(
       }
       m_CalcCount.exchange(0);
       m_WaitCount.exchange(0);
+      m_SoundEngine.GetTelemetry().AddCallback(
+        callbackStart, GOSoundTelemetry::Clock::now());
 
       for (unsigned i = 0; i < m_AudioOutputs.size(); i++) {
         GOMutexLocker lock(m_AudioOutputs[i].mutex, i == dev_index);
@@ -430,5 +439,6 @@ wxString GOSound::getState() {
     m_SoundEngine.GetSampleRate());
   for (unsigned i = 0; i < m_AudioOutputs.size(); i++)
     result = result + _("\n") + m_AudioOutputs[i].port->getPortState();
+  result += wxT("\n\n") + m_SoundEngine.GetTelemetry().Format();
   return result;
 }
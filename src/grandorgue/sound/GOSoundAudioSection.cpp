@@ -7,6 +7,8 @@
 
 #include "GOSoundAudioSection.h"
 
+#include <algorithm>
+
 #include <wx/intl.h>
 #include <wx/log.h>
 
@@ -30,6 +32,11 @@
 // maximal readahead is necessary for polyphase resampling
 static constexpr unsigned MAX_READAHEAD = GOSoundResample::POLYPHASE_POINTS;
 static constexpr unsigned DEFAULT_END_SEG_LENGTH = MAX_READAHEAD * 2;
+// how long the beginning of a streamed section stays resident. It covers the
+// time the prefetcher needs for reading the following frames
+static constexpr unsigned STREAM_HEAD_MS = 500;
+// the shorter parts are not worth streaming
+static constexpr unsigned MIN_STREAMED_MS = 1000;
 
 const unsigned GOSoundAudioSection::getMaxReadAhead() { return MAX_READAHEAD; }
 
@@ -43,6 +50,8 @@ GOSoundAudioSection::GOSoundAudioSection(GOMemoryPool &pool)
 
 void GOSoundAudioSection::ClearData() {
   m_AllocSize = 0;
+  m_StreamStart = 0;
+  m_StreamEnd = 0;
   m_SampleCount = 0;
   m_SampleRate = 0;
   m_BitsPerSample = 0;
@@ -93,7 +102,11 @@ bool GOSoundAudioSection::LoadCache(GOCache &cache) {
     return false;
   if (!cache.Read(&m_ReleaseCrossfadeLength, sizeof(m_ReleaseCrossfadeLength)))
     return false;
-  m_data = (unsigned char *)cache.ReadBlock(m_AllocSize);
+  // only the uncompressed samples mapped from the cache may be streamed
+  const bool isStreamable
+    = m_Pool.IsStreaming() && !m_IsCompressed && cache.IsMapable();
+
+  m_data = (unsigned char *)cache.ReadBlock(m_AllocSize, !isStreamable);
   if (!m_data)
     return false;
 
@@ -133,10 +146,45 @@ bool GOSoundAudioSection::LoadCache(GOCache &cache) {
     if (!m_ReleaseAligner->Load(cache))
       return false;
   }
+  if (isStreamable)
+    SetupStreaming();
 
   return true;
 }
 
+void GOSoundAudioSection::SetupStreaming() {
+  // both the attack and the release start may be played from the head
+  const unsigned headStart = std::max(
+    m_StartSegments[0].start_offset,
+    m_StartSegments[m_ReleaseStartSegment].start_offset);
+  const unsigned streamStart = headStart + m_SampleRate * STREAM_HEAD_MS / 1000;
+  unsigned streamEnd = m_SampleCount;
+
+  // the loops are played many times, so they stay resident
+  for (unsigned i = 1; i < m_StartSegments.size(); i++)
+    streamEnd = std::min(streamEnd, m_StartSegments[i].start_offset);
+  for (const EndSegment &s : m_EndSegments)
+    streamEnd = std::min(streamEnd, s.transition_offset);
+
+  if (
+    streamEnd > streamStart
+    && streamEnd - streamStart >= m_SampleRate * MIN_STREAMED_MS / 1000) {
+    // the resampling window reads a few frames after the head
+    const unsigned headEnd = streamStart + MAX_READAHEAD;
+
+    m_StreamStart = streamStart;
+    m_StreamEnd = streamEnd;
+    m_Pool.AddStreamedData(
+      m_data + m_BytesPerSample * headEnd,
+      m_BytesPerSample * (m_StreamEnd - headEnd));
+    m_Pool.PrefetchCacheData(m_data, m_BytesPerSample * headEnd);
+    m_Pool.PrefetchCacheData(
+      m_data + m_BytesPerSample * m_StreamEnd,
+      m_AllocSize - m_BytesPerSample * m_StreamEnd);
+  } else
+    m_Pool.PrefetchCacheData(m_data, m_AllocSize);
+}
+
 bool GOSoundAudioSection::SaveCache(GOCacheWriter &cache) const {
   if (!cache.Write(&m_AllocSize, sizeof(m_AllocSize)))
     return false;
@@ -75,6 +75,9 @@ private:
 
   void GetMaxAmplitudeAndDerivative();
 
+  /* Chooses the streamed frames of the section mapped from the cache */
+  void SetupStreaming();
+
   void DoCrossfade(
     unsigned char *dest,
     unsigned dest_offset,
@@ -112,6 +115,11 @@ private:
   GOMemoryPool &m_Pool;
   unsigned m_AllocSize;
 
+  /* The frames [m_StreamStart, m_StreamEnd) are not kept resident. They are
+   * read ahead by GOSoundStreamPrefetcher. Equal if the section is resident */
+  unsigned m_StreamStart;
+  unsigned m_StreamEnd;
+
   unsigned m_MaxAmplitude;
   int m_MaxAbsAmplitude;
   int m_MaxAbsDerivative;
@@ -216,6 +224,10 @@ public:
 
   const unsigned char *GetData() const { return m_data; }
 
+  bool IsStreamed() const { return m_StreamStart < m_StreamEnd; }
+  unsigned GetStreamStart() const { return m_StreamStart; }
+  unsigned GetStreamEnd() const { return m_StreamEnd; }
+
   inline int GetSampleData(
     const unsigned char *sampleData, unsigned position, uint8_t channel) const {
     return getSampleData(
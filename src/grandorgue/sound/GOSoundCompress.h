@@ -119,6 +119,41 @@ static inline void DecompressionStep(
   cache.position++;
 }
 
+/* Decodes nFrames continous frames at once. The decoder state is kept in local
+ * variables while decoding, so the compiler may hold it in registers. The
+ * decoded frames are written interleaved to pOut */
+template <bool format16, unsigned channels>
+static inline void DecompressBlock(
+  DecompressionCache &cache, int *pOut, unsigned nFrames) {
+  const unsigned char *ptr = cache.ptr;
+  int value[channels];
+  int prev[channels];
+  int last[channels];
+
+  for (unsigned j = 0; j < channels; j++) {
+    value[j] = cache.value[j];
+    prev[j] = cache.prev[j];
+    last[j] = cache.last[j];
+  }
+  for (unsigned i = 0; i < nFrames; i++)
+    for (unsigned j = 0; j < channels; j++) {
+      int val
+        = format16 ? AudioReadCompressed16(ptr) : AudioReadCompressed8(ptr);
+
+      last[j] = prev[j];
+      prev[j] = value[j];
+      value[j] = prev[j] + (prev[j] - last[j]) / 2 + val;
+      *(pOut++) = value[j];
+    }
+  for (unsigned j = 0; j < channels; j++) {
+    cache.value[j] = value[j];
+    cache.prev[j] = prev[j];
+    cache.last[j] = last[j];
+  }
+  cache.ptr = ptr;
+  cache.position += nFrames;
+}
+
 static inline void DecompressTo(
   DecompressionCache &cache,
   unsigned position,
@@ -9,6 +9,8 @@
 
 #include <algorithm>
 
+#include <wx/stopwatch.h>
+
 #include "model/GOPipe.h"
 #include "model/GOWindchest.h"
 #include "sound/scheduler/GOSoundGroupTask.h"
@@ -35,6 +37,8 @@ GOSoundEngine::GOSoundEngine()
     m_Gain(1),
     m_SampleRate(0),
     m_CurrentTime(1),
+    m_PeriodStartMs(0),
+    m_EventOffset(0),
     m_SamplerPool(),
     m_AudioGroupCount(1),
     m_UsedPolyphony(0),
@@ -46,7 +50,9 @@ GOSoundEngine::GOSoundEngine()
     m_AudioOutputTasks(),
     m_AudioRecorder(NULL),
     m_TouchTask(),
+    m_StreamPrefetcher(m_Telemetry),
     m_HasBeenSetup(false) {
+  m_Scheduler.SetTelemetry(&m_Telemetry);
   m_SamplerPool.SetUsageLimit(2048);
   m_PolyphonySoftLimit = (m_SamplerPool.GetUsageLimit() * 3) / 4;
   m_ReleaseProcessor = new GOSoundReleaseTask(*this, m_AudioGroupTasks);
@@ -82,8 +88,11 @@ void GOSoundEngine::Reset() {
   }
   m_UsedPolyphony.store(0);
 
+  m_StreamPrefetcher.ReleaseAll();
   m_SamplerPool.ReturnAll();
   m_CurrentTime = 1;
+  m_PeriodStartMs.store(wxGetLocalTimeMillis().GetValue());
+  m_EventOffset = 0;
   m_Scheduler.Reset();
 }
 
@@ -96,10 +105,12 @@ float GOSoundEngine::GetGain() { return m_Gain; }
 
 void GOSoundEngine::SetSamplesPerBuffer(unsigned samples_per_buffer) {
   m_SamplesPerBuffer = samples_per_buffer;
+  m_Telemetry.SetPeriodLength(m_SamplesPerBuffer, m_SampleRate);
 }
 
 void GOSoundEngine::SetSampleRate(unsigned sample_rate) {
   m_SampleRate = sample_rate;
+  m_Telemetry.SetPeriodLength(m_SamplesPerBuffer, m_SampleRate);
 }
 
 void GOSoundEngine::SetInterpolationType(unsigned type) {
@@ -179,6 +190,7 @@ void GOSoundEngine::ClearSetup() {
   // clear the pending sound before destroying the windchests
   for (unsigned i = 0; i < m_AudioGroupTasks.size(); i++)
     m_AudioGroupTasks[i]->WaitAndClear();
+  m_StreamPrefetcher.Stop();
 
   m_Scheduler.Clear();
   m_WindchestTasks.clear();
@@ -205,25 +217,51 @@ void GOSoundEngine::Setup(
       new GOSoundWindchestTask(*this, organController->GetWindchest(i)));
   m_TouchTask = std::unique_ptr<GOSoundTouchTask>(
     new GOSoundTouchTask(organController->GetMemoryPool()));
+  // most voices play their resident loops, so they need no stream buffer
+  if (organController->GetMemoryPool().GetStreamedSize())
+    m_StreamPrefetcher.Start(
+      std::max(m_SamplerPool.GetUsageLimit() / 4, MIN_STREAM_BUFFERS));
+  else
+    m_StreamPrefetcher.Stop();
   m_HasBeenSetup.store(true);
   Reset();
 }
 
-bool GOSoundEngine::ProcessSampler(
+/* Mixing functions of a sampler for the ramp and filter combinations */
+typedef void (GOSoundFilter::FilterState::*MixBufferFunction)(
+  unsigned nFrames,
+  const float *pIn,
+  float *pOut,
+  float &volume,
+  float volumeDelta);
+
+static MixBufferFunction get_mix_buffer_function(bool isRamp, bool isFilter) {
+  if (isRamp)
+    return isFilter ? &GOSoundFilter::FilterState::MixBuffer<true, true>
+                    : &GOSoundFilter::FilterState::MixBuffer<true, false>;
+  return isFilter ? &GOSoundFilter::FilterState::MixBuffer<false, true>
+                  : &GOSoundFilter::FilterState::MixBuffer<false, false>;
+}
+
+void GOSoundEngine::RenderSampler(
   float *output_buffer,
   GOSoundSampler *sampler,
-  unsigned n_frames,
+  unsigned from,
+  unsigned to,
   float volume) {
-  float temp[n_frames * 2];
-  const bool process_sampler = (sampler->time <= m_CurrentTime);
+  if (from >= to)
+    return;
 
-  if (process_sampler) {
-    if (sampler->is_release &&
-        ((m_PolyphonyLimiting &&
-          m_SamplerPool.UsedSamplerCount() >= m_PolyphonySoftLimit &&
-          m_CurrentTime - sampler->time > 172 * 16) ||
-         sampler->drop_counter > 1))
-      sampler->fader.StartDecreasingVolume(MsToSamples(370));
+  /* The sampler is rendered by chunks of RENDER_CHUNK_FRAMES. A chunk buffer
+   * stays in L1 cache between the resampling and the mixing */
+  float temp[RENDER_CHUNK_FRAMES * 2];
+  const GOSoundFader::Ramp ramp = sampler->fader.NextRamp(to - from, volume);
+  const MixBufferFunction mixBuffer = get_mix_buffer_function(
+    !ramp.IsConstant(), sampler->toneBalanceFilterState.IsToApply());
+  float frameVolume = ramp.m_Volume;
+
+  for (unsigned i = from; i < to; i += RENDER_CHUNK_FRAMES) {
+    const unsigned nChunkFrames = std::min(to - i, RENDER_CHUNK_FRAMES);
 
     /* The decoded sampler frame will contain values containing
      * sampler->pipe_section->sample_bits worth of significant bits.
@@ -233,27 +271,65 @@ bool GOSoundEngine::ProcessSampler(
      *
      *     playback gain * (2 ^ -sampler->pipe_section->sample_bits)
      */
-    if (!sampler->stream.ReadBlock(temp, n_frames))
+    if (!sampler->stream.ReadBlock(temp, nChunkFrames))
       sampler->p_SoundProvider = NULL;
 
-    sampler->fader.Process(n_frames, temp, volume);
-    if (sampler->toneBalanceFilterState.IsToApply())
-      sampler->toneBalanceFilterState.ProcessBuffer(n_frames, temp);
+    /* Apply the volume and the tone balance filter and add these samples
+     * to the current output buffer in one pass */
+    (sampler->toneBalanceFilterState.*mixBuffer)(
+      nChunkFrames,
+      temp,
+      output_buffer + 2 * i,
+      frameVolume,
+      ramp.m_DeltaPerFrame);
+  }
+}
 
-    /* Add these samples to the current output buffer shifting
-     * right by the necessary amount to bring the sample gain back
-     * to unity (this value is computed in GOPipe.cpp)
-     */
-    for (unsigned i = 0; i < n_frames * 2; i++)
-      output_buffer[i] += temp[i];
+bool GOSoundEngine::ProcessSampler(
+  float *output_buffer,
+  GOSoundSampler *sampler,
+  unsigned n_frames,
+  float volume) {
+  const uint64_t periodEnd = m_CurrentTime + n_frames;
+  const bool process_sampler = (sampler->time < periodEnd);
+
+  if (process_sampler) {
+    if (sampler->is_release &&
+        ((m_PolyphonyLimiting &&
+          m_SamplerPool.UsedSamplerCount() >= m_PolyphonySoftLimit &&
+          sampler->time + 172 * 16 < m_CurrentTime) ||
+         sampler->drop_counter > 1))
+      sampler->fader.StartDecreasingVolume(MsToSamples(370));
 
-    if (
-      (sampler->stop && sampler->stop <= m_CurrentTime)
-      || (sampler->new_attack && sampler->new_attack <= m_CurrentTime)) {
+    // the sampler may start and begin to decay inside the period. The frames
+    // before the start are left silent
+    const unsigned startFrame = sampler->time > m_CurrentTime
+      ? (unsigned)(sampler->time - m_CurrentTime)
+      : 0;
+    unsigned decayFrame = n_frames;
+
+    if (sampler->decay_time && sampler->decay_time < periodEnd)
+      decayFrame = sampler->decay_time > m_CurrentTime + startFrame
+        ? (unsigned)(sampler->decay_time - m_CurrentTime)
+        : startFrame;
+    RenderSampler(output_buffer, sampler, startFrame, decayFrame, volume);
+    if (decayFrame < n_frames) {
+      sampler->fader.StartDecreasingVolume(sampler->decay_frames);
+      sampler->decay_time = 0;
+      RenderSampler(output_buffer, sampler, decayFrame, n_frames, volume);
+    }
+
+    if (sampler->new_attack && sampler->new_attack <= m_CurrentTime) {
       m_ReleaseProcessor->Add(sampler);
       return false;
     }
   }
+  // the stop lies in the next period. The decay is set up before it is
+  // rendered, even if the sampler has not started yet
+  if (sampler->stop && sampler->stop < periodEnd + n_frames) {
+    m_ReleaseProcessor->Add(sampler);
+    return false;
+  }
 
   if (
     !sampler->p_SoundProvider
@@ -276,6 +352,7 @@ void GOSoundEngine::ProcessRelease(GOSoundSampler *sampler) {
 }
 
 void GOSoundEngine::ReturnSampler(GOSoundSampler *sampler) {
+  sampler->stream.DetachStreamBuffer();
   m_SamplerPool.ReturnSampler(sampler);
 }
 
@@ -371,6 +448,7 @@ void GOSoundEngine::NextPeriod() {
   m_Scheduler.Exec();
 
   m_CurrentTime += m_SamplesPerBuffer;
+  m_PeriodStartMs.store(wxGetLocalTimeMillis().GetValue());
   unsigned used_samplers = m_SamplerPool.UsedSamplerCount();
   if (used_samplers > m_UsedPolyphony.load())
     m_UsedPolyphony.store(used_samplers);
@@ -380,10 +458,25 @@ void GOSoundEngine::NextPeriod() {
 
 unsigned GOSoundEngine::SamplesDiffToMs(
   uint64_t fromSamples, uint64_t toSamples) const {
+  // the start may lie in the future inside the next period
+  if (toSamples <= fromSamples)
+    return 0;
   return (unsigned)std::min(
     (toSamples - fromSamples) * 1000 / m_SampleRate, (uint64_t)UINT_MAX);
 }
 
+unsigned GOSoundEngine::GetPeriodOffset(GOTime eventTime) const {
+  const int64_t elapsedMs
+    = eventTime.GetValue() - m_PeriodStartMs.load(std::memory_order_relaxed);
+
+  if (elapsedMs <= 0)
+    return 0;
+  // an event received after the period had to be rendered starts at its end
+  return (unsigned)std::min(
+    (uint64_t)elapsedMs * m_SampleRate / 1000,
+    (uint64_t)m_SamplesPerBuffer - 1);
+}
+
 GOSoundSampler *GOSoundEngine::CreateTaskSample(
   const GOSoundProvider *pSoundProvider,
   int samplerTaskId,
@@ -394,7 +487,10 @@ GOSoundSampler *GOSoundEngine::CreateTaskSample(
   bool isRelease,
   uint64_t *pStartTimeSamples) {
   unsigned delay_samples = (delay * m_SampleRate) / (1000);
-  uint64_t start_time = m_CurrentTime + delay_samples;
+  // the current period may be being rendered now, so the sampler starts in
+  // the next one
+  uint64_t start_time
+    = m_CurrentTime + m_SamplesPerBuffer + m_EventOffset + delay_samples;
   unsigned eventIntervalMs = SamplesDiffToMs(prevEventTime, start_time);
 
   GOSoundSampler *sampler = nullptr;
@@ -416,6 +512,7 @@ GOSoundSampler *GOSoundEngine::CreateTaskSample(
         section,
         m_interpolation,
         GetRandomFactor() * pSoundProvider->GetTuning() / (float)m_SampleRate);
+      sampler->stream.AttachStreamBuffer(m_StreamPrefetcher);
 
       const float playback_gain
         = pSoundProvider->GetGain() * section->GetNormGain();
@@ -460,10 +557,13 @@ void GOSoundEngine::SwitchToAnotherAttack(GOSoundSampler *pSampler) {
 
         // start new section stream in the old sampler
         pSampler->m_WaveTremulantStateFor = section->GetWaveTremulantStateFor();
+        // the stream buffer of the old section has been copied to new_sampler
         pSampler->stream.InitAlignedStream(
           section, m_interpolation, &new_sampler->stream);
+        pSampler->stream.AttachStreamBuffer(m_StreamPrefetcher);
         pSampler->p_SoundProvider = pProvider;
-        pSampler->time = m_CurrentTime + 1;
+        // from the next period
+        pSampler->time = m_CurrentTime + m_SamplesPerBuffer;
 
         pSampler->fader.Setup(
           gain_target,
@@ -491,14 +591,22 @@ void GOSoundEngine::CreateReleaseSampler(GOSoundSampler *handle) {
    * automatically be placed back in the pool when the fade restores to
    * zero. */
   const GOSoundProvider *this_pipe = handle->p_SoundProvider;
-  const GOSoundAudioSection *release_section = this_pipe->GetRelease(
-    handle->m_WaveTremulantStateFor,
-    SamplesDiffToMs(handle->time, m_CurrentTime));
+  /* The current period has already been rendered. The stop has been
+   * scheduled into the next one, so the release starts exactly at it. A stop
+   * that came too late starts the release at the beginning of the next
+   * period */
+  const uint64_t releaseTime
+    = std::max((uint64_t)handle->stop, m_CurrentTime + m_SamplesPerBuffer);
+  const unsigned noteMs = SamplesDiffToMs(handle->time, releaseTime);
+  const GOSoundAudioSection *release_section
+    = this_pipe->GetRelease(handle->m_WaveTremulantStateFor, noteMs);
   unsigned crossFadeSamples = MsToSamples(
     release_section ? release_section->GetReleaseCrossfadeLength()
                     : this_pipe->GetAttackSwitchCrossfadeLength());
 
-  handle->fader.StartDecreasingVolume(crossFadeSamples);
+  // ProcessSampler starts the decay at releaseTime
+  handle->decay_time = releaseTime;
+  handle->decay_frames = crossFadeSamples;
   handle->is_release = true;
 
   int taskId = handle->m_SamplerTaskId;
@@ -513,7 +621,7 @@ void GOSoundEngine::CreateReleaseSampler(GOSoundSampler *handle) {
     GOSoundSampler *new_sampler = m_SamplerPool.GetSampler();
     if (new_sampler != NULL) {
       new_sampler->p_SoundProvider = this_pipe;
-      new_sampler->time = m_CurrentTime + 1;
+      new_sampler->time = releaseTime;
       new_sampler->m_WaveTremulantStateFor
         = release_section->GetWaveTremulantStateFor();
 
@@ -530,7 +638,7 @@ void GOSoundEngine::CreateReleaseSampler(GOSoundSampler *handle) {
         gain_target *= vol;
         if (m_ScaledReleases) {
           /* Note: "time" is in milliseconds. */
-          int time = ((m_CurrentTime - handle->time) * 1000) / m_SampleRate;
+          int time = noteMs;
           /* TODO: below code should be replaced by a more accurate model of the
            * attack to get a better estimate of the amplitude when playing very
            * short notes estimating attack duration from pipe midi pitch */
@@ -609,6 +717,7 @@ void GOSoundEngine::CreateReleaseSampler(GOSoundSampler *handle) {
           m_interpolation,
           this_pipe->GetTuning() / (float)m_SampleRate);
       }
+      new_sampler->stream.AttachStreamBuffer(m_StreamPrefetcher);
       new_sampler->is_release = true;
 
       new_sampler->m_SamplerTaskId = not_a_tremulant
@@ -623,7 +732,9 @@ void GOSoundEngine::CreateReleaseSampler(GOSoundSampler *handle) {
       new_sampler->toneBalanceFilterState.Init(
         new_sampler->p_SoundProvider->GetToneBalance()->GetFilter());
       StartSampler(new_sampler);
-      handle->time = m_CurrentTime;
+      // the handle may not have started yet
+      if (handle->time < m_CurrentTime)
+        handle->time = m_CurrentTime;
     }
   }
 }
@@ -640,7 +751,9 @@ uint64_t GOSoundEngine::StopSample(
   if (pipe != handle->p_SoundProvider)
     return 0;
 
-  handle->stop = m_CurrentTime + handle->delay;
+  // in the next period like the start in CreateTaskSample
+  handle->stop
+    = m_CurrentTime + m_SamplesPerBuffer + m_EventOffset + handle->delay;
   return handle->stop;
 }
 
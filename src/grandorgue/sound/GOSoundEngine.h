@@ -11,11 +11,16 @@
 #include <atomic>
 #include <vector>
 
+#include "GOTime.h"
+#include "ptrvector.h"
+
 #include "scheduler/GOSoundScheduler.h"
 
 #include "GOSoundResample.h"
 #include "GOSoundSampler.h"
 #include "GOSoundSamplerPool.h"
+#include "GOSoundStreamPrefetcher.h"
+#include "GOSoundTelemetry.h"
 
 class GOWindchest;
 class GOSoundProvider;
@@ -38,6 +43,10 @@ typedef struct {
 class GOSoundEngine {
 private:
   static constexpr int DETACHED_RELEASE_TASK_ID = 0;
+  /* Number of frames of one sampler rendered at once. The render buffer of
+   * such size fits into L1 cache */
+  static constexpr unsigned RENDER_CHUNK_FRAMES = 128;
+  static constexpr unsigned MIN_STREAM_BUFFERS = 16;
 
   unsigned m_PolyphonySoftLimit;
   bool m_PolyphonyLimiting;
@@ -51,6 +60,10 @@ private:
 
   // time in samples
   uint64_t m_CurrentTime;
+  // the local time in ms when m_CurrentTime became the next period to render
+  std::atomic<int64_t> m_PeriodStartMs;
+  // the offset in the next period of the input event being processed
+  unsigned m_EventOffset;
   GOSoundSamplerPool m_SamplerPool;
   unsigned m_AudioGroupCount;
   std::atomic_uint m_UsedPolyphony;
@@ -64,6 +77,8 @@ private:
   GOSoundReleaseTask *m_ReleaseProcessor;
   std::unique_ptr<GOSoundTouchTask> m_TouchTask;
   GOSoundScheduler m_Scheduler;
+  GOSoundTelemetry m_Telemetry;
+  GOSoundStreamPrefetcher m_StreamPrefetcher;
 
   GOSoundResample m_resample;
   GOSoundResample::InterpolationType m_interpolation;
@@ -90,6 +105,13 @@ private:
   }
 
   void StartSampler(GOSoundSampler *sampler);
+  /* Renders the frames [from, to) of the period and mixes them to the output */
+  void RenderSampler(
+    float *output_buffer,
+    GOSoundSampler *sampler,
+    unsigned from,
+    unsigned to,
+    float volume);
 
   GOSoundSampler *CreateTaskSample(
     const GOSoundProvider *soundProvider,
@@ -164,6 +186,19 @@ public:
       tremProvider, -tremulantN, 0, 0x7f, 0, prevEventTime, false, nullptr);
   }
 
+  /**
+   * Converts the time of an input event to the frame offset in the next
+   * period. The events received during one period keep their distances
+   * instead of sounding all at the period start
+   */
+  unsigned GetPeriodOffset(GOTime eventTime) const;
+  GOTime GetPeriodStartTime() const { return m_PeriodStartMs.load(); }
+  /**
+   * Sets the frame offset in the next period where the samplers started and
+   * stopped until the next call
+   */
+  void SetEventOffset(unsigned offset) { m_EventOffset = offset; }
+
   uint64_t StopSample(const GOSoundProvider *pipe, GOSoundSampler *handle);
   void SwitchSample(const GOSoundProvider *pipe, GOSoundSampler *handle);
   void UpdateVelocity(
@@ -175,6 +210,7 @@ public:
     float *output_buffer, unsigned n_frames, unsigned audio_output, bool last);
   void NextPeriod();
   GOSoundScheduler &GetScheduler();
+  GOSoundTelemetry &GetTelemetry() { return m_Telemetry; }
 
   bool ProcessSampler(
     float *buffer, GOSoundSampler *sampler, unsigned n_frames, float volume);
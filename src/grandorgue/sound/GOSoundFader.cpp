@@ -22,16 +22,14 @@ void GOSoundFader::Setup(
   }
   m_DecreasingDeltaPerFrame = 0.0f;
   m_VelocityVolume = velocityVolume;
-  m_LastExternalVolumePoint = -1; // will be set on the first Process() call
+  m_LastExternalVolumePoint = -1; // will be set on the first NextRamp() call
 }
 
 // if the external volume is changed, do it smoothly in this number of frames
 static constexpr unsigned EXTERNAL_VOLUME_CHANGE_FRAMES = 1024;
 
-void GOSoundFader::Process(
-  unsigned nFrames, float *buffer, float externalVolume) {
-  // setup process
-
+GOSoundFader::Ramp GOSoundFader::NextRamp(
+  unsigned nFrames, float externalVolume) {
   // Consider the velocity volume as part of the external volume
   externalVolume *= m_VelocityVolume;
 
@@ -56,7 +54,7 @@ void GOSoundFader::Process(
       m_DecreasingDeltaPerFrame = 0.0f;
   }
 
-  if (m_LastExternalVolumePoint < 0.0f) // The first Process() call
+  if (m_LastExternalVolumePoint < 0.0f) // The first NextRamp() call
     m_LastExternalVolumePoint = externalVolume;
 
   float startExternalVolumePoint = m_LastExternalVolumePoint;
@@ -69,28 +67,18 @@ void GOSoundFader::Process(
       * std::max(nFrames, EXTERNAL_VOLUME_CHANGE_FRAMES)
       / EXTERNAL_VOLUME_CHANGE_FRAMES;
 
-  float frameTotalVolume = startTargetVolumePoint * startExternalVolumePoint;
+  Ramp ramp;
 
-  // Process data
+  ramp.m_Volume = startTargetVolumePoint * startExternalVolumePoint;
   if (
     (m_LastTargetVolumePoint == startTargetVolumePoint)
-    && (m_LastExternalVolumePoint == startExternalVolumePoint)) {
-    // Adjust the buffer by frameTotalVolume
-    for (unsigned int i = 0; i < nFrames; i++, buffer += 2) {
-      buffer[0] *= frameTotalVolume;
-      buffer[1] *= frameTotalVolume;
-    }
-  } else {
-    // Adjust the buffer smoothly from frameTotalVolume to
+    && (m_LastExternalVolumePoint == startExternalVolumePoint))
+    ramp.m_DeltaPerFrame = 0.0f;
+  else
+    // Adjust the volume smoothly from ramp.m_Volume to
     // m_LastTargetVolumePoint * m_LastExternalVolumePoint
-    float frameTotalVolumeDelta // changing the volume by one frame
-      = (m_LastTargetVolumePoint * m_LastExternalVolumePoint - frameTotalVolume)
+    ramp.m_DeltaPerFrame
+      = (m_LastTargetVolumePoint * m_LastExternalVolumePoint - ramp.m_Volume)
       / nFrames;
-
-    for (unsigned int i = 0; i < nFrames; i++, buffer += 2) {
-      buffer[0] *= frameTotalVolume;
-      buffer[1] *= frameTotalVolume;
-      frameTotalVolume += frameTotalVolumeDelta;
-    }
-  }
+  return ramp;
 }
@@ -30,7 +30,7 @@
  *   ReleseTail limitation is used
  *
  * totalVol = targetVolume * externalVolume
- * This volume is applied in the Process() call
+ * This volume is calculated in the NextRamp() call and applied by the caller
  */
 
 class GOSoundFader {
@@ -46,7 +46,7 @@ private:
   // a volume delta for one frame when decreasing
   float m_DecreasingDeltaPerFrame;
 
-  // Last volume points are the volumes at the end of previous Process()
+  // Last volume points are the volumes at the end of previous NextRamp()
   float m_LastTargetVolumePoint;
   float m_LastExternalVolumePoint;
 
@@ -77,7 +77,27 @@ public:
   inline float GetVelocityVolume() const { return m_VelocityVolume; }
   inline void SetVelocityVolume(float volume) { m_VelocityVolume = volume; }
 
-  void Process(unsigned nFrames, float *buffer, float externalVolume);
+  /**
+   * The total volume of the frames of one period. It changes linearly
+   */
+  struct Ramp {
+    // the volume of the first frame
+    float m_Volume;
+    // the volume change per frame. 0 if the volume is constant
+    float m_DeltaPerFrame;
+
+    inline bool IsConstant() const { return m_DeltaPerFrame == 0.0f; }
+  };
+
+  /**
+   * Calculates the volume ramp of the next nFrames and advances the fader
+   * state to the end of them. The ramp must be applied to the frames by the
+   * caller
+   * @param nFrames the number of frames in the period
+   * @param externalVolume the volume to be applied in addition
+   * @return the volume ramp
+   */
+  Ramp NextRamp(unsigned nFrames, float externalVolume);
 
   bool IsSilent() const { return (m_LastTargetVolumePoint <= 0.0f); }
 };
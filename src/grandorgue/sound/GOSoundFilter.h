@@ -25,17 +25,53 @@ public:
     FilterState() { Init(nullptr); }
     void Init(const GOSoundFilter *filter);
     bool IsToApply() { return p_filter && p_filter->IsToApply(); }
-    inline void ProcessBuffer(unsigned n_blocks, float *buffer) {
-      float out[2];
-      for (unsigned int i = 0; i < n_blocks; i++, buffer += 2) {
-        out[0] = p_filter->m_B0 * buffer[0] + m_state[0];
-        out[1] = p_filter->m_B0 * buffer[1] + m_state[1];
-        m_state[0] = p_filter->m_B1 * buffer[0] - p_filter->m_A1 * out[0];
-        m_state[1] = p_filter->m_B1 * buffer[1] - p_filter->m_A1 * out[1];
 
-        buffer[0] = out[0];
-        buffer[1] = out[1];
+    /**
+     * The fused render kernel of a sampler. Multiplies the stereo frames by
+     * the volume ramp, filters them if isFilter and adds them to the output
+     * in one pass
+     * @param nFrames the number of frames to process
+     * @param pIn the frames to process
+     * @param pOut the frames to add the result to
+     * @param volume the volume of the first frame. On return it contains the
+     *   volume of the next frame
+     * @param volumeDelta the volume change per frame. Used only if isRamp
+     */
+    template <bool isRamp, bool isFilter>
+    inline void MixBuffer(
+      unsigned nFrames,
+      const float *pIn,
+      float *pOut,
+      float &volume,
+      float volumeDelta) {
+      const double b0 = isFilter ? p_filter->m_B0 : 0.0;
+      const double b1 = isFilter ? p_filter->m_B1 : 0.0;
+      const double a1 = isFilter ? p_filter->m_A1 : 0.0;
+      float state0 = m_state[0];
+      float state1 = m_state[1];
+      float frameVolume = volume;
+
+      for (unsigned i = 0; i < nFrames; i++, pIn += 2, pOut += 2) {
+        float left = pIn[0] * frameVolume;
+        float right = pIn[1] * frameVolume;
+
+        if (isFilter) {
+          const float outLeft = b0 * left + state0;
+          const float outRight = b0 * right + state1;
+
+          state0 = b1 * left - a1 * outLeft;
+          state1 = b1 * right - a1 * outRight;
+          left = outLeft;
+          right = outRight;
+        }
+        pOut[0] += left;
+        pOut[1] += right;
+        if (isRamp)
+          frameVolume += volumeDelta;
       }
+      m_state[0] = state0;
+      m_state[1] = state1;
+      volume = frameVolume;
     }
 
   private:
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -10,6 +10,12 @@
 #include <wx/intl.h>
 #include <wx/log.h>
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
 #include "GOSoundBufferItem.h"
 #include "GOWaveTypes.h"
 #include "threading/GOMutexLocker.h"
@@ -33,22 +39,30 @@ GOSoundRecorder::GOSoundRecorder()
     m_Channels(2),
     m_BytesPerSample(4),
     m_BufferSize(0),
-    m_BufferPos(0),
     m_SamplesPerBuffer(1024),
+    m_IsCompressed(false),
+    m_IsBlocking(false),
     m_Recording(false),
-    m_Buffer(0) {
+    m_Done(false),
+    m_Stop(false),
+    m_RingSlots(0),
+    m_WriteSlot(0),
+    m_ReadSlot(0),
+    m_PendingGap(0),
+    m_OverflowCount(0),
+    m_WriterThread(*this),
+    m_DataSize(0),
+    m_IsWriteError(false) {
   SetupBuffer();
 }
 
-GOSoundRecorder::~GOSoundRecorder() {
-  Close();
-  if (m_Buffer)
-    delete[] m_Buffer;
-}
+GOSoundRecorder::~GOSoundRecorder() { Close(); }
 
-struct_WAVE GOSoundRecorder::generateHeader(unsigned datasize) {
+struct_WAVE GOSoundRecorder::generateHeader(uint64_t datasize) {
+  // the sizes in the RIFF header are 32 bit
+  const unsigned size = (unsigned)std::min(datasize, (uint64_t)UINT_MAX - 36);
   struct_WAVE WAVE = {
-    {WAVE_TYPE_RIFF, datasize + 36},
+    {WAVE_TYPE_RIFF, size + 36},
     WAVE_TYPE_WAVE,
     {WAVE_TYPE_FMT, 16},
     {m_BytesPerSample == 4 ? 3 : 1,
@@ -57,13 +71,11 @@ struct_WAVE GOSoundRecorder::generateHeader(unsigned datasize) {
      m_SampleRate * m_BytesPerSample * m_Channels,
      m_BytesPerSample * m_Channels,
      8 * m_BytesPerSample},
-    {WAVE_TYPE_DATA, datasize}};
+    {WAVE_TYPE_DATA, size}};
   return WAVE;
 }
 
 void GOSoundRecorder::Open(wxString filename) {
-  struct_WAVE WAVE = generateHeader(0);
-
   Close();
 
   GOMutexLocker locker(m_lock);
@@ -73,11 +85,43 @@ void GOSoundRecorder::Open(wxString filename) {
     wxLogError(_("Unable to open file %s for writing"), filename.c_str());
     return;
   }
-  m_file.Write(&WAVE, sizeof(WAVE));
+  m_FileName = filename;
+  m_DataSize = 0;
+  m_IsWriteError = false;
+  if (m_IsCompressed) {
+    if (!m_WavPack.InitStream(
+          m_Channels,
+          8 * m_BytesPerSample,
+          m_BytesPerSample,
+          m_SampleRate,
+          m_BytesPerSample == 4)) {
+      wxLogError(_("Unable to initialize WavPack for %s"), filename.c_str());
+      m_file.Close();
+      return;
+    }
+  } else {
+    struct_WAVE WAVE = generateHeader(0);
+
+    WriteFile(&WAVE, sizeof(WAVE));
+  }
+
+  // all memory is allocated here, so the sound threads never allocate
+  m_RingSlots = std::max(
+    RING_SECONDS * m_SampleRate / std::max(m_SamplesPerBuffer, 1u),
+    MIN_RING_SLOTS);
+  m_Ring.assign(m_RingSlots * m_BufferSize, 0);
+  m_SlotGaps.assign(m_RingSlots, 0);
+  m_WriteSlot.store(0);
+  m_ReadSlot.store(0);
+  m_PendingGap = 0;
+  m_OverflowCount.store(0);
+  m_PackBuffer.resize(m_SamplesPerBuffer * m_Channels);
+  // 8 bit WAV samples are unsigned
+  m_Silence.assign(m_BufferSize, m_BytesPerSample == 1 ? 0x80 : 0);
+  m_WriterThread.Start();
 
   GOMutexLocker lock(m_Mutex);
   m_Recording = true;
-  m_BufferPos = 0;
 }
 
 bool GOSoundRecorder::IsOpen() { return m_Recording; }
@@ -90,11 +134,37 @@ void GOSoundRecorder::Close() {
   }
   if (!m_file.IsOpened())
     return;
-  struct_WAVE WAVE = generateHeader(m_BufferPos);
-  m_file.Seek(0);
-  m_file.Write(&WAVE, sizeof(WAVE));
+  // the writer thread drains the ring before exit
+  m_WriterThread.Stop();
+  if (m_IsCompressed) {
+    GOBuffer<uint8_t> firstBlock;
+
+    if (!m_WavPack.FinishStream(firstBlock))
+      m_IsWriteError = true;
+    WriteCompressedOutput();
+    // the first block now contains the length of the stream
+    if (firstBlock.GetSize()) {
+      m_file.Seek(0);
+      WriteFile(firstBlock.get(), firstBlock.GetSize());
+    }
+  } else {
+    struct_WAVE WAVE = generateHeader(m_DataSize);
+
+    m_file.Seek(0);
+    WriteFile(&WAVE, sizeof(WAVE));
+  }
   m_file.Flush();
   m_file.Close();
+  if (m_IsWriteError)
+    wxLogError(_("Unable to write the recording %s"), m_FileName.c_str());
+  if (m_OverflowCount.load())
+    wxLogWarning(
+      _("%u periods of the recording %s have been replaced with silence "
+        "because the disk was too slow"),
+      m_OverflowCount.load(),
+      m_FileName.c_str());
+  m_Ring.clear();
+  m_Ring.shrink_to_fit();
 }
 
 void GOSoundRecorder::SetSampleRate(unsigned sample_rate) {
@@ -108,6 +178,15 @@ void GOSoundRecorder::SetBytesPerSample(unsigned value) {
   SetupBuffer();
 }
 
+void GOSoundRecorder::SetCompressed(bool isCompressed) {
+  Close();
+  m_IsCompressed = isCompressed;
+}
+
+wxString GOSoundRecorder::GetFileExtension() const {
+  return m_IsCompressed ? wxT("wv") : wxT("wav");
+}
+
 void GOSoundRecorder::SetOutputs(
   std::vector<GOSoundBufferItem *> outputs, unsigned samples_per_buffer) {
   m_Outputs = outputs;
@@ -117,13 +196,10 @@ void GOSoundRecorder::SetOutputs(
 
 void GOSoundRecorder::SetupBuffer() {
   Close();
-  if (m_Buffer)
-    delete[] m_Buffer;
   m_Channels = 0;
   for (unsigned i = 0; i < m_Outputs.size(); i++)
     m_Channels += m_Outputs[i]->GetChannels();
   m_BufferSize = m_SamplesPerBuffer * m_Channels * m_BytesPerSample;
-  m_Buffer = new char[m_BufferSize];
 }
 
 static inline int float_to_fixed(float f, unsigned fractional_bits) {
@@ -151,9 +227,9 @@ static void convertValue(float value, GOInt8 &result) {
 
 static void convertValue(float value, float &result) { result = value; }
 
-template <class T> void GOSoundRecorder::ConvertData() {
+template <class T> void GOSoundRecorder::ConvertData(char *buffer) {
   unsigned start_pos = 0;
-  T *buf = (T *)m_Buffer;
+  T *buf = (T *)buffer;
   for (unsigned i = 0; i < m_Outputs.size(); i++) {
     m_Outputs[i]->Finish(m_Stop.load());
 
@@ -186,23 +262,115 @@ void GOSoundRecorder::Run(GOSoundThread *thread) {
   if (!m_Recording)
     return;
 
+  const unsigned writeSlot = m_WriteSlot.load(std::memory_order_relaxed);
+
+  // the writer thread drains the ring while it is recording
+  while (m_IsBlocking
+         && writeSlot - m_ReadSlot.load(std::memory_order_acquire)
+           >= m_RingSlots)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  if (writeSlot - m_ReadSlot.load(std::memory_order_acquire) >= m_RingSlots) {
+    // the writer thread does not keep up. Drop the period
+    m_PendingGap++;
+    m_OverflowCount.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    const unsigned index = writeSlot % m_RingSlots;
+    char *buffer = m_Ring.data() + index * m_BufferSize;
+
+    switch (m_BytesPerSample) {
+    case 1:
+      ConvertData<GOInt8>(buffer);
+      break;
+    case 2:
+      ConvertData<GOInt16LE>(buffer);
+      break;
+    case 3:
+      ConvertData<GOInt24LE>(buffer);
+      break;
+    case 4:
+      ConvertData<float>(buffer);
+      break;
+    }
+    m_SlotGaps[index] = m_PendingGap;
+    m_PendingGap = 0;
+    // publish the slot to the writer thread
+    m_WriteSlot.store(writeSlot + 1, std::memory_order_release);
+  }
+  m_Done = true;
+}
+
+void GOSoundRecorder::WriterLoop(GOThread *thread) {
+  while (true) {
+    // check before writing, so the periods put before the stop are written
+    const bool isStopping = thread->ShouldStop();
+
+    WritePendingSlots();
+    if (isStopping)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+void GOSoundRecorder::WritePendingSlots() {
+  unsigned readSlot = m_ReadSlot.load(std::memory_order_relaxed);
+  const unsigned writeSlot = m_WriteSlot.load(std::memory_order_acquire);
+
+  for (; readSlot != writeSlot; readSlot++) {
+    const unsigned index = readSlot % m_RingSlots;
+
+    for (unsigned i = 0; i < m_SlotGaps[index]; i++)
+      WritePeriod(m_Silence.data());
+    WritePeriod(m_Ring.data() + index * m_BufferSize);
+    // give the slot back to the sound threads
+    m_ReadSlot.store(readSlot + 1, std::memory_order_release);
+  }
+  if (m_IsCompressed)
+    WriteCompressedOutput();
+}
+
+void GOSoundRecorder::WritePeriod(const char *data) {
+  if (!m_IsCompressed) {
+    WriteFile(data, m_BufferSize);
+    m_DataSize += m_BufferSize;
+    return;
+  }
+
+  const unsigned nValues = m_SamplesPerBuffer * m_Channels;
+  int32_t *values = m_PackBuffer.data();
+
   switch (m_BytesPerSample) {
   case 1:
-    ConvertData<GOInt8>();
+    for (unsigned i = 0; i < nValues; i++)
+      values[i] = (int32_t)(uint8_t)data[i] - 128;
     break;
   case 2:
-    ConvertData<GOInt16LE>();
+    for (unsigned i = 0; i < nValues; i++)
+      values[i] = (int16_t)((const GOInt16LE *)data)[i];
     break;
   case 3:
-    ConvertData<GOInt24LE>();
+    for (unsigned i = 0; i < nValues; i++)
+      values[i] = (int)((GOInt24LE *)data)[i];
     break;
   case 4:
-    ConvertData<float>();
+    // WavPack takes the float samples as their bit patterns
+    memcpy(values, data, nValues * sizeof(int32_t));
     break;
   }
-  m_file.Write(m_Buffer, m_BufferSize);
-  m_BufferPos += m_BufferSize;
-  m_Done = true;
+  if (!m_WavPack.AddStreamSamples(values, m_SamplesPerBuffer))
+    m_IsWriteError = true;
+}
+
+void GOSoundRecorder::WriteCompressedOutput() {
+  GOBuffer<uint8_t> output;
+
+  m_WavPack.TakeOutput(output);
+  if (output.GetSize())
+    WriteFile(output.get(), output.GetSize());
+}
+
+void GOSoundRecorder::WriteFile(const void *data, size_t size) {
+  if (m_file.Write(data, size) != size)
+    m_IsWriteError = true;
 }
 
 void GOSoundRecorder::Exec() {
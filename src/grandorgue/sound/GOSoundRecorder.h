@@ -12,34 +12,91 @@
 #include <wx/string.h>
 
 #include <atomic>
+#include <cstdint>
 #include <vector>
 
 #include "sound/scheduler/GOSoundTask.h"
 #include "threading/GOMutex.h"
+#include "threading/GOThread.h"
+
+#include "GOWavPackWriter.h"
 
 class GOSoundBufferItem;
 struct struct_WAVE;
 
+/**
+ * Records the sound outputs to a WAV or WavPack file.
+ *
+ * The recorder task only converts the samples of the period into a slot of a
+ * lock-free single-producer single-consumer ring. A separate writer thread
+ * drains the ring to the disk, so disk stalls never block the sound threads.
+ * When the ring is full, the period is dropped and counted. The writer thread
+ * writes silence in place of the dropped periods, so the recording keeps in
+ * time. A blocking recorder waits for a free slot instead, for rendering
+ * faster than realtime.
+ */
 class GOSoundRecorder : public GOSoundTask {
 private:
+  class WriterThread : public GOThread {
+  private:
+    GOSoundRecorder &r_recorder;
+
+  protected:
+    void Entry() override { r_recorder.WriterLoop(this); }
+
+  public:
+    WriterThread(GOSoundRecorder &recorder) : r_recorder(recorder) {}
+  };
+
+  // how much audio the ring may hold while the disk is busy
+  static constexpr unsigned RING_SECONDS = 4;
+  static constexpr unsigned MIN_RING_SLOTS = 8;
+
   wxFile m_file;
+  wxString m_FileName;
   GOMutex m_lock;
   GOMutex m_Mutex;
   unsigned m_SampleRate;
   unsigned m_Channels;
   unsigned m_BytesPerSample;
+  // the size of one period in the file format
   unsigned m_BufferSize;
-  unsigned m_BufferPos;
   unsigned m_SamplesPerBuffer;
+  bool m_IsCompressed;
+  bool m_IsBlocking;
   bool m_Recording;
   bool m_Done;
   std::atomic_bool m_Stop;
   std::vector<GOSoundBufferItem *> m_Outputs;
-  char *m_Buffer;
+
+  // the ring of the converted periods. The slot counters only increase
+  std::vector<char> m_Ring;
+  // how many periods have been dropped before the period in the slot
+  std::vector<unsigned> m_SlotGaps;
+  unsigned m_RingSlots;
+  std::atomic_uint m_WriteSlot;
+  std::atomic_uint m_ReadSlot;
+  // the periods dropped since the last one put into the ring
+  unsigned m_PendingGap;
+  std::atomic_uint m_OverflowCount;
+
+  // accessed by the writer thread only while it is running
+  WriterThread m_WriterThread;
+  GOWavPackWriter m_WavPack;
+  std::vector<int32_t> m_PackBuffer;
+  std::vector<char> m_Silence;
+  uint64_t m_DataSize;
+  bool m_IsWriteError;
 
   void SetupBuffer();
-  template <class T> void ConvertData();
-  struct_WAVE generateHeader(unsigned datasize);
+  template <class T> void ConvertData(char *buffer);
+  struct_WAVE generateHeader(uint64_t datasize);
+
+  void WriterLoop(GOThread *thread);
+  void WritePendingSlots();
+  void WritePeriod(const char *data);
+  void WriteCompressedOutput();
+  void WriteFile(const void *data, size_t size);
 
 public:
   GOSoundRecorder();
@@ -51,8 +108,17 @@ public:
   void SetSampleRate(unsigned sample_rate);
   /* 1 = 8 bit, 2 = 16 bit, 3 = 24 bit, 4 = float */
   void SetBytesPerSample(unsigned value);
+  /* Whether to write WavPack instead of WAV */
+  void SetCompressed(bool isCompressed);
+  bool IsCompressed() const { return m_IsCompressed; }
+  /* Whether to wait for the disk instead of dropping the periods */
+  void SetBlocking(bool isBlocking) { m_IsBlocking = isBlocking; }
+  /* Returns the extension of the files of the current format */
+  wxString GetFileExtension() const;
   void SetOutputs(
     std::vector<GOSoundBufferItem *> outputs, unsigned samples_per_buffer);
+  /* Returns how many periods have been dropped because of a slow disk */
+  unsigned GetOverflowCount() const { return m_OverflowCount.load(); }
 
   unsigned GetGroup();
   unsigned GetCost();
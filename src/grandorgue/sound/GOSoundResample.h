@@ -44,6 +44,16 @@ public:
     GO_POLYPHASE_INTERPOLATION = 1,
   };
 
+  /**
+   * The instruction set extensions the resampling kernels may use. The levels
+   * are ordered, so a higher level implies all lower ones
+   */
+  enum SimdLevel {
+    SIMD_NONE = 0,
+    SIMD_SSE2 = 1,
+    SIMD_AVX2 = 2,
+  };
+
   /**
    * A position in the source sample stream for the current position in the
    * target stream. Because the numbers of source and target samples differ, the
@@ -88,6 +98,30 @@ public:
       m_fraction &= UPSAMPLE_MASK;
     }
 
+    /**
+     * Advance the position as nTargetSamples calls of Inc() do
+     */
+    inline void Skip(unsigned nTargetSamples) {
+      const uint64_t fraction
+        = m_fraction + uint64_t(nTargetSamples) * m_FractionIncrement;
+
+      m_index += unsigned(fraction >> UPSAMPLE_BITS);
+      m_fraction = unsigned(fraction & UPSAMPLE_MASK);
+    }
+
+    /**
+     * Calculates the source index without changing the position
+     * @param nTargetSamples the number of target samples to advance
+     * @return the source index the position would have after nTargetSamples
+     *   calls of Inc()
+     */
+    inline unsigned GetIndexAfter(unsigned nTargetSamples) const {
+      return m_index
+        + unsigned(
+               (m_fraction + uint64_t(nTargetSamples) * m_FractionIncrement)
+               >> UPSAMPLE_BITS);
+    }
+
     /**
      * Calculates the target samples length from given source position to the
      * end index
@@ -160,6 +194,8 @@ public:
     }
 
   public:
+    typedef SampleT SampleType;
+
     /**
      * Construct the vector with some start pointer.
      * @param ptr a pointer to the first (0 left) sample
@@ -175,6 +211,12 @@ public:
       p_CurrPtr = p_StartPtr + nChannels * index + channel;
     }
 
+    /**
+     * @return a pointer to the first (0 left) sample. It is used by the block
+     *   resamplers that access the samples directly
+     */
+    inline const SampleT *GetStartPtr() const { return p_StartPtr; }
+
     /**
      * Returns the next sample from the vector and moves the current sample
      * pointer to the next sample of the same channel
@@ -230,6 +272,39 @@ public:
 
   GOSoundResample();
 
+  /**
+   * Returns the best SIMD level supported both by the build and by the CPU
+   * we are running on, but not higher than the limit set with
+   * SetMaxSimdLevel(). The CPU features are detected only once.
+   */
+  static SimdLevel GetSimdLevel();
+
+  /**
+   * Restricts the SIMD level returned by GetSimdLevel(). It affects only the
+   * streams initialised after the call. Useful for comparing the kernels
+   */
+  static void SetMaxSimdLevel(SimdLevel level);
+
+  static const char *GetSimdLevelName(SimdLevel level);
+
+  /**
+   * Resample a block of interleaved samples with the vector instructions of
+   * the given level. The semantic is the same as of
+   * ScalarProductionResampler::ResampleBlock with a PtrSampleVector and two
+   * output channels, but the kernel reads all the input channels of the
+   * nPoints frames at once instead of one channel at a time.
+   * It is instantiated in GOSoundResampleSimd.cpp for GOInt8, GOInt16 and
+   * GOInt24 samples, for int samples of decompressed blocks, 1 and 2
+   * channels and both interpolation types.
+   */
+  template <SimdLevel level, class SampleT, uint8_t nChannels, unsigned nPoints>
+  static void ResampleBlockSimd(
+    const float (&coefs)[UPSAMPLE_FACTOR][nPoints],
+    ResamplingPosition &resamplingPos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples);
+
   /**
    * A resampler that calculates a next output sample as a scalar production of
    * the vector of continous input samples and the vector of coefficients
@@ -309,6 +384,58 @@ public:
       : ScalarProductionResampler<POLYPHASE_POINTS>(r.m_PolyphaseCoefs) {}
   };
 
+  /**
+   * A resampler that does the same as ScalarProductionResampler but uses the
+   * SIMD kernels. It may be used only with PtrSampleVector based sample
+   * vectors and with two output channels
+   */
+  template <unsigned nPoints, SimdLevel level> class SimdResampler {
+  private:
+    const float (&r_coefs)[UPSAMPLE_FACTOR][nPoints];
+
+  protected:
+    inline SimdResampler(const float (&coefs)[UPSAMPLE_FACTOR][nPoints])
+      : r_coefs(coefs) {}
+
+  public:
+    static constexpr unsigned VECTOR_LENGTH = nPoints;
+
+    template <class SampleVectorT, uint8_t nOutChannels>
+    inline void ResampleBlock(
+      ResamplingPosition &resamplingPos,
+      SampleVectorT &sV,
+      float *pOut,
+      unsigned nOutSamples) const {
+      static_assert(nOutChannels == 2, "SIMD kernels produce stereo output");
+      ResampleBlockSimd<
+        level,
+        typename SampleVectorT::SampleType,
+        SampleVectorT::m_NChannels,
+        nPoints>(r_coefs, resamplingPos, sV.GetStartPtr(), pOut, nOutSamples);
+    }
+  };
+
+  /**
+   * The linear resampler with SSE2. There is no AVX2 variant because two
+   * points do not fill even a SSE2 register of a stereo stream
+   */
+  struct LinearSse2Resampler : public SimdResampler<LINEAR_POINTS, SIMD_SSE2> {
+    inline LinearSse2Resampler(const GOSoundResample &r)
+      : SimdResampler<LINEAR_POINTS, SIMD_SSE2>(r.m_LinearCoefs) {}
+  };
+
+  struct PolyphaseSse2Resampler
+    : public SimdResampler<POLYPHASE_POINTS, SIMD_SSE2> {
+    inline PolyphaseSse2Resampler(const GOSoundResample &r)
+      : SimdResampler<POLYPHASE_POINTS, SIMD_SSE2>(r.m_PolyphaseCoefs) {}
+  };
+
+  struct PolyphaseAvx2Resampler
+    : public SimdResampler<POLYPHASE_POINTS, SIMD_AVX2> {
+    inline PolyphaseAvx2Resampler(const GOSoundResample &r)
+      : SimdResampler<POLYPHASE_POINTS, SIMD_AVX2>(r.m_PolyphaseCoefs) {}
+  };
+
   /**
    * Returns the necessary sample vector length for the given interpolation type
    * @param interpolation - the interpolation type
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+/*
+ * The SIMD kernels of GOSoundResample. The SSE2 kernels are compiled with the
+ * flags of the whole project (SSE2 is always present on x86_64). The AVX2
+ * kernels are compiled with the function level target attribute, so the rest
+ * of the program does not depend on AVX2. They are selected at runtime in
+ * GOSoundStream depending on GOSoundResample::GetSimdLevel()
+ */
+
+#include "GOSoundResample.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "GOInt.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))           \
+  && defined(__SSE2__)
+#define GO_SIMD_X86 1
+#include <immintrin.h>
+#define GO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static GOSoundResample::SimdLevel detect_simd_level() {
+#ifdef GO_SIMD_X86
+  __builtin_cpu_init();
+  // __builtin_cpu_supports checks also that the OS saves the AVX registers
+  if (__builtin_cpu_supports("avx2"))
+    return GOSoundResample::SIMD_AVX2;
+  return GOSoundResample::SIMD_SSE2;
+#else
+  return GOSoundResample::SIMD_NONE;
+#endif
+}
+
+static std::atomic<GOSoundResample::SimdLevel> max_simd_level(
+  GOSoundResample::SIMD_AVX2);
+
+GOSoundResample::SimdLevel GOSoundResample::GetSimdLevel() {
+  static const SimdLevel detected = detect_simd_level();
+  const SimdLevel maxLevel = max_simd_level.load();
+
+  return detected < maxLevel ? detected : maxLevel;
+}
+
+void GOSoundResample::SetMaxSimdLevel(SimdLevel level) {
+  max_simd_level.store(level);
+}
+
+const char *GOSoundResample::GetSimdLevelName(SimdLevel level) {
+  switch (level) {
+  case SIMD_SSE2:
+    return "SSE2";
+  case SIMD_AVX2:
+    return "AVX2";
+  default:
+    return "none";
+  }
+}
+
+/**
+ * The generic kernel. It is used when no specialisation exists for the
+ * platform. It calculates the same as ScalarProductionResampler, but
+ * accesses the samples directly
+ */
+template <
+  GOSoundResample::SimdLevel level,
+  class SampleT,
+  uint8_t nChannels,
+  unsigned nPoints>
+struct SimdKernel {
+  static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR][nPoints],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    for (unsigned i = 0; i < nOutSamples; i++, pos.Inc()) {
+      const float *pCoefs = coefs[pos.GetFraction()];
+      const SampleT *p = pIn + nChannels * pos.GetIndex();
+      float out[nChannels];
+
+      for (uint8_t ch = 0; ch < nChannels; ch++) {
+        out[ch] = 0.0f;
+        for (unsigned j = 0; j < nPoints; j++)
+          out[ch] += (int)p[j * nChannels + ch] * pCoefs[j];
+      }
+      *(pOut++) = out[0];
+      *(pOut++) = out[nChannels - 1];
+    }
+  }
+};
+
+#ifdef GO_SIMD_X86
+
+/**
+ * Converts continous samples to floats. Specialised for each sample format
+ */
+template <class SampleT> struct SimdLoad;
+
+template <> struct SimdLoad<GOInt8> {
+  static inline __m128 Load4Sse2(const GOInt8 *p) {
+    int32_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    const __m128i x8 = _mm_cvtsi32_si128(v);
+    const __m128i x16 = _mm_srai_epi16(_mm_unpacklo_epi8(x8, x8), 8);
+
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x16, x16), 16));
+  }
+
+  static inline void Load8Sse2(const GOInt8 *p, __m128 &lo, __m128 &hi) {
+    const __m128i x8 = _mm_loadl_epi64((const __m128i *)p);
+    const __m128i x16 = _mm_srai_epi16(_mm_unpacklo_epi8(x8, x8), 8);
+
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x16, x16), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x16, x16), 16));
+  }
+
+  GO_TARGET_AVX2 static inline __m256 Load8Avx2(const GOInt8 *p) {
+    return _mm256_cvtepi32_ps(
+      _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)p)));
+  }
+};
+
+template <> struct SimdLoad<GOInt16> {
+  static inline __m128 Load4Sse2(const GOInt16 *p) {
+    const __m128i x16 = _mm_loadl_epi64((const __m128i *)p);
+
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x16, x16), 16));
+  }
+
+  static inline void Load8Sse2(const GOInt16 *p, __m128 &lo, __m128 &hi) {
+    const __m128i x16 = _mm_loadu_si128((const __m128i *)p);
+
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x16, x16), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x16, x16), 16));
+  }
+
+  GO_TARGET_AVX2 static inline __m256 Load8Avx2(const GOInt16 *p) {
+    return _mm256_cvtepi32_ps(
+      _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p)));
+  }
+};
+
+template <> struct SimdLoad<int> {
+  static inline __m128 Load4Sse2(const int *p) {
+    return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)p));
+  }
+
+  static inline void Load8Sse2(const int *p, __m128 &lo, __m128 &hi) {
+    lo = Load4Sse2(p);
+    hi = Load4Sse2(p + 4);
+  }
+
+  GO_TARGET_AVX2 static inline __m256 Load8Avx2(const int *p) {
+    return _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)p));
+  }
+};
+
+/* There is no cheap way to unpack 3-byte samples without SSSE3 shuffles and
+ * reading beyond the vector end, so the 24-bit samples are gathered one by
+ * one. The multiplications and the sums are still vectorised */
+template <> struct SimdLoad<GOInt24> {
+  static inline __m128 Load4Sse2(const GOInt24 *p) {
+    return _mm_cvtepi32_ps(_mm_setr_epi32(p[0], p[1], p[2], p[3]));
+  }
+
+  static inline void Load8Sse2(const GOInt24 *p, __m128 &lo, __m128 &hi) {
+    lo = Load4Sse2(p);
+    hi = Load4Sse2(p + 4);
+  }
+
+  GO_TARGET_AVX2 static inline __m256 Load8Avx2(const GOInt24 *p) {
+    return _mm256_cvtepi32_ps(
+      _mm256_setr_epi32(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]));
+  }
+};
+
+/**
+ * Stores the sum of the lanes 0 and 2 to pOut[0] and the sum of the lanes 1
+ * and 3 to pOut[1]
+ */
+static inline void store_stereo_sum(float *pOut, __m128 acc) {
+  _mm_storel_pi((__m64 *)pOut, _mm_add_ps(acc, _mm_movehl_ps(acc, acc)));
+}
+
+/**
+ * Stores the sum of all lanes both to pOut[0] and to pOut[1]
+ */
+static inline void store_mono_sum(float *pOut, __m128 acc) {
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 1, 1, 1)));
+  _mm_storel_pi((__m64 *)pOut, _mm_shuffle_ps(acc, acc, 0));
+}
+
+template <class SampleT>
+struct SimdKernel<
+  GOSoundResample::SIMD_SSE2,
+  SampleT,
+  1,
+  GOSoundResample::POLYPHASE_POINTS> {
+  static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR]
+                        [GOSoundResample::POLYPHASE_POINTS],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    for (unsigned i = 0; i < nOutSamples; i++, pos.Inc(), pOut += 2) {
+      const float *pCoefs = coefs[pos.GetFraction()];
+      __m128 lo, hi;
+
+      SimdLoad<SampleT>::Load8Sse2(pIn + pos.GetIndex(), lo, hi);
+      store_mono_sum(
+        pOut,
+        _mm_add_ps(
+          _mm_mul_ps(lo, _mm_loadu_ps(pCoefs)),
+          _mm_mul_ps(hi, _mm_loadu_ps(pCoefs + 4))));
+    }
+  }
+};
+
+template <class SampleT>
+struct SimdKernel<
+  GOSoundResample::SIMD_SSE2,
+  SampleT,
+  2,
+  GOSoundResample::POLYPHASE_POINTS> {
+  static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR]
+                        [GOSoundResample::POLYPHASE_POINTS],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    for (unsigned i = 0; i < nOutSamples; i++, pos.Inc(), pOut += 2) {
+      const float *pCoefs = coefs[pos.GetFraction()];
+      const SampleT *p = pIn + 2 * pos.GetIndex();
+      const __m128 c0 = _mm_loadu_ps(pCoefs);
+      const __m128 c1 = _mm_loadu_ps(pCoefs + 4);
+      // v0 = L0 R0 L1 R1, v1 = L2 R2 L3 R3 ...
+      __m128 v0, v1, v2, v3;
+
+      SimdLoad<SampleT>::Load8Sse2(p, v0, v1);
+      SimdLoad<SampleT>::Load8Sse2(p + 8, v2, v3);
+
+      // multiply each frame by the duplicated coefficient
+      __m128 acc = _mm_mul_ps(v0, _mm_unpacklo_ps(c0, c0));
+
+      acc = _mm_add_ps(acc, _mm_mul_ps(v1, _mm_unpackhi_ps(c0, c0)));
+      acc = _mm_add_ps(acc, _mm_mul_ps(v2, _mm_unpacklo_ps(c1, c1)));
+      acc = _mm_add_ps(acc, _mm_mul_ps(v3, _mm_unpackhi_ps(c1, c1)));
+      store_stereo_sum(pOut, acc);
+    }
+  }
+};
+
+template <class SampleT>
+struct SimdKernel<
+  GOSoundResample::SIMD_SSE2,
+  SampleT,
+  1,
+  GOSoundResample::LINEAR_POINTS> {
+  static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR]
+                        [GOSoundResample::LINEAR_POINTS],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    unsigned i = 0;
+
+    // Two points of a mono stream fill only half of a register, so calculate
+    // two output samples at once
+    for (; i + 1 < nOutSamples; i += 2, pOut += 4) {
+      const float *pc0 = coefs[pos.GetFraction()];
+      const SampleT *p0 = pIn + pos.GetIndex();
+
+      pos.Inc();
+
+      const float *pc1 = coefs[pos.GetFraction()];
+      const SampleT *p1 = pIn + pos.GetIndex();
+
+      pos.Inc();
+
+      const __m128 v
+        = _mm_setr_ps((int)p0[0], (int)p0[1], (int)p1[0], (int)p1[1]);
+      const __m128 c = _mm_loadh_pi(
+        _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)pc0),
+        (const __m64 *)pc1);
+      const __m128 prod = _mm_mul_ps(v, c);
+
+      // a0+a1 a0+a1 b0+b1 b0+b1
+      _mm_storeu_ps(
+        pOut,
+        _mm_add_ps(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+    if (i < nOutSamples)
+      SimdKernel<GOSoundResample::SIMD_NONE, SampleT, 1, 2>::Run(
+        coefs, pos, pIn, pOut, 1);
+  }
+};
+
+template <class SampleT>
+struct SimdKernel<
+  GOSoundResample::SIMD_SSE2,
+  SampleT,
+  2,
+  GOSoundResample::LINEAR_POINTS> {
+  static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR]
+                        [GOSoundResample::LINEAR_POINTS],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    unsigned i = 0;
+
+    // calculate two output frames at once for storing a full register
+    for (; i + 1 < nOutSamples; i += 2, pOut += 4) {
+      // c0 c1 0 0
+      const __m128 ca = _mm_loadl_pi(
+        _mm_setzero_ps(), (const __m64 *)coefs[pos.GetFraction()]);
+      // L0 R0 L1 R1
+      const __m128 prodA = _mm_mul_ps(
+        SimdLoad<SampleT>::Load4Sse2(pIn + 2 * pos.GetIndex()),
+        _mm_unpacklo_ps(ca, ca));
+
+      pos.Inc();
+
+      const __m128 cb = _mm_loadl_pi(
+        _mm_setzero_ps(), (const __m64 *)coefs[pos.GetFraction()]);
+      const __m128 prodB = _mm_mul_ps(
+        SimdLoad<SampleT>::Load4Sse2(pIn + 2 * pos.GetIndex()),
+        _mm_unpacklo_ps(cb, cb));
+
+      pos.Inc();
+      // LA RA LB RB
+      _mm_storeu_ps(
+        pOut,
+        _mm_add_ps(_mm_movelh_ps(prodA, prodB), _mm_movehl_ps(prodB, prodA)));
+    }
+    if (i < nOutSamples)
+      SimdKernel<GOSoundResample::SIMD_NONE, SampleT, 2, 2>::Run(
+        coefs, pos, pIn, pOut, 1);
+  }
+};
+
+template <class SampleT>
+struct SimdKernel<
+  GOSoundResample::SIMD_AVX2,
+  SampleT,
+  1,
+  GOSoundResample::POLYPHASE_POINTS> {
+  GO_TARGET_AVX2 static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR]
+                        [GOSoundResample::POLYPHASE_POINTS],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    for (unsigned i = 0; i < nOutSamples; i++, pos.Inc(), pOut += 2) {
+      const __m256 prod = _mm256_mul_ps(
+        SimdLoad<SampleT>::Load8Avx2(pIn + pos.GetIndex()),
+        _mm256_loadu_ps(coefs[pos.GetFraction()]));
+
+      store_mono_sum(
+        pOut,
+        _mm_add_ps(
+          _mm256_castps256_ps128(prod), _mm256_extractf128_ps(prod, 1)));
+    }
+  }
+};
+
+template <class SampleT>
+struct SimdKernel<
+  GOSoundResample::SIMD_AVX2,
+  SampleT,
+  2,
+  GOSoundResample::POLYPHASE_POINTS> {
+  GO_TARGET_AVX2 static void Run(
+    const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR]
+                        [GOSoundResample::POLYPHASE_POINTS],
+    GOSoundResample::ResamplingPosition &pos,
+    const SampleT *pIn,
+    float *pOut,
+    unsigned nOutSamples) {
+    // for duplicating each coefficient for the left and the right channels
+    const __m256i idx0 = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i idx1 = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+    for (unsigned i = 0; i < nOutSamples; i++, pos.Inc(), pOut += 2) {
+      const SampleT *p = pIn + 2 * pos.GetIndex();
+      const __m256 c = _mm256_loadu_ps(coefs[pos.GetFraction()]);
+      const __m256 acc = _mm256_add_ps(
+        _mm256_mul_ps(
+          SimdLoad<SampleT>::Load8Avx2(p), _mm256_permutevar8x32_ps(c, idx0)),
+        _mm256_mul_ps(
+          SimdLoad<SampleT>::Load8Avx2(p + 8),
+          _mm256_permutevar8x32_ps(c, idx1)));
+
+      store_stereo_sum(
+        pOut,
+        _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+    }
+  }
+};
+
+#endif /* GO_SIMD_X86 */
+
+template <
+  GOSoundResample::SimdLevel level,
+  class SampleT,
+  uint8_t nChannels,
+  unsigned nPoints>
+void GOSoundResample::ResampleBlockSimd(
+  const float (&coefs)[UPSAMPLE_FACTOR][nPoints],
+  ResamplingPosition &resamplingPos,
+  const SampleT *pIn,
+  float *pOut,
+  unsigned nOutSamples) {
+  SimdKernel<level, SampleT, nChannels, nPoints>::Run(
+    coefs, resamplingPos, pIn, pOut, nOutSamples);
+}
+
+#define GO_INSTANTIATE_RESAMPLE_BLOCK(level, SampleT, nChannels, nPoints)      \
+  template void GOSoundResample::                                              \
+    ResampleBlockSimd<GOSoundResample::level, SampleT, nChannels, nPoints>(    \
+      const float (&coefs)[UPSAMPLE_FACTOR][nPoints],                          \
+      ResamplingPosition &resamplingPos,                                       \
+      const SampleT *pIn,                                                      \
+      float *pOut,                                                             \
+      unsigned nOutSamples);
+
+#define GO_INSTANTIATE_RESAMPLE_BLOCKS(level, nPoints)                         \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, GOInt8, 1, nPoints)                     \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, GOInt8, 2, nPoints)                     \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, GOInt16, 1, nPoints)                    \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, GOInt16, 2, nPoints)                    \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, GOInt24, 1, nPoints)                    \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, GOInt24, 2, nPoints)                    \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, int, 1, nPoints)                        \
+  GO_INSTANTIATE_RESAMPLE_BLOCK(level, int, 2, nPoints)
+
+GO_INSTANTIATE_RESAMPLE_BLOCKS(SIMD_SSE2, GOSoundResample::LINEAR_POINTS)
+GO_INSTANTIATE_RESAMPLE_BLOCKS(SIMD_SSE2, GOSoundResample::POLYPHASE_POINTS)
+GO_INSTANTIATE_RESAMPLE_BLOCKS(SIMD_AVX2, GOSoundResample::POLYPHASE_POINTS)
@@ -16,24 +16,59 @@
 class GOSoundProvider;
 class GOSoundWindchestTask;
 
-struct GOSoundSampler {
+/**
+ * The samplers are allocated in GOSoundSamplerPool arenas aligned to the cache
+ * line. The fields accessed on every period are placed first, so the per
+ * period processing touches the beginning of the sampler only. The fields
+ * used only when a sampler is started or released are placed at the end
+ */
+struct alignas(64) GOSoundSampler {
+  /* Hot fields: used on every period */
   GOSoundSampler *next;
   const GOSoundProvider *p_SoundProvider;
-  int m_SamplerTaskId;
   GOSoundWindchestTask *p_WindchestTask;
-  unsigned m_AudioGroupId;
-  GOSoundStream stream;
-  GOSoundFader fader;
-  GOSoundFilter::FilterState toneBalanceFilterState;
   uint64_t time;
-  unsigned velocity;
-  unsigned delay;
   /* current index of the current block into this sample */
   volatile unsigned long stop;
   volatile unsigned long new_attack;
-  GOBool3 m_WaveTremulantStateFor;
-  bool is_release;
+  /* the time when the decay of a released sampler starts. 0 if none */
+  uint64_t decay_time;
+  unsigned decay_frames;
   unsigned drop_counter;
+  bool is_release;
+  GOSoundFader fader;
+  GOSoundFilter::FilterState toneBalanceFilterState;
+  GOSoundStream stream;
+
+  /* Cold fields: used on starting and releasing only */
+  int m_SamplerTaskId;
+  unsigned m_AudioGroupId;
+  unsigned velocity;
+  unsigned delay;
+  GOBool3 m_WaveTremulantStateFor;
+
+  /**
+   * Initializes the fields that are not initialized when the sampler is
+   * started. The stream, the fader and the filter state are always set up by
+   * the engine, so they are not touched here
+   */
+  void Init() {
+    next = nullptr;
+    p_SoundProvider = nullptr;
+    p_WindchestTask = nullptr;
+    time = 0;
+    stop = 0;
+    new_attack = 0;
+    decay_time = 0;
+    decay_frames = 0;
+    drop_counter = 0;
+    is_release = false;
+    m_SamplerTaskId = 0;
+    m_AudioGroupId = 0;
+    velocity = 0;
+    delay = 0;
+    m_WaveTremulantStateFor = BOOL3_DEFAULT;
+  }
 };
 
 #endif /* GOSOUNDSAMPLER_H_ */
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -8,39 +8,76 @@
 #include "GOSoundSamplerPool.h"
 
 #include <assert.h>
-#include <string.h>
 
 #include "GOSoundSampler.h"
 #include "threading/GOMutexLocker.h"
 
+thread_local GOSoundSamplerPool::ThreadCache GOSoundSamplerPool::t_Cache
+  = {nullptr, 0, false, 0, {}};
+std::atomic_uint GOSoundSamplerPool::s_NextGeneration(1);
+
 GOSoundSamplerPool::GOSoundSamplerPool()
-  : m_SamplerCount(0), m_UsageLimit(0), m_AvailableSamplers(), m_Samplers() {
+  : m_SamplerCount(0),
+    m_UsageLimit(0),
+    m_Generation(0),
+    m_CacheCount(0),
+    m_AvailableSamplers(),
+    m_SamplerTotal(0) {
   ReturnAll();
 }
 
+GOSoundSamplerPool::~GOSoundSamplerPool() {}
+
+GOSoundSamplerPool::ThreadCache &GOSoundSamplerPool::GetThreadCache() {
+  ThreadCache &cache = t_Cache;
+  const unsigned generation = m_Generation.load();
+
+  if (cache.p_pool != this || cache.m_Generation != generation) {
+    // the cached samplers have already been put to m_AvailableSamplers
+    cache.p_pool = this;
+    cache.m_Generation = generation;
+    cache.m_IsEnabled = m_CacheCount.fetch_add(1) < MAX_CACHE_THREADS;
+    cache.m_Count = 0;
+  }
+  return cache;
+}
+
 void GOSoundSamplerPool::ReturnAll() {
   GOMutexLocker locker(m_Lock);
 
   m_SamplerCount = 0;
-
-  if (m_Samplers.size() > m_UsageLimit)
-    m_Samplers.resize(m_UsageLimit);
-
+  // invalidate the thread caches. The generations are unique across the pools
+  m_CacheCount.store(0);
+  m_Generation.store(s_NextGeneration.fetch_add(1));
   m_AvailableSamplers.Clear();
 
-  for (unsigned i = 0; i < m_Samplers.size(); i++)
-    m_AvailableSamplers.Put(m_Samplers[i]);
+  // put the samplers in the reverse order, so they are given from the
+  // beginning of the arenas
+  for (unsigned i = m_Arenas.size(); i > 0; i--) {
+    GOSoundSampler *arena = m_Arenas[i - 1].get();
+
+    for (unsigned j = m_ArenaSizes[i - 1]; j > 0; j--)
+      m_AvailableSamplers.Put(arena + j - 1);
+  }
 }
 
 void GOSoundSamplerPool::SetUsageLimit(unsigned count) {
   m_UsageLimit = count;
 
   GOMutexLocker locker(m_Lock);
-  while (m_Samplers.size() < m_UsageLimit) {
-    GOSoundSampler *sampler = new GOSoundSampler;
-    m_SamplerCount.fetch_add(1);
-    m_Samplers.push_back(sampler);
-    ReturnSampler(sampler);
+
+  // up to THREAD_CACHE_SIZE samplers may be stranded in each thread cache
+  const unsigned total = m_UsageLimit + THREAD_CACHE_SIZE * MAX_CACHE_THREADS;
+
+  if (m_SamplerTotal < total) {
+    const unsigned nNew = total - m_SamplerTotal;
+    GOSoundSampler *arena = new GOSoundSampler[nNew];
+
+    m_Arenas.emplace_back(arena);
+    m_ArenaSizes.push_back(nNew);
+    m_SamplerTotal += nNew;
+    for (unsigned i = nNew; i > 0; i--)
+      m_AvailableSamplers.Put(arena + i - 1);
   }
 }
 
@@ -48,17 +85,28 @@ GOSoundSampler *GOSoundSamplerPool::GetSampler() {
   GOSoundSampler *sampler = NULL;
 
   if (m_SamplerCount < m_UsageLimit) {
-    sampler = m_AvailableSamplers.Get();
+    ThreadCache &cache = GetThreadCache();
+
+    if (cache.m_Count)
+      sampler = cache.m_Samplers[--cache.m_Count];
+    else
+      sampler = m_AvailableSamplers.Get();
     if (sampler)
       m_SamplerCount.fetch_add(1);
   }
   if (sampler)
-    memset(sampler, 0, sizeof(GOSoundSampler));
+    sampler->Init();
   return sampler;
 }
 
 void GOSoundSamplerPool::ReturnSampler(GOSoundSampler *sampler) {
   assert(m_SamplerCount > 0);
   m_SamplerCount.fetch_add(-1);
-  m_AvailableSamplers.Put(sampler);
+
+  ThreadCache &cache = GetThreadCache();
+
+  if (cache.m_IsEnabled && cache.m_Count < THREAD_CACHE_SIZE)
+    cache.m_Samplers[cache.m_Count++] = sampler;
+  else
+    m_AvailableSamplers.Put(sampler);
 }
@@ -8,22 +8,60 @@
 #ifndef GOSOUNDSAMPLERPOOL_H_
 #define GOSOUNDSAMPLERPOOL_H_
 
+#include <memory>
+#include <vector>
+
 #include "GOSoundSimpleSamplerList.h"
-#include "ptrvector.h"
 #include "threading/GOMutex.h"
 
-class GOSoundSampler;
+struct GOSoundSampler;
 
 class GOSoundSamplerPool {
 private:
+  // the maximum number of free samplers kept by one thread
+  static constexpr unsigned THREAD_CACHE_SIZE = 8;
+  /* the maximum number of threads keeping free samplers. The samplers kept by
+   * a thread that does not allocate are stranded, so the arenas have spare
+   * samplers for all caches */
+  static constexpr unsigned MAX_CACHE_THREADS = 16;
+
+  /**
+   * Free samplers returned by the current thread. They are reused by the same
+   * thread while they are still in its CPU cache and without touching the
+   * common free list
+   */
+  struct ThreadCache {
+    const GOSoundSamplerPool *p_pool;
+    // the cache is valid only for this generation of the pool
+    unsigned m_Generation;
+    // whether the thread has got a cache slot of the generation
+    bool m_IsEnabled;
+    unsigned m_Count;
+    GOSoundSampler *m_Samplers[THREAD_CACHE_SIZE];
+  };
+
+  static thread_local ThreadCache t_Cache;
+  static std::atomic_uint s_NextGeneration;
+
   GOMutex m_Lock;
   std::atomic_uint m_SamplerCount;
   unsigned m_UsageLimit;
+  // changed when all samplers are returned, so the thread caches become stale
+  std::atomic_uint m_Generation;
+  // the number of thread caches of the generation
+  std::atomic_uint m_CacheCount;
   GOSoundSimpleSamplerList m_AvailableSamplers;
-  ptr_vector<GOSoundSampler> m_Samplers;
+  // contiguous arrays of the samplers. A new arena is added when the usage
+  // limit grows, so the existing samplers are never moved
+  std::vector<std::unique_ptr<GOSoundSampler[]>> m_Arenas;
+  std::vector<unsigned> m_ArenaSizes;
+  unsigned m_SamplerTotal;
+
+  ThreadCache &GetThreadCache();
 
 public:
   GOSoundSamplerPool();
+  ~GOSoundSamplerPool();
   GOSoundSampler *GetSampler();
   void ReturnSampler(GOSoundSampler *sampler);
   void ReturnAll();
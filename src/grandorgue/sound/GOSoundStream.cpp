@@ -7,10 +7,14 @@
 
 #include "GOSoundStream.h"
 
+#include <algorithm>
+
 #include <wx/log.h>
 
 #include "GOSoundAudioSection.h"
 #include "GOSoundReleaseAlignTable.h"
+#include "GOSoundStreamBuffer.h"
+#include "GOSoundStreamPrefetcher.h"
 
 /* Block reading functions */
 
@@ -23,95 +27,6 @@ public:
       (SampleT *)stream.ptr) {}
 };
 
-template <bool format16, uint8_t nChannels>
-class GOSoundStream::StreamCacheWindow
-  : public GOSoundResample::FloatingSampleVector<nChannels> {
-private:
-  DecompressionCache &r_cache;
-  uint8_t m_ChannelN;
-  enum { PREV, VALUE, ZERO } m_curr;
-
-public:
-  inline StreamCacheWindow(GOSoundStream &stream) : r_cache(stream.cache) {}
-
-  inline void Seek(unsigned index, uint8_t channelN) {
-    while (r_cache.position <= index + 1) {
-      DecompressionStep(r_cache, nChannels, format16);
-    }
-    m_ChannelN = channelN;
-    m_curr = PREV;
-  }
-
-  inline int NextSample() {
-    int res;
-
-    if (m_curr == PREV) {
-      res = r_cache.prev[m_ChannelN];
-      m_curr = VALUE;
-    } else if (m_curr == VALUE) {
-      res = r_cache.value[m_ChannelN];
-      m_curr = ZERO;
-    } else
-      res = 0;
-    return res;
-  }
-};
-
-template <bool format16, unsigned windowLen, uint8_t nChannels>
-class GOSoundStream::StreamCacheReadAheadWindow
-  : public GOSoundResample::PtrSampleVector<int, int, nChannels> {
-private:
-  static constexpr unsigned WINDOW_SAMPLES = nChannels * windowLen;
-  static constexpr unsigned BUFFER_SAMPLES = WINDOW_SAMPLES * 2;
-
-  DecompressionCache &r_cache;
-  int *p_begin;
-  int *p_end;
-
-public:
-  inline StreamCacheReadAheadWindow(GOSoundStream &stream)
-    : GOSoundResample::PtrSampleVector<int, int, nChannels>(
-      stream.m_ReadAheadBuffer),
-      r_cache(stream.cache),
-      p_begin(stream.m_ReadAheadBuffer),
-      p_end(p_begin + BUFFER_SAMPLES) {}
-
-  inline void Seek(unsigned index, uint8_t channelN) {
-    unsigned readAheadIndexTo = index + windowLen;
-
-    if (r_cache.position < readAheadIndexTo) {
-      unsigned writePosition = std::max(r_cache.position, index);
-      // pWrite1 points somewhere in the first half of the buffer
-      int *pWrite1 = p_begin + nChannels * (writePosition % windowLen);
-      // pWrite2 points somewhere in the second half of the buffer
-      int *pWrite2 = pWrite1 + WINDOW_SAMPLES;
-
-      while (r_cache.position < readAheadIndexTo) {
-        DecompressionStep(r_cache, nChannels, format16);
-
-        /* fill the read ahead buffer. If r_cache.position > index we assume
-          that the previous samples already present */
-        if (r_cache.position >= index) {
-          const int *pRead = r_cache.value;
-
-          for (uint8_t i = nChannels; i > 0; i--)
-            *(pWrite1++) = *(pWrite2++) = *(pRead++);
-          /* because stream.m_ReadAheadBuffer is a ring buffer of a double
-           * windowLen, pWrite2 may move out of the buffer. Reset it to the
-           * buffer begin, so pWrite pointers would swap */
-          if (pWrite2 >= p_end)
-            pWrite2 -= BUFFER_SAMPLES;
-        }
-      }
-    }
-    /* Now the ring buffer contains windowLen continous samples in the positions
-     * from index % windowLen to index % windowLen + windowLen. So use Seek of
-     * the parent class */
-    GOSoundResample::PtrSampleVector<int, int, nChannels>::Seek(
-      index % windowLen, channelN);
-  }
-};
-
 /* The block decode functions should provide whatever the normal resolution of
  * the audio is. The fade engine should ensure that this data is always brought
  * into the correct range. */
@@ -125,132 +40,154 @@ void GOSoundStream::DecodeBlock(float *pOut, unsigned nOutSamples) {
     m_ResamplingPos, w, pOut, nOutSamples);
 }
 
+template <class ResamplerT, bool format16, uint8_t nChannels>
+void GOSoundStream::DecodeCompressedBlock(float *pOut, unsigned nOutSamples) {
+  static constexpr unsigned windowLen = ResamplerT::VECTOR_LENGTH;
+
+  ResamplerT resampler(*resample);
+  // decoded frames starting from the current resampling index
+  int buffer[nChannels * (DECODE_BLOCK_FRAMES + windowLen)];
+
+  while (nOutSamples > 0) {
+    const unsigned index = m_ResamplingPos.GetIndex();
+    const unsigned nTargetSamples = std::min(
+      nOutSamples,
+      m_ResamplingPos.AvailableTargetSamples(index + DECODE_BLOCK_FRAMES));
+    // the frame after the last one required for resampling of the block
+    const unsigned endIndex
+      = m_ResamplingPos.GetIndexAfter(nTargetSamples - 1) + windowLen;
+    int *pWrite = buffer;
+
+    if (
+      cache.position > index
+      && (!m_IsTailValid || cache.position - index > windowLen)) {
+      // the frames before cache.position are not in the tail, so decode them
+      // again from the section start
+      InitDecompressionCache(cache);
+      cache.ptr = audio_section->GetData();
+    }
+    if (cache.position > index) {
+      // the frames from index have already been decoded with the prev block
+      const unsigned nTailFrames = cache.position - index;
+
+      memcpy(
+        pWrite,
+        m_DecodedTail + nChannels * (windowLen - nTailFrames),
+        sizeof(int) * nChannels * nTailFrames);
+      pWrite += nChannels * nTailFrames;
+    } else
+      // skip the frames that are not required for resampling
+      while (cache.position < index)
+        DecompressionStep(cache, nChannels, format16);
+    if (cache.position < endIndex)
+      DecompressBlock<format16, nChannels>(
+        cache, pWrite, endIndex - cache.position);
+    // save the last windowLen frames for the next block
+    memcpy(
+      m_DecodedTail,
+      buffer + nChannels * (endIndex - windowLen - index),
+      sizeof(int) * nChannels * windowLen);
+    m_IsTailValid = true;
+
+    // resample the block with the index relative to the buffer begin
+    GOSoundResample::PtrSampleVector<int, int, nChannels> w(buffer);
+
+    m_ResamplingPos.SetIndex(0);
+    resampler.template ResampleBlock<
+      GOSoundResample::PtrSampleVector<int, int, nChannels>,
+      2>(m_ResamplingPos, w, pOut, nTargetSamples);
+    m_ResamplingPos.SetIndex(m_ResamplingPos.GetIndex() + index);
+    pOut += 2 * nTargetSamples;
+    nOutSamples -= nTargetSamples;
+  }
+}
+
+template <class ResamplerT>
+GOSoundStream::DecodeBlockFunction GOSoundStream::getPtrDecodeBlockFunction(
+  uint8_t channels, uint8_t bits_per_sample) {
+  if (channels == 1) {
+    if (bits_per_sample <= 8)
+      return &GOSoundStream::
+        DecodeBlock<ResamplerT, StreamPtrWindow<GOInt8, 1>>;
+    if (bits_per_sample <= 16)
+      return &GOSoundStream::
+        DecodeBlock<ResamplerT, StreamPtrWindow<GOInt16, 1>>;
+    if (bits_per_sample <= 24)
+      return &GOSoundStream::
+        DecodeBlock<ResamplerT, StreamPtrWindow<GOInt24, 1>>;
+  } else if (channels == 2) {
+    if (bits_per_sample <= 8)
+      return &GOSoundStream::
+        DecodeBlock<ResamplerT, StreamPtrWindow<GOInt8, 2>>;
+    if (bits_per_sample <= 16)
+      return &GOSoundStream::
+        DecodeBlock<ResamplerT, StreamPtrWindow<GOInt16, 2>>;
+    if (bits_per_sample <= 24)
+      return &GOSoundStream::
+        DecodeBlock<ResamplerT, StreamPtrWindow<GOInt24, 2>>;
+  }
+  assert(0 && "unsupported decoder configuration");
+  return NULL;
+}
+
+template <class ResamplerT>
+GOSoundStream::DecodeBlockFunction GOSoundStream::
+  getCompressedDecodeBlockFunction(uint8_t channels, uint8_t bits_per_sample) {
+  assert(bits_per_sample >= 12);
+  if (channels == 1) {
+    if (bits_per_sample >= 20)
+      return &GOSoundStream::DecodeCompressedBlock<ResamplerT, true, 1>;
+    return &GOSoundStream::DecodeCompressedBlock<ResamplerT, false, 1>;
+  } else if (channels == 2) {
+    if (bits_per_sample >= 20)
+      return &GOSoundStream::DecodeCompressedBlock<ResamplerT, true, 2>;
+    return &GOSoundStream::DecodeCompressedBlock<ResamplerT, false, 2>;
+  }
+  assert(0 && "unsupported decoder configuration");
+  return NULL;
+}
+
+template <class ResamplerT>
+GOSoundStream::DecodeBlockFunction GOSoundStream::
+  getResamplerDecodeBlockFunction(
+    uint8_t channels, uint8_t bits_per_sample, bool compressed) {
+  return compressed
+    ? getCompressedDecodeBlockFunction<ResamplerT>(channels, bits_per_sample)
+    : getPtrDecodeBlockFunction<ResamplerT>(channels, bits_per_sample);
+}
+
 GOSoundStream::DecodeBlockFunction GOSoundStream::getDecodeBlockFunction(
   uint8_t channels,
   uint8_t bits_per_sample,
   bool compressed,
   GOSoundResample::InterpolationType interpolation,
   bool is_end) {
-  if (compressed && !is_end) {
-    if (interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION) {
-      if (channels == 1) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamCacheReadAheadWindow<
-              true,
-              GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-              1>>;
-
-        assert(bits_per_sample >= 12);
-        return &GOSoundStream::DecodeBlock<
-          GOSoundResample::PolyphaseResampler,
-          StreamCacheReadAheadWindow<
-            false,
-            GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-            1>>;
-      } else if (channels == 2) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamCacheReadAheadWindow<
-              true,
-              GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-              2>>;
-
-        assert(bits_per_sample >= 12);
-        return &GOSoundStream::DecodeBlock<
-          GOSoundResample::PolyphaseResampler,
-          StreamCacheReadAheadWindow<
-            false,
-            GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-            2>>;
-      }
-    } else {
-      if (channels == 1) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamCacheWindow<true, 1>>;
-
-        assert(bits_per_sample >= 12);
-        return &GOSoundStream::DecodeBlock<
-          GOSoundResample::LinearResampler,
-          StreamCacheWindow<false, 1>>;
-      } else if (channels == 2) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamCacheWindow<true, 2>>;
-
-        assert(bits_per_sample >= 12);
-        return &GOSoundStream::DecodeBlock<
-          GOSoundResample::LinearResampler,
-          StreamCacheWindow<false, 2>>;
-      }
-    }
+  // the end segments are always uncompressed
+  const bool isCompressed = compressed && !is_end;
+  // both the uncompressed samples and the decoded blocks of the compressed
+  // samples may be resampled with the SIMD kernels
+  const GOSoundResample::SimdLevel simdLevel = GOSoundResample::GetSimdLevel();
+
+  if (interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION) {
+    if (simdLevel >= GOSoundResample::SIMD_AVX2)
+      return getResamplerDecodeBlockFunction<
+        GOSoundResample::PolyphaseAvx2Resampler>(
+        channels, bits_per_sample, isCompressed);
+    if (simdLevel >= GOSoundResample::SIMD_SSE2)
+      return getResamplerDecodeBlockFunction<
+        GOSoundResample::PolyphaseSse2Resampler>(
+        channels, bits_per_sample, isCompressed);
+    return getResamplerDecodeBlockFunction<
+      GOSoundResample::PolyphaseResampler>(
+      channels, bits_per_sample, isCompressed);
   } else {
-    if (interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION) {
-      if (channels == 1) {
-        if (bits_per_sample <= 8)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamPtrWindow<GOInt8, 1>>;
-        if (bits_per_sample <= 16)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamPtrWindow<GOInt16, 1>>;
-        if (bits_per_sample <= 24)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamPtrWindow<GOInt24, 1>>;
-      } else if (channels == 2) {
-        if (bits_per_sample <= 8)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamPtrWindow<GOInt8, 2>>;
-        if (bits_per_sample <= 16)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamPtrWindow<GOInt16, 2>>;
-        if (bits_per_sample <= 24)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamPtrWindow<GOInt24, 2>>;
-      }
-    } else {
-      if (channels == 1) {
-        if (bits_per_sample <= 8)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamPtrWindow<GOInt8, 1>>;
-        if (bits_per_sample <= 16)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamPtrWindow<GOInt16, 1>>;
-        if (bits_per_sample <= 24)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamPtrWindow<GOInt24, 1>>;
-      } else if (channels == 2) {
-        if (bits_per_sample <= 8)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamPtrWindow<GOInt8, 2>>;
-        if (bits_per_sample <= 16)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamPtrWindow<GOInt16, 2>>;
-        if (bits_per_sample <= 24)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamPtrWindow<GOInt24, 2>>;
-      }
-    }
+    if (simdLevel >= GOSoundResample::SIMD_SSE2)
+      return getResamplerDecodeBlockFunction<
+        GOSoundResample::LinearSse2Resampler>(
+        channels, bits_per_sample, isCompressed);
+    return getResamplerDecodeBlockFunction<GOSoundResample::LinearResampler>(
+      channels, bits_per_sample, isCompressed);
   }
-
-  assert(0 && "unsupported decoder configuration");
-  return NULL;
 }
 
 void GOSoundStream::InitStream(
@@ -287,6 +224,10 @@ void GOSoundStream::InitStream(
   end_pos = end.end_pos;
   cache = start.cache;
   cache.ptr = audio_section->GetData() + (intptr_t)cache.ptr;
+  m_IsTailValid = false;
+  p_StreamBuffer = nullptr;
+  m_StreamStart = pSection->GetStreamStart();
+  m_StreamEnd = pSection->GetStreamEnd();
 }
 
 void GOSoundStream::InitAlignedStream(
@@ -338,6 +279,56 @@ void GOSoundStream::InitAlignedStream(
   end_pos = end.end_pos;
   cache = start.cache;
   cache.ptr = audio_section->GetData() + (intptr_t)cache.ptr;
+  m_IsTailValid = false;
+  p_StreamBuffer = nullptr;
+  m_StreamStart = pSection->GetStreamStart();
+  m_StreamEnd = pSection->GetStreamEnd();
+}
+
+void GOSoundStream::AttachStreamBuffer(GOSoundStreamPrefetcher &prefetcher) {
+  const unsigned pos = m_ResamplingPos.GetIndex();
+
+  // a stream switched or aligned inside the streamed frames is read from the
+  // next period, so the buffer is primed before the stream is played
+  if (m_StreamStart < m_StreamEnd && pos < m_StreamEnd)
+    p_StreamBuffer = prefetcher.Acquire(
+      audio_section, std::max(pos, m_StreamStart), pos >= m_StreamStart);
+}
+
+void GOSoundStream::DetachStreamBuffer() {
+  if (p_StreamBuffer) {
+    p_StreamBuffer->Release();
+    p_StreamBuffer = nullptr;
+  }
+}
+
+unsigned GOSoundStream::ReadStreamedBlock(float *buffer, unsigned n_blocks) {
+  const unsigned pos = m_ResamplingPos.GetIndex();
+  unsigned availEnd = pos;
+  const unsigned char *streamPtr
+    = p_StreamBuffer ? p_StreamBuffer->Read(pos, availEnd) : nullptr;
+  unsigned targetSamples;
+
+  if (availEnd > pos + MAX_WINDOW_LEN) {
+    // the resampling window reads up to MAX_WINDOW_LEN frames ahead
+    targetSamples = std::min(
+      m_ResamplingPos.AvailableTargetSamples(
+        std::min(m_StreamEnd, availEnd - MAX_WINDOW_LEN)),
+      n_blocks);
+    ptr = streamPtr;
+    (this->*decode_call)(buffer, targetSamples);
+    ptr = audio_section->GetData();
+  } else {
+    // there is no buffer or the frames have not been read ahead in time. The
+    // section is mapped, so read them from the mapping. It may wait for the
+    // disk, but it does not play silence
+    targetSamples = std::min(
+      m_ResamplingPos.AvailableTargetSamples(m_StreamEnd), n_blocks);
+    (this->*decode_call)(buffer, targetSamples);
+    if (p_StreamBuffer)
+      p_StreamBuffer->AddUnderrun();
+  }
+  return targetSamples;
 }
 
 bool GOSoundStream::ReadBlock(float *buffer, unsigned int n_blocks) {
@@ -346,10 +337,24 @@ bool GOSoundStream::ReadBlock(float *buffer, unsigned int n_blocks) {
   while (n_blocks > 0) {
     unsigned pos = m_ResamplingPos.GetIndex();
 
-    if (pos < end_pos) { // the loop has not yet fully played
+    if (p_StreamBuffer && pos >= m_StreamEnd)
+      // the rest of the section is resident
+      DetachStreamBuffer();
+    if (pos >= m_StreamStart && pos < m_StreamEnd) {
+      // the streamed frames lie before the transition position
+      const unsigned targetSamples = ReadStreamedBlock(buffer, n_blocks);
+
+      buffer += 2 * targetSamples;
+      n_blocks -= targetSamples;
+    } else if (pos < end_pos) { // the loop has not yet fully played
       // whether we are playing the start or the end segment
       bool isToPlayMain = pos < transition_position;
       unsigned finishPos = isToPlayMain ? transition_position : end_pos;
+
+      if (pos < m_StreamStart)
+        // the next frames are read from the stream buffer
+        finishPos = m_StreamStart;
+
       unsigned targetSamples
         = std::min(m_ResamplingPos.AvailableTargetSamples(finishPos), n_blocks);
 
@@ -388,6 +393,7 @@ bool GOSoundStream::ReadBlock(float *buffer, unsigned int n_blocks) {
 
       cache = next->cache;
       cache.ptr = audio_section->GetData() + (intptr_t)cache.ptr;
+      m_IsTailValid = false;
       transition_position = next_end->transition_offset;
       end_pos = next_end->end_pos;
       end_ptr = next_end->end_ptr;
@@ -430,11 +436,21 @@ void GOSoundStream::GetHistory(
       for (uint8_t j = 0; j < nChannels; j++)
         history[i][j] = audio_section->GetSampleData(
           end_ptr, pos - transition_position + i, j);
-  else if (!audio_section->IsCompressed())
+  else if (!audio_section->IsCompressed()) {
+    const unsigned char *data = ptr;
+
+    // the streamed frames are taken from the buffer if they are there
+    if (p_StreamBuffer && pos >= m_StreamStart && pos < m_StreamEnd) {
+      unsigned availEnd;
+      const unsigned char *streamPtr = p_StreamBuffer->Read(pos, availEnd);
+
+      if (availEnd >= pos + BLOCK_HISTORY)
+        data = streamPtr;
+    }
     for (unsigned i = 0; i < BLOCK_HISTORY; i++)
       for (uint8_t j = 0; j < nChannels; j++)
-        history[i][j] = audio_section->GetSampleData(ptr, pos + i, j);
-  else {
+        history[i][j] = audio_section->GetSampleData(data, pos + i, j);
+  } else {
     DecompressionCache tmpCache = cache;
 
     for (unsigned i = 0; i < BLOCK_HISTORY; i++) {
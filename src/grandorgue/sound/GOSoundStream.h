@@ -12,6 +12,8 @@
 #include "GOSoundResample.h"
 
 class GOSoundAudioSection;
+class GOSoundStreamBuffer;
+class GOSoundStreamPrefetcher;
 
 class GOSoundStream {
 private:
@@ -20,17 +22,15 @@ private:
   static constexpr unsigned MAX_WINDOW_LEN = GOSoundResample::POLYPHASE_POINTS;
   /* Maximum number of audio chanels in the source samples */
   static constexpr unsigned MAX_INPUT_CHANNELS = 2;
+  /* Maximum number of compressed frames decoded at once before resampling. A
+   * block of one period plus the resampling window is decoded */
+  static constexpr unsigned DECODE_BLOCK_FRAMES = MAX_FRAME_SIZE;
 
   const GOSoundAudioSection *audio_section;
   const GOSoundResample *resample;
 
   template <class SampleT, uint8_t nChannels> class StreamPtrWindow;
 
-  template <bool format16, uint8_t nChannels> class StreamCacheWindow;
-
-  template <bool format16, unsigned windowLen, uint8_t nChannels>
-  class StreamCacheReadAheadWindow;
-
   typedef void (GOSoundStream::*DecodeBlockFunction)(
     float *pOut, unsigned nOutSamples);
 
@@ -56,15 +56,25 @@ private:
   // -1 means it is not looped sample, otherwise the index of the start segment
   int m_NextStartSegmentIndex;
 
+  /* The streamed frames of the section are read from this buffer. It is
+   * owned by the stream until DetachStreamBuffer(). A copy of the stream
+   * takes the ownership over */
+  GOSoundStreamBuffer *p_StreamBuffer = nullptr;
+  unsigned m_StreamStart;
+  unsigned m_StreamEnd;
+
   GOSoundResample::ResamplingPosition m_ResamplingPos;
 
   /* for decoding compressed format */
   DecompressionCache cache;
 
-  /* A ring buffer for resampling of compressed samples. It has double
-   * MAX_WINDOW_LEN length for having a continous memory region of
-   * MAX_WINDOW_LEN samples */
-  int m_ReadAheadBuffer[MAX_INPUT_CHANNELS * MAX_WINDOW_LEN * 2];
+  /* The last decoded frames of a compressed sample: the frames from
+   * cache.position - windowLen to cache.position - 1. They are required when
+   * the next block starts before cache.position */
+  int m_DecodedTail[MAX_INPUT_CHANNELS * MAX_WINDOW_LEN];
+  /* Whether m_DecodedTail has been decoded from the current cache. It is
+   * reset each time the cache is set from a start segment */
+  bool m_IsTailValid;
 
   /* The block decode functions should provide whatever the normal resolution of
    * the audio is. The fade engine should ensure that this data is always
@@ -72,6 +82,25 @@ private:
   template <class ResamplerT, class WindowT>
   void DecodeBlock(float *pOut, unsigned nOutSamples);
 
+  /* Decodes a block of compressed frames into a continous buffer on the stack
+   * and resamples it with the pointer window */
+  template <class ResamplerT, bool format16, uint8_t nChannels>
+  void DecodeCompressedBlock(float *pOut, unsigned nOutSamples);
+
+  /* Returns the decode function of an uncompressed stream for the resampler */
+  template <class ResamplerT>
+  static DecodeBlockFunction getPtrDecodeBlockFunction(
+    uint8_t channels, uint8_t bits_per_sample);
+
+  /* Returns the decode function of a compressed stream for the resampler */
+  template <class ResamplerT>
+  static DecodeBlockFunction getCompressedDecodeBlockFunction(
+    uint8_t channels, uint8_t bits_per_sample);
+
+  template <class ResamplerT>
+  static DecodeBlockFunction getResamplerDecodeBlockFunction(
+    uint8_t channels, uint8_t bits_per_sample, bool compressed);
+
   static DecodeBlockFunction getDecodeBlockFunction(
     uint8_t channels,
     uint8_t bits_per_sample,
@@ -81,6 +110,11 @@ private:
 
   void GetHistory(int history[BLOCK_HISTORY][MAX_OUTPUT_CHANNELS]) const;
 
+  /* Decodes the streamed frames from the stream buffer or, if they are not
+   * there, from the mapped section. Returns the number of the target samples
+   * decoded */
+  unsigned ReadStreamedBlock(float *buffer, unsigned n_blocks);
+
 public:
   /* Initialize a stream to play this audio section */
   void InitStream(
@@ -96,6 +130,12 @@ public:
     GOSoundResample::InterpolationType interpolation,
     const GOSoundStream *existing_stream);
 
+  /* Acquires a stream buffer if the section has streamed frames ahead. The
+   * buffer is not released by the Init functions */
+  void AttachStreamBuffer(GOSoundStreamPrefetcher &prefetcher);
+  /* Releases the stream buffer if any */
+  void DetachStreamBuffer();
+
   /* Read an audio buffer from an audio section stream */
   bool ReadBlock(float *buffer, unsigned int n_blocks);
 };
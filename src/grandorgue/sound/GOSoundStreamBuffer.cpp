@@ -0,0 +1,110 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOSoundStreamBuffer.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+#include "GOSoundAudioSection.h"
+
+GOSoundStreamBuffer::GOSoundStreamBuffer()
+  : m_Data((RING_FRAMES + MARGIN_FRAMES) * MAX_FRAME_BYTES),
+    m_State(FREE),
+    p_section(nullptr),
+    m_FrameBytes(0),
+    m_Origin(0),
+    m_FillEnd(0),
+    m_WritePos(0),
+    m_ReadPos(0),
+    m_Underruns(0) {}
+
+bool GOSoundStreamBuffer::TryAcquire(
+  const GOSoundAudioSection *pSection, unsigned startPos, bool isToPrime) {
+  int state = FREE;
+
+  if (!m_State.compare_exchange_strong(state, SETUP, std::memory_order_acquire))
+    return false;
+  p_section = pSection;
+  m_FrameBytes = pSection->GetBytesPerSample();
+  m_Origin = startPos;
+  // the resampling window reads a few frames after the streamed ones
+  m_FillEnd = std::min(
+    pSection->GetStreamEnd() + GOSoundAudioSection::getMaxReadAhead(),
+    pSection->GetLength());
+  // the buffer is not published yet, so it may be filled here
+  const unsigned writePos = isToPrime
+    ? CopyFrames(startPos, std::min(startPos + PRIME_FRAMES, m_FillEnd))
+    : startPos;
+
+  m_WritePos.store(writePos, std::memory_order_relaxed);
+  m_ReadPos.store(startPos, std::memory_order_relaxed);
+  // publish the parameters to the prefetcher
+  m_State.store(ACTIVE, std::memory_order_release);
+  return true;
+}
+
+const unsigned char *GOSoundStreamBuffer::Read(
+  unsigned pos, unsigned &availEnd) {
+  if (pos < m_Origin) {
+    availEnd = pos;
+    return nullptr;
+  }
+
+  const unsigned index = (pos - m_Origin) % RING_FRAMES;
+
+  m_ReadPos.store(pos, std::memory_order_release);
+  availEnd = std::min(
+    m_WritePos.load(std::memory_order_acquire),
+    pos - index + RING_FRAMES + MARGIN_FRAMES);
+  // a virtual pointer: the frame of pos has the index offset from the data
+  return m_Data.data() + m_FrameBytes * index - m_FrameBytes * pos;
+}
+
+unsigned GOSoundStreamBuffer::CopyFrames(unsigned writePos, unsigned end) {
+  while (writePos < end) {
+    const unsigned index = (writePos - m_Origin) % RING_FRAMES;
+    const unsigned nFrames = std::min(end - writePos, RING_FRAMES - index);
+    const unsigned char *src
+      = p_section->GetData() + (size_t)m_FrameBytes * writePos;
+
+    memcpy(
+      m_Data.data() + m_FrameBytes * index, src, m_FrameBytes * nFrames);
+    if (index < MARGIN_FRAMES)
+      memcpy(
+        m_Data.data() + m_FrameBytes * (RING_FRAMES + index),
+        src,
+        m_FrameBytes * std::min(nFrames, MARGIN_FRAMES - index));
+    writePos += nFrames;
+  }
+  return writePos;
+}
+
+unsigned GOSoundStreamBuffer::Fill(unsigned maxFrames) {
+  const int state = m_State.load(std::memory_order_acquire);
+
+  if (state == RELEASING) {
+    m_State.store(FREE, std::memory_order_release);
+    return 0;
+  }
+  if (state != ACTIVE)
+    return 0;
+
+  const unsigned readPos = m_ReadPos.load(std::memory_order_acquire);
+  // after an underrun the stream has gone ahead of the ring
+  const unsigned writePos
+    = std::max(m_WritePos.load(std::memory_order_relaxed), readPos);
+  // the frames before readPos + RING_FRAMES may be overwritten
+  const unsigned end
+    = std::min({m_FillEnd, readPos + RING_FRAMES, writePos + maxFrames});
+
+  if (writePos >= end)
+    return 0;
+  m_WritePos.store(CopyFrames(writePos, end), std::memory_order_release);
+  return end - writePos;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDSTREAMBUFFER_H
+#define GOSOUNDSTREAMBUFFER_H
+
+#include <atomic>
+#include <vector>
+
+class GOSoundAudioSection;
+
+/**
+ * A ring of the frames of a streamed audio section ahead of the playing
+ * position.
+ *
+ * The ring is filled by the prefetcher thread and is read by one sound thread
+ * at a time, so it is a lock-free single-producer single-consumer ring. The
+ * positions only increase. The first MARGIN_FRAMES frames of the ring are
+ * mirrored after its end, so the resampling window may always be read
+ * continuously.
+ *
+ * A buffer is owned by a prefetcher. A sound thread acquires it with
+ * TryAcquire() and gives it back with Release(). Only the prefetcher makes it
+ * free again, so it never fills a buffer acquired by another stream.
+ */
+class GOSoundStreamBuffer {
+public:
+  static constexpr unsigned RING_FRAMES = 16384;
+  static constexpr unsigned MARGIN_FRAMES = 1024;
+  // stereo 24 bit
+  static constexpr unsigned MAX_FRAME_BYTES = 6;
+  // enough frames for the first period of a stream starting in the middle
+  static constexpr unsigned PRIME_FRAMES = 4096;
+
+private:
+  enum State { FREE, SETUP, ACTIVE, RELEASING };
+
+  std::vector<unsigned char> m_Data;
+  std::atomic_int m_State;
+
+  // valid in the ACTIVE and RELEASING states
+  const GOSoundAudioSection *p_section;
+  unsigned m_FrameBytes;
+  // the position stored at the ring index 0
+  unsigned m_Origin;
+  // the position after the last one to be read ahead
+  unsigned m_FillEnd;
+
+  // the frames [m_ReadPos, m_WritePos) are available
+  std::atomic_uint m_WritePos;
+  std::atomic_uint m_ReadPos;
+  std::atomic_uint m_Underruns;
+
+  /* Copies the frames [writePos, end) into the ring. Returns end */
+  unsigned CopyFrames(unsigned writePos, unsigned end);
+
+public:
+  GOSoundStreamBuffer();
+
+  /**
+   * Called by a sound thread. Acquires the buffer if it is free
+   * @param pSection the streamed section
+   * @param startPos the first position to read ahead
+   * @param isToPrime whether to copy the first PRIME_FRAMES frames at once.
+   *   The prefetcher has no time to read them for a stream starting inside
+   *   the streamed frames
+   * @return whether the buffer has been acquired
+   */
+  bool TryAcquire(
+    const GOSoundAudioSection *pSection, unsigned startPos, bool isToPrime);
+  /* Called by a sound thread. Gives the buffer back to the prefetcher */
+  void Release() { m_State.store(RELEASING, std::memory_order_release); }
+
+  /**
+   * Called by a sound thread. Frees the frames before pos for reading ahead
+   * and returns a virtual pointer to the frames from pos, like
+   * GOSoundAudioSection::GetData()
+   * @param pos the current position of the stream
+   * @param availEnd receives the position after the last frame available
+   *   through the pointer
+   */
+  const unsigned char *Read(unsigned pos, unsigned &availEnd);
+  /* Called by a sound thread when the frames have not been read in time */
+  void AddUnderrun() { m_Underruns.fetch_add(1, std::memory_order_relaxed); }
+
+  /**
+   * Called by the prefetcher thread. Copies the next frames into the ring and
+   * makes a released buffer free
+   * @param maxFrames the maximum number of frames to copy at once
+   * @return the number of frames copied
+   */
+  unsigned Fill(unsigned maxFrames);
+  /* Called by the prefetcher thread. Returns the underruns since the last
+   * call */
+  unsigned TakeUnderruns() {
+    return m_Underruns.exchange(0, std::memory_order_relaxed);
+  }
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOSoundStreamPrefetcher.h"
+
+#include <chrono>
+#include <thread>
+
+#include "GOSoundTelemetry.h"
+
+GOSoundStreamPrefetcher::GOSoundStreamPrefetcher(GOSoundTelemetry &telemetry)
+  : r_telemetry(telemetry), m_Buffers(), m_NextBuffer(0), m_Thread(*this) {}
+
+void GOSoundStreamPrefetcher::Start(unsigned nBuffers) {
+  Stop();
+  for (unsigned i = 0; i < nBuffers; i++)
+    m_Buffers.push_back(new GOSoundStreamBuffer());
+  m_Thread.Start();
+}
+
+void GOSoundStreamPrefetcher::Stop() {
+  m_Thread.Stop();
+  m_Buffers.clear();
+}
+
+GOSoundStreamBuffer *GOSoundStreamPrefetcher::Acquire(
+  const GOSoundAudioSection *pSection, unsigned startPos, bool isToPrime) {
+  const unsigned nBuffers = m_Buffers.size();
+  const unsigned first = m_NextBuffer.fetch_add(1, std::memory_order_relaxed);
+
+  for (unsigned i = 0; i < nBuffers; i++) {
+    GOSoundStreamBuffer *buffer = m_Buffers[(first + i) % nBuffers];
+
+    if (buffer->TryAcquire(pSection, startPos, isToPrime))
+      return buffer;
+  }
+  r_telemetry.AddStreamShortage();
+  return nullptr;
+}
+
+void GOSoundStreamPrefetcher::ReleaseAll() {
+  for (unsigned i = 0; i < m_Buffers.size(); i++)
+    m_Buffers[i]->Release();
+}
+
+void GOSoundStreamPrefetcher::PrefetchLoop(GOThread *thread) {
+  while (!thread->ShouldStop()) {
+    unsigned nCopied = 0;
+    unsigned nUnderruns = 0;
+
+    // a round robin over the buffers, so no stream waits for a long copy
+    for (unsigned i = 0; i < m_Buffers.size(); i++) {
+      nCopied += m_Buffers[i]->Fill(FILL_CHUNK_FRAMES);
+      nUnderruns += m_Buffers[i]->TakeUnderruns();
+    }
+    if (nUnderruns)
+      r_telemetry.AddStreamUnderruns(nUnderruns);
+    if (!nCopied)
+      std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_SLEEP_MS));
+  }
+}
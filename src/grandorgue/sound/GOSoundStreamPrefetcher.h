@@ -0,0 +1,77 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDSTREAMPREFETCHER_H
+#define GOSOUNDSTREAMPREFETCHER_H
+
+#include <atomic>
+
+#include "ptrvector.h"
+
+#include "threading/GOThread.h"
+
+#include "GOSoundStreamBuffer.h"
+
+class GOSoundAudioSection;
+class GOSoundTelemetry;
+
+/**
+ * Reads the streamed parts of the audio sections ahead of playing.
+ *
+ * The streamed frames stay in the mapped cache and are not touched until they
+ * are played. Each stream playing such frames gets a GOSoundStreamBuffer. A
+ * background thread copies the frames from the mapping into the buffers, so
+ * the page faults happen outside of the sound threads. Acquiring and
+ * releasing the buffers is lock-free.
+ */
+class GOSoundStreamPrefetcher {
+private:
+  class PrefetchThread : public GOThread {
+  private:
+    GOSoundStreamPrefetcher &r_prefetcher;
+
+  protected:
+    void Entry() override { r_prefetcher.PrefetchLoop(this); }
+
+  public:
+    PrefetchThread(GOSoundStreamPrefetcher &prefetcher)
+      : r_prefetcher(prefetcher) {}
+  };
+
+  // how many frames are copied into one buffer before switching to the next
+  static constexpr unsigned FILL_CHUNK_FRAMES = 4096;
+  // how long the thread sleeps when all buffers are full
+  static constexpr unsigned IDLE_SLEEP_MS = 2;
+
+  GOSoundTelemetry &r_telemetry;
+  ptr_vector<GOSoundStreamBuffer> m_Buffers;
+  // where to start searching for a free buffer
+  std::atomic_uint m_NextBuffer;
+  PrefetchThread m_Thread;
+
+  void PrefetchLoop(GOThread *thread);
+
+public:
+  GOSoundStreamPrefetcher(GOSoundTelemetry &telemetry);
+  ~GOSoundStreamPrefetcher() { Stop(); }
+
+  /* Allocates the buffers and starts the thread */
+  void Start(unsigned nBuffers);
+  /* Stops the thread and frees the buffers. No stream may use them */
+  void Stop();
+
+  /**
+   * Called by a sound thread. Returns a free buffer for the section or
+   * nullptr if all buffers are used. See GOSoundStreamBuffer::TryAcquire()
+   */
+  GOSoundStreamBuffer *Acquire(
+    const GOSoundAudioSection *pSection, unsigned startPos, bool isToPrime);
+  /* Releases all buffers. Called when no stream is played */
+  void ReleaseAll();
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOSoundTelemetry.h"
+
+#include <algorithm>
+
+#include <wx/ffile.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+
+#include "sound/scheduler/GOSoundTask.h"
+
+static constexpr std::memory_order RELAXED = std::memory_order_relaxed;
+
+void GOSoundTelemetry::Histogram::Reset() {
+  for (unsigned i = 0; i < N_BUCKETS; i++)
+    m_Buckets[i].store(0, RELAXED);
+  m_Count.store(0, RELAXED);
+  m_SumNs.store(0, RELAXED);
+  m_MaxNs.store(0, RELAXED);
+}
+
+unsigned GOSoundTelemetry::Histogram::getBucket(uint64_t ns) {
+  uint64_t us = ns / 1000;
+  unsigned bucket = 0;
+
+  while (us && bucket < N_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void GOSoundTelemetry::Histogram::Add(uint64_t ns) {
+  m_Buckets[getBucket(ns)].fetch_add(1, RELAXED);
+  m_Count.fetch_add(1, RELAXED);
+  m_SumNs.fetch_add(ns, RELAXED);
+  updateMax(m_MaxNs, ns);
+}
+
+uint64_t GOSoundTelemetry::Histogram::GetMeanNs() const {
+  const uint64_t count = GetCount();
+
+  return count ? m_SumNs.load(RELAXED) / count : 0;
+}
+
+uint64_t GOSoundTelemetry::Histogram::GetPercentileUs(double percentile) const {
+  uint64_t total = 0;
+
+  for (unsigned i = 0; i < N_BUCKETS; i++)
+    total += GetBucketCount(i);
+
+  const uint64_t limit = (uint64_t)(total * percentile / 100);
+  uint64_t sum = 0;
+
+  for (unsigned i = 0; i < N_BUCKETS; i++) {
+    sum += GetBucketCount(i);
+    if (sum > limit)
+      return getBucketLimitUs(i);
+  }
+  return 0;
+}
+
+GOSoundTelemetry::GOSoundTelemetry()
+  : m_PeriodNs(0),
+    m_LastCallbackStart(0),
+    m_LatePeriods(0),
+    m_Xruns(0),
+    m_StreamUnderruns(0),
+    m_StreamShortages(0) {
+  Reset();
+}
+
+void GOSoundTelemetry::updateMax(std::atomic<uint64_t> &max, uint64_t value) {
+  uint64_t old = max.load(RELAXED);
+
+  while (old < value && !max.compare_exchange_weak(old, value, RELAXED))
+    ;
+}
+
+void GOSoundTelemetry::Reset() {
+  m_CallbackDuration.Reset();
+  m_CallbackJitter.Reset();
+  m_LastCallbackStart.store(0, RELAXED);
+  m_LatePeriods.store(0, RELAXED);
+  m_Xruns.store(0, RELAXED);
+  m_StreamUnderruns.store(0, RELAXED);
+  m_StreamShortages.store(0, RELAXED);
+  for (unsigned i = 0; i < TASK_TYPE_COUNT; i++) {
+    m_Tasks[i].m_Count.store(0, RELAXED);
+    m_Tasks[i].m_SumNs.store(0, RELAXED);
+    m_Tasks[i].m_MaxNs.store(0, RELAXED);
+  }
+  for (unsigned i = 0; i <= MAX_HELPERS; i++)
+    m_GroupHelpers[i].store(0, RELAXED);
+}
+
+void GOSoundTelemetry::SetPeriodLength(
+  unsigned samplesPerBuffer, unsigned sampleRate) {
+  m_PeriodNs.store(
+    sampleRate ? (uint64_t)samplesPerBuffer * 1000000000 / sampleRate : 0,
+    RELAXED);
+}
+
+GOSoundTelemetry::TaskType GOSoundTelemetry::getTaskType(unsigned taskGroup) {
+  switch (taskGroup) {
+  case GOSoundTask::TREMULANT:
+    return TASK_TREMULANT;
+  case GOSoundTask::WINDCHEST:
+    return TASK_WINDCHEST;
+  case GOSoundTask::AUDIOGROUP:
+    return TASK_AUDIOGROUP;
+  case GOSoundTask::AUDIOOUTPUT:
+    return TASK_AUDIOOUTPUT;
+  case GOSoundTask::AUDIORECORDER:
+    return TASK_AUDIORECORDER;
+  case GOSoundTask::RELEASE:
+    return TASK_RELEASE;
+  case GOSoundTask::TOUCH:
+    return TASK_TOUCH;
+  default:
+    return TASK_OTHER;
+  }
+}
+
+const wxChar *GOSoundTelemetry::getTaskTypeName(TaskType type) {
+  static const wxChar *const NAMES[TASK_TYPE_COUNT] = {
+    wxT("tremulant"),
+    wxT("windchest"),
+    wxT("audio group"),
+    wxT("audio output"),
+    wxT("recorder"),
+    wxT("release"),
+    wxT("touch"),
+    wxT("other"),
+  };
+
+  return NAMES[type];
+}
+
+void GOSoundTelemetry::AddCallback(
+  Clock::time_point start, Clock::time_point end) {
+  const uint64_t duration
+    = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  const int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            start.time_since_epoch())
+                            .count();
+  const int64_t lastStartNs = m_LastCallbackStart.exchange(startNs, RELAXED);
+  const uint64_t periodNs = GetPeriodNs();
+
+  m_CallbackDuration.Add(duration);
+  if (lastStartNs && startNs > lastStartNs) {
+    const int64_t deviation = (startNs - lastStartNs) - (int64_t)periodNs;
+
+    m_CallbackJitter.Add(deviation >= 0 ? deviation : -deviation);
+  }
+  if (periodNs && duration > periodNs)
+    m_LatePeriods.fetch_add(1, RELAXED);
+}
+
+void GOSoundTelemetry::AddTaskRun(unsigned taskGroup, uint64_t ns) {
+  TaskStat &stat = m_Tasks[getTaskType(taskGroup)];
+
+  stat.m_Count.fetch_add(1, RELAXED);
+  stat.m_SumNs.fetch_add(ns, RELAXED);
+  updateMax(stat.m_MaxNs, ns);
+}
+
+void GOSoundTelemetry::AddGroupHelpers(unsigned nHelpers) {
+  m_GroupHelpers[std::min(nHelpers, MAX_HELPERS)].fetch_add(1, RELAXED);
+}
+
+static wxString format_histogram(
+  const wxString &name,
+  const GOSoundTelemetry::Histogram &histogram,
+  bool isDetailed) {
+  wxString res = wxString::Format(
+    _("%s: mean %.1f us, 99%% below %llu us, max %.1f us\n"),
+    name,
+    histogram.GetMeanNs() / 1000.0,
+    (unsigned long long)histogram.GetPercentileUs(99),
+    histogram.GetMaxNs() / 1000.0);
+
+  if (isDetailed)
+    for (unsigned i = 0; i < GOSoundTelemetry::Histogram::N_BUCKETS; i++)
+      if (histogram.GetBucketCount(i))
+        res += wxString::Format(
+          wxT("  < %llu us: %llu\n"),
+          (unsigned long long)GOSoundTelemetry::Histogram::getBucketLimitUs(i),
+          (unsigned long long)histogram.GetBucketCount(i));
+  return res;
+}
+
+wxString GOSoundTelemetry::Format(bool isDetailed) const {
+  const uint64_t nPeriods = m_CallbackDuration.GetCount();
+  wxString res = wxString::Format(
+    _("Periods: %llu (%.1f us each), late: %llu, xruns: %llu\n"),
+    (unsigned long long)nPeriods,
+    GetPeriodNs() / 1000.0,
+    (unsigned long long)GetLatePeriods(),
+    (unsigned long long)GetXruns());
+
+  if (GetStreamUnderruns() || GetStreamShortages())
+    res += wxString::Format(
+      _("Streaming underruns: %llu, streams without a buffer: %llu\n"),
+      (unsigned long long)GetStreamUnderruns(),
+      (unsigned long long)GetStreamShortages());
+  res += format_histogram(
+    _("Callback duration"), m_CallbackDuration, isDetailed);
+  res += format_histogram(_("Callback jitter"), m_CallbackJitter, isDetailed);
+
+  res += _("Task time per period:\n");
+  for (unsigned i = 0; i < TASK_TYPE_COUNT; i++) {
+    const TaskStat &stat = m_Tasks[i];
+    const uint64_t count = stat.m_Count.load(RELAXED);
+
+    if (count)
+      res += wxString::Format(
+        _("  %s: %.1f us, %llu runs, max %.1f us per run\n"),
+        getTaskTypeName((TaskType)i),
+        nPeriods ? stat.m_SumNs.load(RELAXED) / 1000.0 / nPeriods : 0.0,
+        (unsigned long long)count,
+        stat.m_MaxNs.load(RELAXED) / 1000.0);
+  }
+
+  res += _("Threads per audio group task:");
+  for (unsigned i = 0; i <= MAX_HELPERS; i++) {
+    const uint64_t count = m_GroupHelpers[i].load(RELAXED);
+
+    if (count)
+      res += wxString::Format(
+        wxT(" %u%s: %llu"),
+        i,
+        i == MAX_HELPERS ? wxT("+") : wxT(""),
+        (unsigned long long)count);
+  }
+  res += wxT("\n");
+  return res;
+}
+
+bool GOSoundTelemetry::Dump(const wxString &fileName) const {
+  wxFFile file(fileName, wxT("w"));
+
+  if (
+    !file.IsOpened() || !file.Write(Format(true), wxConvUTF8)
+    || !file.Close()) {
+    wxLogError(_("Unable to write '%s'"), fileName);
+    return false;
+  }
+  return true;
+}
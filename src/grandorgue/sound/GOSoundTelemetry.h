@@ -0,0 +1,169 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDTELEMETRY_H
+#define GOSOUNDTELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <wx/string.h>
+
+/**
+ * Real-time statistics of the sound engine.
+ *
+ * The values are written by the audio callback and by the sound threads and
+ * are read by the GUI at any time. All counters are relaxed atomics, so
+ * neither side ever blocks. A reader may see the counters of different
+ * periods, so the values are only consistent statistically.
+ */
+class GOSoundTelemetry {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * A histogram of durations with the logarithmic buckets. The bucket 0
+   * contains the durations below 1 us, the bucket i contains the durations
+   * from 2^(i-1) to 2^i us, the last bucket contains all longer durations
+   */
+  class Histogram {
+  public:
+    static constexpr unsigned N_BUCKETS = 24;
+
+  private:
+    std::atomic<uint64_t> m_Buckets[N_BUCKETS];
+    std::atomic<uint64_t> m_Count;
+    std::atomic<uint64_t> m_SumNs;
+    std::atomic<uint64_t> m_MaxNs;
+
+  public:
+    Histogram() { Reset(); }
+
+    void Reset();
+    void Add(uint64_t ns);
+
+    static unsigned getBucket(uint64_t ns);
+    /* Returns the upper bound of the bucket in microseconds */
+    static uint64_t getBucketLimitUs(unsigned bucket) {
+      return (uint64_t)1 << bucket;
+    }
+
+    uint64_t GetBucketCount(unsigned bucket) const {
+      return m_Buckets[bucket].load(std::memory_order_relaxed);
+    }
+    uint64_t GetCount() const {
+      return m_Count.load(std::memory_order_relaxed);
+    }
+    uint64_t GetMeanNs() const;
+    uint64_t GetMaxNs() const {
+      return m_MaxNs.load(std::memory_order_relaxed);
+    }
+    /* Returns the upper bound in us of the bucket of the percentile */
+    uint64_t GetPercentileUs(double percentile) const;
+  };
+
+  enum TaskType {
+    TASK_TREMULANT = 0,
+    TASK_WINDCHEST,
+    TASK_AUDIOGROUP,
+    TASK_AUDIOOUTPUT,
+    TASK_AUDIORECORDER,
+    TASK_RELEASE,
+    TASK_TOUCH,
+    TASK_OTHER,
+    TASK_TYPE_COUNT
+  };
+
+  // the group tasks with more helpers are counted in the last bucket
+  static constexpr unsigned MAX_HELPERS = 32;
+
+private:
+  struct TaskStat {
+    std::atomic<uint64_t> m_Count;
+    std::atomic<uint64_t> m_SumNs;
+    std::atomic<uint64_t> m_MaxNs;
+  };
+
+  std::atomic<uint64_t> m_PeriodNs;
+
+  Histogram m_CallbackDuration;
+  // the difference between the callback interval and the period length
+  Histogram m_CallbackJitter;
+  // the start of the previous callback in ns since the clock epoch. 0 if none
+  std::atomic<int64_t> m_LastCallbackStart;
+
+  std::atomic<uint64_t> m_LatePeriods;
+  std::atomic<uint64_t> m_Xruns;
+  // the streamed frames not read ahead in time
+  std::atomic<uint64_t> m_StreamUnderruns;
+  // the streams started without a free stream buffer
+  std::atomic<uint64_t> m_StreamShortages;
+
+  TaskStat m_Tasks[TASK_TYPE_COUNT];
+  std::atomic<uint64_t> m_GroupHelpers[MAX_HELPERS + 1];
+
+  static void updateMax(std::atomic<uint64_t> &max, uint64_t value);
+
+public:
+  GOSoundTelemetry();
+
+  /* Clears all statistics. The period length is kept */
+  void Reset();
+
+  void SetPeriodLength(unsigned samplesPerBuffer, unsigned sampleRate);
+  uint64_t GetPeriodNs() const {
+    return m_PeriodNs.load(std::memory_order_relaxed);
+  }
+
+  static TaskType getTaskType(unsigned taskGroup);
+  static const wxChar *getTaskTypeName(TaskType type);
+
+  /**
+   * Registers the processing of one period by the audio callback
+   * @param start the time when the callback was entered
+   * @param end the time when the period was completed
+   */
+  void AddCallback(Clock::time_point start, Clock::time_point end);
+  /* Registers an underflow reported by the sound driver */
+  void AddXrun() { m_Xruns.fetch_add(1, std::memory_order_relaxed); }
+  /* Registers the streamed blocks read from the mapping instead of a buffer */
+  void AddStreamUnderruns(unsigned count) {
+    m_StreamUnderruns.fetch_add(count, std::memory_order_relaxed);
+  }
+  /* Registers a stream started without a stream buffer */
+  void AddStreamShortage() {
+    m_StreamShortages.fetch_add(1, std::memory_order_relaxed);
+  }
+  /* Registers one execution of a task of the group GOSoundTask::GetGroup() */
+  void AddTaskRun(unsigned taskGroup, uint64_t ns);
+  /* Registers how many threads have processed a group task in one period */
+  void AddGroupHelpers(unsigned nHelpers);
+
+  const Histogram &GetCallbackDuration() const { return m_CallbackDuration; }
+  const Histogram &GetCallbackJitter() const { return m_CallbackJitter; }
+  uint64_t GetLatePeriods() const {
+    return m_LatePeriods.load(std::memory_order_relaxed);
+  }
+  uint64_t GetXruns() const { return m_Xruns.load(std::memory_order_relaxed); }
+  uint64_t GetStreamUnderruns() const {
+    return m_StreamUnderruns.load(std::memory_order_relaxed);
+  }
+  uint64_t GetStreamShortages() const {
+    return m_StreamShortages.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns a human readable report
+   * @param isDetailed whether to include the buckets of all histograms
+   */
+  wxString Format(bool isDetailed = false) const;
+  /* Writes the detailed report to the file. Returns false on an error */
+  bool Dump(const wxString &fileName) const;
+};
+
+#endif
@@ -75,6 +75,11 @@ int GOSoundJackPort::JackProcessCallback(jack_nframes_t nFrames, void *data) {
   return rc;
 }
 
+int GOSoundJackPort::JackXrunCallback(void *data) {
+  ((GOSoundJackPort *)data)->ReportXrun();
+  return 0;
+}
+
 void GOSoundJackPort::JackShutdownCallback(void *data) {
   // GOSoundJackPort * const jp = (GOSoundJackPort *) data;
 }
@@ -132,6 +137,7 @@ void GOSoundJackPort::Open() {
 
   jack_set_latency_callback(m_JackClient, &JackLatencyCallback, this);
   jack_set_process_callback(m_JackClient, &JackProcessCallback, this);
+  jack_set_xrun_callback(m_JackClient, &JackXrunCallback, this);
   jack_on_shutdown(m_JackClient, &JackShutdownCallback, this);
 
   m_GoBuffer = new float[samples_per_buffer * m_Channels];
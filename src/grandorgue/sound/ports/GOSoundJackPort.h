@@ -40,6 +40,7 @@ private:
     jack_latency_callback_mode_t mode, void *data);
   static int JackProcessCallback(jack_nframes_t nFrames, void *data);
   static void JackShutdownCallback(void *data);
+  static int JackXrunCallback(void *data);
 
   static wxString getName();
 
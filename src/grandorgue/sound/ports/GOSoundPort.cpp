@@ -50,6 +50,8 @@ bool GOSoundPort::AudioCallback(float *outputBuffer, unsigned int nFrames) {
   return m_Sound->AudioCallback(m_Index, outputBuffer, nFrames);
 }
 
+void GOSoundPort::ReportXrun() { m_Sound->GetEngine().GetTelemetry().AddXrun(); }
+
 const wxString &GOSoundPort::GetName() { return m_Name; }
 wxString GOSoundPort::getPortState() {
   if (m_ActualLatency < 0)
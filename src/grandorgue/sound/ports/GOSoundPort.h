@@ -30,6 +30,8 @@ protected:
 
   void SetActualLatency(double latency);
   bool AudioCallback(float *outputBuffer, unsigned int nFrames);
+  /* Called from the callback when the driver reports an output underflow */
+  void ReportXrun();
 
 public:
   GOSoundPort(GOSound *sound, wxString name);
@@ -114,6 +114,8 @@ int GOSoundPortaudioPort::Callback(
   PaStreamCallbackFlags statusFlags,
   void *userData) {
   GOSoundPortaudioPort *port = (GOSoundPortaudioPort *)userData;
+  if (statusFlags & paOutputUnderflow)
+    port->ReportXrun();
   if (port->AudioCallback((float *)output, frameCount))
     return paContinue;
   else
@@ -131,6 +131,8 @@ int GOSoundRtPort::Callback(
   RtAudioStreamStatus status,
   void *userData) {
   GOSoundRtPort *port = (GOSoundRtPort *)userData;
+  if (status & RTAUDIO_OUTPUT_UNDERFLOW)
+    port->ReportXrun();
   if (port->AudioCallback((float *)outputBuffer, nFrames))
     return 0;
   else
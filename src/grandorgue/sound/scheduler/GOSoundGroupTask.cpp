@@ -7,6 +7,10 @@
 
 #include "GOSoundGroupTask.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 #include "GOSoundWindchestTask.h"
 #include "sound/GOSoundEngine.h"
 #include "threading/GOMutexLocker.h"
@@ -16,15 +20,28 @@ GOSoundGroupTask::GOSoundGroupTask(
   : GOSoundBufferItem(samples_per_buffer, 2),
     m_engine(sound_engine),
     m_Condition(m_Mutex),
-    m_ActiveCount(0),
-    m_Done(0),
-    m_Stop(false) {}
+    m_WaiterCount(0),
+    m_State(PHASE_IDLE << PHASE_SHIFT),
+    m_NextSlot(0),
+    m_UsedSlotMask(0),
+    m_Stop(false) {
+  // round the partial buffer size up to whole cache lines
+  m_PartialStride = (samples_per_buffer * 2 + CACHE_LINE_FLOATS - 1)
+    / CACHE_LINE_FLOATS * CACHE_LINE_FLOATS;
+  m_PartialStorage.resize(m_PartialStride * MAX_HELPERS + CACHE_LINE_FLOATS);
+
+  const uintptr_t storageAddr = (uintptr_t)m_PartialStorage.data();
+
+  p_PartialBuffers = m_PartialStorage.data()
+    + (CACHE_LINE_FLOATS - storageAddr / sizeof(float) % CACHE_LINE_FLOATS)
+      % CACHE_LINE_FLOATS;
+}
 
 void GOSoundGroupTask::Reset() {
-  GOMutexLocker locker(m_Mutex);
-  m_Done.store(0);
-  m_ActiveCount.store(0);
+  m_NextSlot.store(0);
+  m_UsedSlotMask.store(0);
   m_Stop.store(false);
+  m_State.store(PHASE_IDLE << PHASE_SHIFT);
 }
 
 void GOSoundGroupTask::Clear() {
@@ -71,90 +88,125 @@ unsigned GOSoundGroupTask::GetCost() {
 
 bool GOSoundGroupTask::GetRepeat() { return true; }
 
-void GOSoundGroupTask::Run(GOSoundThread *pThread) {
-  if (m_Done.load() == 3) // has already processed in this period
-    return;
-  {
-    GOMutexLocker locker(
-      m_Mutex, false, "GOSoundGroupTask::Run.beforeProcess", pThread);
+unsigned GOSoundGroupTask::GetSplitCount(unsigned maxSplits) {
+  // the threads take the samplers one by one from the common lists, so each
+  // part is a chunk of the sampler lists of a dynamic size
+  return std::min(GetCost() / SAMPLERS_PER_SPLIT + 1, maxSplits);
+}
 
-    if (!locker.IsLocked())
+void GOSoundGroupTask::Run(GOSoundThread *pThread) {
+  unsigned state = m_State.load();
+  unsigned newState;
+
+  // enter without locking
+  do {
+    const unsigned phase = getPhase(state);
+
+    if (phase == PHASE_IDLE)
+      // the first thread
+      newState = (PHASE_STARTING << PHASE_SHIFT) | 1;
+    else if (phase == PHASE_RUNNING && (m_Active.Peek() || m_Release.Peek()))
+      // help the other threads
+      newState = state + 1;
+    else
+      // either nothing to help with or it has been processed in this period
       return;
+  } while (!m_State.compare_exchange_weak(state, newState));
 
-    if (m_Done.load() == 0) // the first thread entered to Run()
-    {
-      m_Active.Move();
-      m_Release.Move();
-      m_Done.store(1); // there are some thteads in Run()
-    } else {
-      if (!m_Active.Peek() && !m_Release.Peek())
-        return;
-    }
-    m_ActiveCount.fetch_add(1);
+  if (getPhase(state) == PHASE_IDLE) {
+    m_Active.Move();
+    m_Release.Move();
+    m_State.fetch_add((PHASE_RUNNING - PHASE_STARTING) << PHASE_SHIFT);
   }
 
   // several threads may process the same list in parallel helping each other
-  // at first, they fill their's own buffer instances
-  float buffer[m_SamplesPerBuffer * 2];
-
-  memset(buffer, 0, m_SamplesPerBuffer * 2 * sizeof(float));
-  ProcessList(m_Active, false, buffer);
-  ProcessList(m_Release, true, buffer);
-
-  {
-    GOMutexLocker locker(
-      m_Mutex, false, "GOSoundGroupTask::Run.afterProcess", pThread);
-
-    if (locker.IsLocked()) {
-      if (m_Done.load() == 1)
-      // The first thread is finished. Assign the result to the common buffer
-      {
-        memcpy(m_Buffer, buffer, m_SamplesPerBuffer * 2 * sizeof(float));
-        m_Done.store(2); // some thread has already finished
-      } else
-      // not the first thread. Add the result to the common buffer
-      {
-        for (unsigned i = 0; i < m_SamplesPerBuffer * 2; i++)
-          m_Buffer[i] += buffer[i];
+  // at first, they fill their's own partial buffers
+  const unsigned slot = m_NextSlot.fetch_add(1);
+
+  if (slot < MAX_HELPERS) {
+    float *buffer = p_PartialBuffers + slot * m_PartialStride;
+
+    memset(buffer, 0, m_SamplesPerBuffer * 2 * sizeof(float));
+    ProcessList(m_Active, false, buffer);
+    ProcessList(m_Release, true, buffer);
+    m_UsedSlotMask.fetch_or(1u << slot);
+  }
+  Leave();
+}
+
+void GOSoundGroupTask::Leave() {
+  unsigned state = m_State.fetch_sub(1) - 1;
+
+  // The lists are empty when a thread leaves, so no more threads may enter
+  // when the count reaches 0. The last thread sums the partial buffers
+  if (
+    (state & HELPER_COUNT_MASK) == 0 && getPhase(state) == PHASE_RUNNING
+    && m_State.compare_exchange_strong(state, PHASE_REDUCING << PHASE_SHIFT))
+    Reduce();
+}
+
+void GOSoundGroupTask::Reduce() {
+  const unsigned nValues = m_SamplesPerBuffer * 2;
+  unsigned usedSlots = m_UsedSlotMask.load();
+  bool isFirst = true;
+
+  for (unsigned slot = 0; usedSlots; slot++, usedSlots >>= 1)
+    if (usedSlots & 1) {
+      const float *buffer = p_PartialBuffers + slot * m_PartialStride;
+
+      if (isFirst) {
+        memcpy(m_Buffer, buffer, nValues * sizeof(float));
+        isFirst = false;
+      } else {
+        float *__restrict dst = m_Buffer;
+        const float *__restrict src = buffer;
+
+        // a plain loop over the aligned buffers is vectorized by the compiler
+        for (unsigned i = 0; i < nValues; i++)
+          dst[i] += src[i];
       }
     }
-    if (m_ActiveCount.fetch_sub(1) <= 1) {
-      // the last thread
-      m_Done.store(3); // all threads have finished processing this period
-      m_Condition.Broadcast();
-    }
+  if (isFirst)
+    memset(m_Buffer, 0, nValues * sizeof(float));
+  m_engine.GetTelemetry().AddGroupHelpers(m_NextSlot.load());
+
+  m_State.store(PHASE_DONE << PHASE_SHIFT);
+  // wake up the waiting threads only if there are any
+  if (m_WaiterCount.load() > 0) {
+    GOMutexLocker locker(m_Mutex);
+
+    m_Condition.Broadcast();
   }
 }
 
-void GOSoundGroupTask::Exec() {
-  m_Stop.store(true);
-  Run();
-}
+void GOSoundGroupTask::Exec() { Finish(true); }
 
 void GOSoundGroupTask::Finish(bool stop, GOSoundThread *pThread) {
   if (stop)
     m_Stop.store(true);
   Run(pThread);
-  if (m_Done.load() == 3)
+  if (IsDone())
     return;
 
-  {
-    GOMutexLocker locker(m_Mutex, false, "GOSoundGroupTask::Finish", pThread);
+  GOMutexLocker locker(m_Mutex, false, "GOSoundGroupTask::Finish", pThread);
 
-    while (locker.IsLocked() && m_Done.load() != 3
-           && (pThread == nullptr || !pThread->ShouldStop()))
+  if (locker.IsLocked()) {
+    m_WaiterCount.fetch_add(1);
+    while (!IsDone() && (pThread == nullptr || !pThread->ShouldStop()))
       m_Condition.WaitOrStop("GOSoundGroupTask::Finish", pThread);
+    m_WaiterCount.fetch_sub(1);
   }
 }
 
 void GOSoundGroupTask::WaitAndClear() {
   GOMutexLocker locker(m_Mutex, false, "ClearAndWait::WaitAndClear");
 
+  m_WaiterCount.fetch_add(1);
   // wait for no threads are inside Run()
-  while (m_Done.load() > 0 && m_Done.load() < 3)
+  while (getPhase(m_State.load()) != PHASE_IDLE && !IsDone())
     m_Condition.WaitOrStop("ClearAndWait::ClearAndWait", NULL);
+  m_WaiterCount.fetch_sub(1);
 
-  // Now it is safe to clear because m_Mutex is locked and no other threads can
-  // enter in Run()
+  // Now it is safe to clear because the sound threads do not give work
   Clear();
 }
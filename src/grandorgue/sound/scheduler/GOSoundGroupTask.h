@@ -9,6 +9,7 @@
 #define GOSOUNDGROUPTASK_H
 
 #include <atomic>
+#include <vector>
 
 #include "GOSoundThread.h"
 #include "sound/GOSoundBufferItem.h"
@@ -21,25 +22,59 @@ class GOSoundEngine;
 
 class GOSoundGroupTask : public GOSoundTask, public GOSoundBufferItem {
 private:
+  // the number of samplers worth to give to one more thread
+  static constexpr unsigned SAMPLERS_PER_SPLIT = 16;
+  // the maximum number of threads processing the samplers in parallel
+  static constexpr unsigned MAX_HELPERS = 32;
+  // the alignment of the partial buffers in floats
+  static constexpr unsigned CACHE_LINE_FLOATS = 64 / sizeof(float);
+
+  // processing phases of the period
+  enum Phase : unsigned {
+    // no threads have entered into Run()
+    PHASE_IDLE = 0,
+    // the first thread is moving the sampler lists
+    PHASE_STARTING,
+    // the threads are processing the samplers
+    PHASE_RUNNING,
+    // the last thread is summing the partial buffers
+    PHASE_REDUCING,
+    // m_Buffer contains the result of the period
+    PHASE_DONE
+  };
+  // m_State contains the phase in the high bits and the number of the threads
+  // inside Run() in the low bits
+  static constexpr unsigned PHASE_SHIFT = 16;
+  static constexpr unsigned HELPER_COUNT_MASK = (1u << PHASE_SHIFT) - 1;
+
   GOSoundEngine &m_engine;
   GOSoundSamplerList m_Active;
   GOSoundSamplerList m_Release;
+  // used only for waiting in Finish()
   GOMutex m_Mutex;
   GOCondition m_Condition;
+  std::atomic_uint m_WaiterCount;
 
-  // the number of threads are processing the samples
-  std::atomic_uint m_ActiveCount;
-
-  // processing state
-  //   0 - no threads are processing the samples
-  //   1 - some threads are processing the samples and none has finished
-  //   2 - some thread has finished processing samples but not all
-  //   3 - all threads have finished processing samples
-  std::atomic_uint m_Done;
+  std::atomic_uint m_State;
+  // the next free partial buffer
+  std::atomic_uint m_NextSlot;
+  // bit mask of the partial buffers containing a result of this period
+  std::atomic_uint m_UsedSlotMask;
   std::atomic_bool m_Stop;
 
+  // each helping thread renders into its own partial buffer. The buffers are
+  // aligned to the cache line so the threads do not share the lines
+  std::vector<float> m_PartialStorage;
+  float *p_PartialBuffers;
+  unsigned m_PartialStride;
+
+  static unsigned getPhase(unsigned state) { return state >> PHASE_SHIFT; }
+  bool IsDone() const { return getPhase(m_State.load()) == PHASE_DONE; }
+
   void ProcessList(
     GOSoundSamplerList &list, bool toDropOld, float *output_buffer);
+  void Leave();
+  void Reduce();
 
 public:
   GOSoundGroupTask(GOSoundEngine &sound_engine, unsigned samples_per_buffer);
@@ -47,6 +82,7 @@ public:
   unsigned GetGroup();
   unsigned GetCost();
   bool GetRepeat();
+  unsigned GetSplitCount(unsigned maxSplits) override;
   void Run(GOSoundThread *pThread = nullptr);
   void Exec();
   void Finish(bool stop, GOSoundThread *pThread = nullptr);
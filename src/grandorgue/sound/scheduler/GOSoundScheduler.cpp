@@ -7,56 +7,116 @@
 
 #include "GOSoundScheduler.h"
 
+#include <algorithm>
+#include <thread>
+
+#include "sound/GOSoundTelemetry.h"
 #include "sound/scheduler/GOSoundTask.h"
 #include "threading/GOMutexLocker.h"
 
 GOSoundScheduler::GOSoundScheduler()
   : m_Work(),
     m_Tasks(),
+    m_Deques(),
     m_IsNotGivingWork(false),
-    m_ItemCount(0),
-    m_RepeatCount(0) {}
+    m_IsUpdating(false),
+    m_TakerCount(0),
+    m_RepeatCount(0),
+    m_WorkerCount(0),
+    p_Telemetry(nullptr) {
+  Update();
+}
 
 GOSoundScheduler::~GOSoundScheduler() {
   GOMutexLocker lock(m_Mutex);
-  Lock();
+
+  for (unsigned i = 0; i < m_Deques.size(); i++)
+    m_Deques[i]->m_Range.store(0);
 }
 
 void GOSoundScheduler::SetRepeatCount(unsigned count) {
+  GOMutexLocker lock(m_Mutex);
+
   m_RepeatCount = count;
+  Update();
+}
+
+void GOSoundScheduler::SetWorkerCount(unsigned count) {
   GOMutexLocker lock(m_Mutex);
-  Lock();
+
+  m_WorkerCount = count;
   Update();
-  Unlock();
 }
 
 void GOSoundScheduler::Clear() {
   GOMutexLocker lock(m_Mutex);
-  Lock();
+
   m_Work.clear();
   Update();
-  Unlock();
 }
 
 void GOSoundScheduler::Update() {
   m_Tasks.clear();
-  SortList(m_Work);
-  for (unsigned i = 0; i < m_Work.size();) {
-    unsigned cnt = 1;
-    while (i + cnt < m_Work.size()
-           && m_Work[i]->GetGroup() == m_Work[i + cnt]->GetGroup())
-      cnt++;
-    unsigned rcnt = m_Work[i]->GetRepeat() ? m_RepeatCount : 1;
-    for (unsigned j = 0; j < rcnt; j++)
-      for (unsigned k = 0; k < cnt; k++)
-        m_Tasks.push_back(&m_Work[i + k]);
-    i += cnt;
+  for (GOSoundTask *task : m_Work)
+    if (task)
+      m_Tasks.push_back(task);
+  // the set of the tasks changes rarely, so it is sorted here and not on each
+  // Reset(). The costs change every period, so they are not used for sorting:
+  // the expensive tasks are split between the workers instead
+  std::stable_sort(
+    m_Tasks.begin(), m_Tasks.end(), [](GOSoundTask *a, GOSoundTask *b) {
+      return a->GetGroup() < b->GetGroup();
+    });
+
+  const unsigned nDeques = std::max(m_WorkerCount, 1u);
+  // the maximum number of items in all deques
+  unsigned nItems = 0;
+
+  for (GOSoundTask *task : m_Tasks)
+    nItems += task->GetRepeat() ? std::max(m_RepeatCount, 1u) : 1;
+
+  // the workers may be taking the items now. Stop giving work and wait until
+  // they leave GetNextGroup(), so the deques may be reallocated
+  m_IsUpdating.store(true);
+  while (m_TakerCount.load() > 0)
+    std::this_thread::yield();
+  m_Deques.resize(nDeques);
+  for (unsigned i = 0; i < nDeques; i++) {
+    if (!m_Deques[i])
+      m_Deques[i] = new WorkerDeque();
+    // FillDeques() is called from the audio callback, so it must not allocate
+    m_Deques[i]->m_Items.reserve(nItems / nDeques + 1);
   }
+  FillDeques();
+  m_IsUpdating.store(false);
 }
 
-void GOSoundScheduler::AddList(
-  GOSoundTask *item, std::vector<GOSoundTask *> &list) {
-  list.push_back(item);
+void GOSoundScheduler::FillDeques() {
+  const unsigned nDeques = m_Deques.size();
+
+  // hide the items from the workers while the deques are being filled
+  for (unsigned i = 0; i < nDeques; i++) {
+    m_Deques[i]->m_Range.store(0);
+    m_Deques[i]->m_Items.clear();
+  }
+
+  // m_Tasks is already in the dependency order. Spread the items round-robin,
+  // so each level is shared by all workers and the parts of a split task are
+  // placed into different deques
+  unsigned dequeIndex = 0;
+
+  for (GOSoundTask *task : m_Tasks) {
+    const unsigned nParts = std::clamp(
+      task->GetSplitCount(std::max(m_RepeatCount, 1u)), 1u, nDeques);
+
+    for (unsigned i = 0; i < nParts; i++) {
+      m_Deques[dequeIndex]->m_Items.push_back(task);
+      dequeIndex = (dequeIndex + 1) % nDeques;
+    }
+  }
+
+  for (unsigned i = 0; i < nDeques; i++)
+    m_Deques[i]->m_Range.store(packRange(0, m_Deques[i]->m_Items.size()));
 }
 
 void GOSoundScheduler::Add(GOSoundTask *item) {
@@ -64,81 +124,97 @@ void GOSoundScheduler::Add(GOSoundTask *item) {
     return;
   item->Clear();
   GOMutexLocker lock(m_Mutex);
-  Lock();
-  AddList(item, m_Work);
-  Update();
-  Unlock();
-}
 
-void GOSoundScheduler::RemoveList(
-  GOSoundTask *item, std::vector<GOSoundTask *> &list) {
-  for (unsigned i = 0; i < list.size(); i++)
-    if (list[i] == item)
-      list[i] = nullptr;
+  m_Work.push_back(item);
+  Update();
 }
 
 void GOSoundScheduler::Remove(GOSoundTask *item) {
   GOMutexLocker lock(m_Mutex);
-  RemoveList(item, m_Work);
-}
 
-bool GOSoundScheduler::CompareItem(GOSoundTask *a, GOSoundTask *b) {
-  if (a && b) {
-    if (a->GetGroup() > b->GetGroup())
-      return true;
-    if (a->GetCost() < b->GetCost())
-      return true;
-    return false;
-  }
-  if (!a && b)
-    return true;
-  return false;
+  std::replace(m_Work.begin(), m_Work.end(), item, (GOSoundTask *)nullptr);
+  m_Tasks.erase(
+    std::remove(m_Tasks.begin(), m_Tasks.end(), item), m_Tasks.end());
+  // the items may be being taken by the workers, so only clear them
+  for (unsigned i = 0; i < m_Deques.size(); i++)
+    std::replace(
+      m_Deques[i]->m_Items.begin(),
+      m_Deques[i]->m_Items.end(),
+      item,
+      (GOSoundTask *)nullptr);
 }
 
-void GOSoundScheduler::SortList(std::vector<GOSoundTask *> &list) {
-  for (unsigned i = 0; i + 1 < list.size(); i++) {
-    for (unsigned j = i; j > 0 && CompareItem(list[j], list[j + 1]); j--) {
-      GOSoundTask *tmp = list[j];
-      list[j] = list[j + 1];
-      list[j + 1] = tmp;
-    }
-  }
-}
+void GOSoundScheduler::Reset() {
+  GOMutexLocker lock(m_Mutex);
 
-void GOSoundScheduler::ResetList(std::vector<GOSoundTask *> &list) {
-  SortList(list);
-  for (unsigned i = 0; i < list.size(); i++)
-    if (list[i])
-      list[i]->Reset();
+  for (GOSoundTask *task : m_Tasks)
+    task->Reset();
+  FillDeques();
 }
 
-void GOSoundScheduler::Reset() {
+void GOSoundScheduler::Exec() {
   GOMutexLocker lock(m_Mutex);
-  ResetList(m_Work);
-  m_NextItem.exchange(0);
+
+  for (GOSoundTask *task : m_Tasks) {
+    if (p_Telemetry) {
+      const auto start = GOSoundTelemetry::Clock::now();
+
+      task->Exec();
+      p_Telemetry->AddTaskRun(
+        task->GetGroup(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          GOSoundTelemetry::Clock::now() - start)
+          .count());
+    } else
+      task->Exec();
+  }
 }
 
-void GOSoundScheduler::ExecList(std::vector<GOSoundTask *> &list) {
-  for (unsigned i = 0; i < list.size(); i++)
-    if (list[i])
-      list[i]->Exec();
+void GOSoundScheduler::RunTask(GOSoundTask *task, GOSoundThread *thread) {
+  if (p_Telemetry) {
+    const auto start = GOSoundTelemetry::Clock::now();
+
+    task->Run(thread);
+    p_Telemetry->AddTaskRun(
+      task->GetGroup(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        GOSoundTelemetry::Clock::now() - start)
+        .count());
+  } else
+    task->Run(thread);
 }
 
-void GOSoundScheduler::Exec() {
-  GOMutexLocker lock(m_Mutex);
-  ExecList(m_Work);
+GOSoundTask *GOSoundScheduler::TakeFrom(WorkerDeque &deque) {
+  uint64_t range = deque.m_Range.load();
+
+  while ((uint32_t)range < (uint32_t)(range >> 32)) {
+    if (deque.m_Range.compare_exchange_weak(range, range + 1)) {
+      GOSoundTask *task = deque.m_Items[(uint32_t)range];
+
+      if (task)
+        return task;
+      // the task has been removed. Take the next one
+      range = deque.m_Range.load();
+    }
+  }
+  return nullptr;
 }
 
-GOSoundTask *GOSoundScheduler::GetNextGroup() {
-  do {
-    if (m_IsNotGivingWork.load()) {
-      return nullptr;
+GOSoundTask *GOSoundScheduler::GetNextGroup(unsigned workerIndex) {
+  GOSoundTask *task = nullptr;
+
+  // Update() sees either the counter or this thread sees its flag
+  m_TakerCount.fetch_add(1);
+  if (!m_IsUpdating.load()) {
+    const unsigned nDeques = m_Deques.size();
+
+    // at first take from the own deque, then steal from the next ones
+    for (unsigned i = 0; i < nDeques && !task; i++) {
+      if (m_IsNotGivingWork.load())
+        break;
+      task = TakeFrom(*m_Deques[(workerIndex + i) % nDeques]);
     }
-    unsigned next = m_NextItem.fetch_add(1);
-    if (next >= m_ItemCount)
-      return nullptr;
-    GOSoundTask *item = *m_Tasks[next];
-    if (item)
-      return item;
-  } while (true);
+  }
+  m_TakerCount.fetch_sub(1);
+  return task;
 }
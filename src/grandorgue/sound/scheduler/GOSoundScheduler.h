@@ -8,39 +8,82 @@
 #ifndef GOSOUNDSCHEDULER_H
 #define GOSOUNDSCHEDULER_H
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
+#include "ptrvector.h"
+
 #include "threading/GOMutex.h"
 
 class GOSoundTask;
+class GOSoundTelemetry;
+class GOSoundThread;
 
+/**
+ * Distributes the sound tasks of one period between the GOSoundThread workers.
+ *
+ * The tasks depend on each other in the order tremulant -> windchest -> audio
+ * group -> audio output -> recorder. A dependent task pulls the results of
+ * the tasks it depends on (GetVolume(), Finish()), so any order of execution
+ * is correct. The scheduler only chooses the order that lets the workers start
+ * with the tasks that other tasks wait for.
+ *
+ * Each worker has its own deque of the task items for the current period. It
+ * is filled on Reset() level by level following the dependency order, so the
+ * items of each level are spread between all workers. A worker takes the items
+ * from the front of its own deque. When its deque is empty it steals the front
+ * items of the other deques.
+ *
+ * A task that can be split (GetSplitCount() > 1) is placed into several deques
+ * at once, so several workers may process its parts in parallel.
+ */
 class GOSoundScheduler {
 private:
+  /**
+   * A deque of one worker. The range of the items to give is packed into one
+   * atomic value, so the owner and the thieves may take items without locks
+   */
+  struct alignas(64) WorkerDeque {
+    std::vector<GOSoundTask *> m_Items;
+    // the lower 32 bits are the next item, the higher ones are the end
+    std::atomic<uint64_t> m_Range;
+
+    WorkerDeque() : m_Range(0) {}
+  };
+
   std::vector<GOSoundTask *> m_Work;
-  std::vector<GOSoundTask **> m_Tasks;
+  // all tasks sorted in the dependency order. Rebuilt and sorted on Update()
+  std::vector<GOSoundTask *> m_Tasks;
+  ptr_vector<WorkerDeque> m_Deques;
   // if GetNextGroup() always returns nullptr
   std::atomic_bool m_IsNotGivingWork;
-  std::atomic_uint m_NextItem;
-  std::atomic_uint m_ItemCount;
+  // if the deques are being reallocated, so GetNextGroup() must not touch them
+  std::atomic_bool m_IsUpdating;
+  // the number of the workers inside GetNextGroup()
+  std::atomic_uint m_TakerCount;
   unsigned m_RepeatCount;
+  unsigned m_WorkerCount;
   GOMutex m_Mutex;
+  // receives the execution times of the tasks. May be nullptr
+  GOSoundTelemetry *p_Telemetry;
 
-  void Lock() { m_ItemCount.store(0); }
-  void Unlock() { m_ItemCount.store(m_Tasks.size()); }
-  void Update();
+  static uint64_t packRange(uint32_t next, uint32_t end) {
+    return (uint64_t)end << 32 | next;
+  }
 
-  bool CompareItem(GOSoundTask *a, GOSoundTask *b);
-  void SortList(std::vector<GOSoundTask *> &list);
-  void ResetList(std::vector<GOSoundTask *> &list);
-  void AddList(GOSoundTask *item, std::vector<GOSoundTask *> &list);
-  void RemoveList(GOSoundTask *item, std::vector<GOSoundTask *> &list);
-  void ExecList(std::vector<GOSoundTask *> &list);
+  void Update();
+  void FillDeques();
+  GOSoundTask *TakeFrom(WorkerDeque &deque);
 
 public:
   GOSoundScheduler();
   ~GOSoundScheduler();
 
   void SetRepeatCount(unsigned count);
+  /* Set the number of workers having their own deques */
+  void SetWorkerCount(unsigned count);
+  void SetTelemetry(GOSoundTelemetry *pTelemetry) { p_Telemetry = pTelemetry; }
 
   void Clear();
   void Reset();
@@ -51,7 +94,19 @@ public:
   void PauseGivingWork() { m_IsNotGivingWork.store(true); }
   void ResumeGivingWork() { m_IsNotGivingWork.store(false); }
 
-  GOSoundTask *GetNextGroup();
+  /**
+   * Returns the next task item for the worker
+   * @param workerIndex the index of the calling worker. If it does not have a
+   *   deque then the worker only steals items
+   * @return the task to run or nullptr if there is no more work in the period
+   */
+  GOSoundTask *GetNextGroup(unsigned workerIndex = 0);
+
+  /**
+   * Runs the task got from GetNextGroup() measuring its execution time. The
+   * time includes waiting for the tasks it depends on
+   */
+  void RunTask(GOSoundTask *task, GOSoundThread *thread);
 };
 
 #endif
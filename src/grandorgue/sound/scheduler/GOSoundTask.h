@@ -17,6 +17,16 @@ public:
   virtual unsigned GetGroup() = 0;
   virtual unsigned GetCost() = 0;
   virtual bool GetRepeat() = 0;
+
+  /**
+   * Returns in how many parts the task may be processed by several threads in
+   * parallel during the current period
+   * @param maxSplits the maximum allowed number of parts
+   */
+  virtual unsigned GetSplitCount(unsigned maxSplits) {
+    return GetRepeat() ? maxSplits : 1;
+  }
+
   virtual void Run(GOSoundThread *thread = nullptr) = 0;
   virtual void Exec() = 0;
 
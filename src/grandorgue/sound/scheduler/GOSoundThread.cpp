@@ -14,9 +14,11 @@
 #include "threading/GOMutexLocker.h"
 #include <unistd.h>
 
-GOSoundThread::GOSoundThread(GOSoundScheduler *scheduler)
+GOSoundThread::GOSoundThread(
+  GOSoundScheduler *scheduler, unsigned workerIndex)
   : GOThread(),
     m_Scheduler(scheduler),
+    m_WorkerIndex(workerIndex),
     m_Condition(m_Mutex),
     m_IdleStateReachedCondition(m_Mutex),
     m_IsIdle(false) {
@@ -28,11 +30,11 @@ void GOSoundThread::Entry() {
     bool shouldStop = false;
 
     do {
-      GOSoundTask *next = m_Scheduler->GetNextGroup();
+      GOSoundTask *next = m_Scheduler->GetNextGroup(m_WorkerIndex);
 
       if (next == NULL)
         break;
-      next->Run(this);
+      m_Scheduler->RunTask(next, this);
       shouldStop = ShouldStop();
     } while (!shouldStop);
 
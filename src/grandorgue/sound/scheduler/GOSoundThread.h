@@ -17,6 +17,8 @@ class GOSoundScheduler;
 class GOSoundThread : public GOThread {
 private:
   GOSoundScheduler *m_Scheduler;
+  // the index of the own deque in the scheduler
+  unsigned m_WorkerIndex;
 
   GOMutex m_Mutex;
   GOCondition m_Condition;
@@ -27,7 +29,7 @@ private:
   void Entry();
 
 public:
-  GOSoundThread(GOSoundScheduler *scheduler);
+  GOSoundThread(GOSoundScheduler *scheduler, unsigned workerIndex);
 
   /*
    * === Prerequisites ===
@@ -9,7 +9,13 @@
 
 #include "GOTestCollection.h"
 #include "GOTestDrawStop.h"
+#include "GOTestMidiDispatchIndex.h"
+#include "GOTestMidiEventQueue.h"
 #include "GOTestOrganModel.h"
+#include "GOTestSoundEngine.h"
+#include "GOTestSoundSamplerPool.h"
+#include "GOTestSoundScheduler.h"
+#include "GOTestSoundStream.h"
 #include "GOTestSwitch.h"
 #include "GOTestWindchest.h"
 
@@ -23,7 +29,13 @@ int main() {
 
   /* Instantiate all the test classes here */
   GOTestDrawStop testDrawStop;
+  GOTestMidiDispatchIndex testMidiDispatchIndex;
+  GOTestMidiEventQueue testMidiEventQueue;
   GOTestOrganModel testOrganModel;
+  GOTestSoundEngine testSoundEngine;
+  GOTestSoundSamplerPool testSoundSamplerPool;
+  GOTestSoundScheduler testSoundScheduler;
+  GOTestSoundStream testSoundStream;
   GOTestSwitch testSwitch;
   GOTestWindchest testWindchest;
   /* end of instanciation */
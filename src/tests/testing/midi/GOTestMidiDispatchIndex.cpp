@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestMidiDispatchIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "midi/GOMidiDispatchIndex.h"
+#include "midi/GOMidiEvent.h"
+#include "midi/GOMidiReceiverBase.h"
+
+GOTestMidiDispatchIndex::~GOTestMidiDispatchIndex() {}
+
+static bool contains(const std::vector<unsigned> &handlers, unsigned n) {
+  return std::find(handlers.begin(), handlers.end(), n) != handlers.end();
+}
+
+void GOTestMidiDispatchIndex::run() {
+  std::string message;
+  const unsigned device = 1;
+  const int elementId = 5;
+
+  // the configured receiver is the first, the unconfigured one is the last
+  GOMidiReceiverBase configured(MIDI_RECV_BUTTON);
+  GOMidiReceiverBase unconfigured(MIDI_RECV_BUTTON);
+  GOMidiReceiverBase *receivers[] = {&configured, &unconfigured};
+  GOMidiDispatchIndex index;
+  std::vector<unsigned> handlers;
+
+  GOMidiReceiverEventPattern &pattern
+    = configured.GetEvent(configured.AddNewEvent());
+
+  pattern.type = MIDI_M_NOTE;
+  pattern.channel = 1;
+  pattern.key = 60;
+  unconfigured.SetElementID(elementId);
+
+  auto buildIndex = [&]() {
+    index.Clear(2);
+    for (unsigned i = 0; i < 2; i++)
+      receivers[i]->AddToDispatchIndex(index, i);
+  };
+
+  buildIndex();
+
+  GOMidiEvent note;
+
+  note.SetMidiType(GOMidiEvent::MIDI_NOTE);
+  note.SetDevice(device);
+  note.SetChannel(1);
+  note.SetKey(60);
+  note.SetValue(100);
+  index.Find(note, handlers);
+  message = "The note should be dispatched to the configured receiver only!";
+  this->GOAssert(contains(handlers, 0) && !contains(handlers, 1), message);
+
+  GOMidiEvent setup;
+
+  setup.SetMidiType(GOMidiEvent::MIDI_SYSEX_GO_SETUP);
+  setup.SetDevice(device);
+  setup.SetChannel(2);
+  setup.SetKey(elementId);
+  setup.SetValue(1000);
+  index.Find(setup, handlers);
+  message = "The setup sysex should be dispatched to the receiver without "
+            "events!";
+  this->GOAssert(contains(handlers, 1), message);
+
+  unconfigured.Match(setup);
+  buildIndex();
+
+  GOMidiEvent nrpn;
+
+  nrpn.SetMidiType(GOMidiEvent::MIDI_NRPN);
+  nrpn.SetDevice(device);
+  nrpn.SetChannel(2);
+  nrpn.SetKey(1000);
+  nrpn.SetValue(127);
+  index.Find(nrpn, handlers);
+  message = "The NRPN should be dispatched to the receiver set up by sysex!";
+  this->GOAssert(contains(handlers, 1), message);
+
+  message = "The receiver set up by sysex should match the NRPN!";
+  this->GOAssert(unconfigured.Match(nrpn) == MIDI_MATCH_ON, message);
+}
+
+std::string GOTestMidiDispatchIndex::GetName() { return name; }
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOTESTMIDIDISPATCHINDEX_H
+#define GOTESTMIDIDISPATCHINDEX_H
+
+#include <iostream>
+
+#include "GOTest.h"
+
+class GOTestMidiDispatchIndex : public GOTest {
+
+private:
+  std::string name = "GOTestMidiDispatchIndex";
+
+public:
+  GOTestMidiDispatchIndex() { name = "GOTestMidiDispatchIndex"; }
+  virtual ~GOTestMidiDispatchIndex();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestMidiEventQueue.h"
+
+#include <climits>
+
+#include "midi/GOMidiEvent.h"
+#include "midi/GOMidiEventQueue.h"
+
+static constexpr unsigned SIZE_BITS = 2;
+static constexpr unsigned CAPACITY = 1u << SIZE_BITS;
+
+GOTestMidiEventQueue::~GOTestMidiEventQueue() {}
+
+static GOMidiEvent make_event(int key) {
+  GOMidiEvent e;
+
+  e.SetMidiType(GOMidiEvent::MIDI_NOTE);
+  e.SetChannel(1);
+  e.SetKey(key);
+  e.SetValue(100);
+  return e;
+}
+
+void GOTestMidiEventQueue::TestQueue(
+  unsigned initialPos, const std::string &caseName) {
+  std::string message;
+  GOMidiEventQueue queue(SIZE_BITS, initialPos);
+  GOMidiEvent e;
+  int nextPushKey = 0;
+  int nextPopKey = 0;
+
+  message = caseName + ": a new queue should be empty";
+  this->GOAssert(queue.IsEmpty() && !queue.Pop(e), message);
+
+  // several rounds, so the positions pass the sequence number wrap-around
+  for (unsigned round = 0; round < 3; round++) {
+    for (unsigned i = 0; i < CAPACITY; i++) {
+      message = caseName + ": the event " + std::to_string(nextPushKey)
+        + " should be pushed";
+      this->GOAssert(queue.Push(make_event(nextPushKey++)), message);
+    }
+    message = caseName + ": a full queue should not accept an event";
+    this->GOAssert(!queue.Push(make_event(-1)), message);
+    message = caseName + ": a full queue should not be empty";
+    this->GOAssert(!queue.IsEmpty(), message);
+
+    // free one cell and fill it again
+    message = caseName + ": the first event should be popped";
+    this->GOAssert(queue.Pop(e) && e.GetKey() == nextPopKey++, message);
+    message = caseName + ": a freed cell should accept an event";
+    this->GOAssert(queue.Push(make_event(nextPushKey++)), message);
+    message = caseName + ": the queue should be full again";
+    this->GOAssert(!queue.Push(make_event(-1)), message);
+
+    for (unsigned i = 0; i < CAPACITY; i++) {
+      message = caseName + ": the event " + std::to_string(nextPopKey)
+        + " should be popped in the FIFO order";
+      this->GOAssert(queue.Pop(e) && e.GetKey() == nextPopKey++, message);
+    }
+    message = caseName + ": the queue should be empty after popping all";
+    this->GOAssert(queue.IsEmpty() && !queue.Pop(e), message);
+  }
+}
+
+void GOTestMidiEventQueue::run() {
+  TestQueue(0, "From zero");
+  // the sequence numbers overflow in the second round
+  TestQueue(UINT_MAX - CAPACITY - 2, "Near the wrap-around");
+}
+
+std::string GOTestMidiEventQueue::GetName() { return name; }
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOTESTMIDIEVENTQUEUE_H
+#define GOTESTMIDIEVENTQUEUE_H
+
+#include "GOTest.h"
+
+class GOTestMidiEventQueue : public GOTest {
+
+private:
+  std::string name = "GOTestMidiEventQueue";
+
+  void TestQueue(unsigned initialPos, const std::string &caseName);
+
+public:
+  GOTestMidiEventQueue() { name = "GOTestMidiEventQueue"; }
+  virtual ~GOTestMidiEventQueue();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
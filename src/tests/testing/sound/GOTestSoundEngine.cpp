@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundEngine.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "GOWave.h"
+#include "config/GOAudioDeviceConfig.h"
+#include "sound/GOSoundAudioSection.h"
+#include "sound/GOSoundEngine.h"
+#include "sound/GOSoundProvider.h"
+#include "sound/GOSoundResample.h"
+
+static constexpr unsigned SAMPLE_RATE = 48000;
+static constexpr unsigned PERIOD_FRAMES = 256;
+static constexpr unsigned START_OFFSET = 100;
+static constexpr unsigned STOP_OFFSET = 180;
+
+// a pipe playing a constant attack without a release
+class GOTestConstantProvider : public GOSoundProvider {
+public:
+  GOTestConstantProvider(GOMemoryPool &pool) {
+    const unsigned nFrames = SAMPLE_RATE;
+    std::vector<int16_t> pcm(nFrames, 8000);
+    GOSoundAudioSection *section = new GOSoundAudioSection(pool);
+
+    section->Setup(
+      nullptr,
+      nullptr,
+      pcm.data(),
+      GOWave::SF_SIGNEDSHORT_16,
+      1,
+      SAMPLE_RATE,
+      nFrames,
+      nullptr,
+      BOOL3_DEFAULT,
+      false,
+      0,
+      0);
+    m_Attack.push_back(section);
+    m_AttackInfo.push_back({0, UINT_MAX, BOOL3_DEFAULT});
+    m_Gain = 1.0f;
+    // the decay ends in the period of the stop
+    m_AttackSwitchCrossfadeLength = 1;
+  }
+};
+
+GOTestSoundEngine::~GOTestSoundEngine() {}
+
+void GOTestSoundEngine::run() {
+  std::string message;
+  GOTestConstantProvider provider(this->controller->GetMemoryPool());
+  GOSoundEngine engine;
+  std::vector<GOAudioOutputConfiguration> outputs(1);
+
+  engine.SetSampleRate(SAMPLE_RATE);
+  engine.SetSamplesPerBuffer(PERIOD_FRAMES);
+  engine.SetInterpolationType(GOSoundResample::GO_LINEAR_INTERPOLATION);
+  engine.SetRandomizeSpeaking(false);
+  engine.SetVolume(0);
+  engine.SetAudioGroupCount(1);
+  outputs[0].channels = 2;
+  outputs[0].scale_factors = {
+    {0, GOAudioDeviceConfig::MUTE_VOLUME},
+    {GOAudioDeviceConfig::MUTE_VOLUME, 0}};
+  engine.SetAudioOutput(outputs);
+  engine.Setup(this->controller);
+
+  // both events are received while the first period is being rendered
+  engine.SetEventOffset(START_OFFSET);
+  GOSoundSampler *sampler = engine.StartPipeSample(&provider, 0, 0, 127, 0, 0);
+
+  message = "The sampler has not been started";
+  this->GOAssert(sampler != nullptr, message);
+
+  engine.SetEventOffset(STOP_OFFSET);
+  engine.StopSample(&provider, sampler);
+  engine.SetEventOffset(0);
+
+  // the left channel of all periods rendered
+  std::vector<float> left;
+  std::vector<float> buffer(PERIOD_FRAMES * 2);
+
+  for (unsigned i = 0; i < 4; i++) {
+    engine.GetAudioOutput(buffer.data(), PERIOD_FRAMES, 0, true);
+    engine.NextPeriod();
+    for (unsigned j = 0; j < PERIOD_FRAMES; j++)
+      left.push_back(buffer[j * 2]);
+  }
+
+  unsigned firstFrame = 0;
+
+  while (firstFrame < left.size() && left[firstFrame] == 0.0f)
+    firstFrame++;
+  message = "The note starts at the frame " + std::to_string(firstFrame)
+    + " instead of " + std::to_string(PERIOD_FRAMES + START_OFFSET);
+  this->GOAssert(firstFrame == PERIOD_FRAMES + START_OFFSET, message);
+
+  const float noteVolume = std::fabs(left[PERIOD_FRAMES + STOP_OFFSET - 1]);
+
+  message = "The note does not decay from its stop";
+  this->GOAssert(
+    std::fabs(left[2 * PERIOD_FRAMES - 1]) < noteVolume, message);
+  for (unsigned i = 2 * PERIOD_FRAMES; i < left.size(); i++) {
+    message = "The note sounds after the period of its stop at the frame "
+      + std::to_string(i);
+    this->GOAssert(left[i] == 0.0f, message);
+  }
+}
+
+std::string GOTestSoundEngine::GetName() { return name; }
@@ -0,0 +1,24 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOTESTSOUNDENGINE_H
+#define GOTESTSOUNDENGINE_H
+
+#include "GOTest.h"
+
+class GOTestSoundEngine : public GOCommonControllerTest {
+
+private:
+  std::string name = "GOTestSoundEngine";
+
+public:
+  GOTestSoundEngine() { name = "GOTestSoundEngine"; }
+  virtual ~GOTestSoundEngine();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
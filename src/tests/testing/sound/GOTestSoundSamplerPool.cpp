@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundSamplerPool.h"
+
+#include <thread>
+#include <vector>
+
+#include "sound/GOSoundSampler.h"
+#include "sound/GOSoundSamplerPool.h"
+#include "sound/GOSoundSimpleSamplerList.h"
+
+GOTestSoundSamplerPool::~GOTestSoundSamplerPool() {}
+
+void GOTestSoundSamplerPool::TestSamplerList() {
+  std::string message;
+  GOSoundSampler samplers[3];
+  GOSoundSimpleSamplerList list;
+
+  message = "A new list should be empty";
+  this->GOAssert(list.Get() == nullptr, message);
+
+  for (GOSoundSampler &sampler : samplers)
+    list.Put(&sampler);
+  // the list is a stack
+  for (unsigned i = 3; i > 0; i--) {
+    message = "The sampler " + std::to_string(i - 1)
+      + " should be got in the reverse order of putting";
+    this->GOAssert(list.Get() == &samplers[i - 1], message);
+  }
+  message = "The list should be empty after getting all samplers";
+  this->GOAssert(list.Get() == nullptr, message);
+
+  list.Put(&samplers[0]);
+  message = "A sampler put again should be got again";
+  this->GOAssert(list.Get() == &samplers[0], message);
+
+  list.Put(&samplers[1]);
+  list.Put(&samplers[2]);
+  list.Clear();
+  message = "The list should be empty after Clear";
+  this->GOAssert(list.Get() == nullptr, message);
+}
+
+void GOTestSoundSamplerPool::TestUsageLimit() {
+  std::string message;
+  const unsigned limit = 4;
+  GOSoundSamplerPool pool;
+  std::vector<GOSoundSampler *> samplers;
+
+  pool.SetUsageLimit(limit);
+  for (unsigned i = 0; i < limit; i++) {
+    GOSoundSampler *sampler = pool.GetSampler();
+
+    message = "The sampler " + std::to_string(i) + " is under the limit";
+    this->GOAssert(sampler != nullptr, message);
+    samplers.push_back(sampler);
+  }
+  message = "No sampler should be given above the usage limit";
+  this->GOAssert(pool.GetSampler() == nullptr, message);
+  message = "All samplers should be used";
+  this->GOAssert(pool.UsedSamplerCount() == limit, message);
+
+  pool.ReturnSampler(samplers.back());
+  samplers.pop_back();
+  message = "A returned sampler should be given again";
+  this->GOAssert(pool.GetSampler() != nullptr, message);
+
+  pool.ReturnAll();
+  message = "No sampler should be used after ReturnAll";
+  this->GOAssert(pool.UsedSamplerCount() == 0, message);
+}
+
+void GOTestSoundSamplerPool::TestStrandedSamplers() {
+  std::string message;
+  const unsigned limit = 16;
+  GOSoundSamplerPool pool;
+  std::vector<GOSoundSampler *> samplers;
+
+  pool.SetUsageLimit(limit);
+  for (unsigned i = 0; i < limit; i++)
+    samplers.push_back(pool.GetSampler());
+
+  // a worker thread returns the samplers and keeps some of them in its cache
+  std::thread worker([&]() {
+    for (GOSoundSampler *sampler : samplers)
+      pool.ReturnSampler(sampler);
+  });
+
+  worker.join();
+  message = "All samplers should be returned";
+  this->GOAssert(pool.UsedSamplerCount() == 0, message);
+  for (unsigned i = 0; i < limit; i++) {
+    message = "The sampler " + std::to_string(i)
+      + " should be given although the worker keeps some free samplers";
+    this->GOAssert(pool.GetSampler() != nullptr, message);
+  }
+}
+
+void GOTestSoundSamplerPool::run() {
+  TestSamplerList();
+  TestUsageLimit();
+  TestStrandedSamplers();
+}
+
+std::string GOTestSoundSamplerPool::GetName() { return name; }
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOTESTSOUNDSAMPLERPOOL_H
+#define GOTESTSOUNDSAMPLERPOOL_H
+
+#include "GOTest.h"
+
+class GOTestSoundSamplerPool : public GOTest {
+
+private:
+  std::string name = "GOTestSoundSamplerPool";
+
+  void TestSamplerList();
+  void TestUsageLimit();
+  void TestStrandedSamplers();
+
+public:
+  GOTestSoundSamplerPool() { name = "GOTestSoundSamplerPool"; }
+  virtual ~GOTestSoundSamplerPool();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundScheduler.h"
+
+#include "sound/scheduler/GOSoundScheduler.h"
+#include "sound/scheduler/GOSoundTask.h"
+
+// a task that does nothing
+class GOTestTask : public GOSoundTask {
+private:
+  unsigned m_Group;
+  bool m_IsRepeat;
+
+public:
+  GOTestTask(unsigned group, bool isRepeat = false)
+    : m_Group(group), m_IsRepeat(isRepeat) {}
+
+  unsigned GetGroup() override { return m_Group; }
+  unsigned GetCost() override { return 0; }
+  bool GetRepeat() override { return m_IsRepeat; }
+  void Run(GOSoundThread *thread = nullptr) override {}
+  void Exec() override {}
+  void Clear() override {}
+  void Reset() override {}
+};
+
+GOTestSoundScheduler::~GOTestSoundScheduler() {}
+
+void GOTestSoundScheduler::AssertNext(
+  GOSoundScheduler &scheduler,
+  unsigned workerIndex,
+  GOSoundTask *expected,
+  const std::string &message) {
+  this->GOAssert(scheduler.GetNextGroup(workerIndex) == expected, message);
+}
+
+void GOTestSoundScheduler::TestOneDeque() {
+  GOSoundScheduler scheduler;
+  GOTestTask output(GOSoundTask::AUDIOOUTPUT);
+  GOTestTask tremulant(GOSoundTask::TREMULANT);
+  GOTestTask windchest(GOSoundTask::WINDCHEST);
+
+  AssertNext(scheduler, 0, nullptr, "An empty scheduler should give no task");
+
+  scheduler.Add(&output);
+  scheduler.Add(&tremulant);
+  scheduler.Add(&windchest);
+  scheduler.Reset();
+  AssertNext(scheduler, 0, &tremulant, "The tremulant should be given first");
+  AssertNext(scheduler, 0, &windchest, "The windchest should be given second");
+  AssertNext(scheduler, 0, &output, "The output should be given last");
+  AssertNext(scheduler, 0, nullptr, "No task should be given after the last");
+  AssertNext(scheduler, 0, nullptr, "The deque should stay empty");
+
+  scheduler.Reset();
+  AssertNext(
+    scheduler, 0, &tremulant, "Reset should give the tasks again from first");
+
+  scheduler.Clear();
+  scheduler.Reset();
+  AssertNext(scheduler, 0, nullptr, "A cleared scheduler should give no task");
+}
+
+void GOTestSoundScheduler::TestSeveralDeques() {
+  GOSoundScheduler scheduler;
+  GOTestTask tremulant(GOSoundTask::TREMULANT);
+  GOTestTask windchest(GOSoundTask::WINDCHEST);
+  GOTestTask output(GOSoundTask::AUDIOOUTPUT);
+
+  scheduler.SetWorkerCount(2);
+  scheduler.Add(&tremulant);
+  scheduler.Add(&windchest);
+  scheduler.Add(&output);
+  scheduler.Reset();
+  // the tasks are spread round-robin: the first deque has the tremulant and
+  // the output, the second one has the windchest
+  AssertNext(
+    scheduler, 1, &windchest, "The second worker should take its own task");
+  AssertNext(
+    scheduler, 1, &tremulant, "The second worker should steal the first task");
+  AssertNext(
+    scheduler, 0, &output, "The first worker should take its remaining task");
+  AssertNext(scheduler, 0, nullptr, "No task should remain for the first");
+  AssertNext(scheduler, 1, nullptr, "No task should remain for the second");
+
+  scheduler.Reset();
+  AssertNext(scheduler, 0, &tremulant, "The first worker should start first");
+  AssertNext(scheduler, 0, &output, "The first worker should take its output");
+  AssertNext(
+    scheduler, 0, &windchest, "The first worker should steal the windchest");
+  AssertNext(scheduler, 1, nullptr, "The second worker should find no task");
+}
+
+void GOTestSoundScheduler::TestSplitTask() {
+  GOSoundScheduler scheduler;
+  GOTestTask release(GOSoundTask::RELEASE, true);
+
+  scheduler.SetWorkerCount(2);
+  scheduler.SetRepeatCount(4);
+  scheduler.Add(&release);
+  scheduler.Reset();
+  // the parts are limited by the number of the deques
+  AssertNext(scheduler, 0, &release, "The first part should be given");
+  AssertNext(scheduler, 0, &release, "The second part should be stolen");
+  AssertNext(scheduler, 0, nullptr, "There should be only two parts");
+}
+
+void GOTestSoundScheduler::TestRemoveAndPause() {
+  GOSoundScheduler scheduler;
+  GOTestTask tremulant(GOSoundTask::TREMULANT);
+  GOTestTask windchest(GOSoundTask::WINDCHEST);
+  GOTestTask output(GOSoundTask::AUDIOOUTPUT);
+
+  scheduler.Add(&tremulant);
+  scheduler.Add(&windchest);
+  scheduler.Add(&output);
+  scheduler.Reset();
+  scheduler.Remove(&windchest);
+  AssertNext(scheduler, 0, &tremulant, "The first task should be given");
+  AssertNext(scheduler, 0, &output, "The removed task should be skipped");
+  AssertNext(scheduler, 0, nullptr, "No task should remain after removing");
+
+  scheduler.Reset();
+  scheduler.PauseGivingWork();
+  AssertNext(scheduler, 0, nullptr, "A paused scheduler should give no task");
+  scheduler.ResumeGivingWork();
+  AssertNext(
+    scheduler, 0, &tremulant, "A resumed scheduler should give the tasks");
+}
+
+void GOTestSoundScheduler::run() {
+  TestOneDeque();
+  TestSeveralDeques();
+  TestSplitTask();
+  TestRemoveAndPause();
+}
+
+std::string GOTestSoundScheduler::GetName() { return name; }
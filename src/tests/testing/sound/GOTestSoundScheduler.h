@@ -0,0 +1,38 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOTESTSOUNDSCHEDULER_H
+#define GOTESTSOUNDSCHEDULER_H
+
+#include "GOTest.h"
+
+class GOSoundScheduler;
+class GOSoundTask;
+
+class GOTestSoundScheduler : public GOTest {
+
+private:
+  std::string name = "GOTestSoundScheduler";
+
+  void AssertNext(
+    GOSoundScheduler &scheduler,
+    unsigned workerIndex,
+    GOSoundTask *expected,
+    const std::string &message);
+
+  void TestOneDeque();
+  void TestSeveralDeques();
+  void TestSplitTask();
+  void TestRemoveAndPause();
+
+public:
+  GOTestSoundScheduler() { name = "GOTestSoundScheduler"; }
+  virtual ~GOTestSoundScheduler();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
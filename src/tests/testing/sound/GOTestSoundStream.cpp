@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundStream.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "GOWave.h"
+#include "sound/GOSoundAudioSection.h"
+#include "sound/GOSoundStream.h"
+
+static constexpr unsigned SECTION_RATE = 44100;
+static constexpr unsigned OUTPUT_RATE = 48000;
+static constexpr unsigned SECTION_FRAMES = SECTION_RATE;
+static constexpr unsigned BLOCK_SAMPLES = 100;
+static constexpr unsigned N_BLOCKS = 40;
+
+// a smooth mono wave, so the section is really compressed
+static std::vector<int16_t> make_wave(double freq, double amplitude) {
+  std::vector<int16_t> pcm(SECTION_FRAMES);
+
+  for (unsigned i = 0; i < SECTION_FRAMES; i++)
+    pcm[i] = int16_t(
+      amplitude * std::sin(2 * M_PI * freq * i / SECTION_RATE)
+      + amplitude / 3 * std::sin(2 * M_PI * 3 * freq * i / SECTION_RATE));
+  return pcm;
+}
+
+static void setup_section(
+  GOSoundAudioSection &section,
+  const std::vector<int16_t> &pcm,
+  bool isCompressed) {
+  section.Setup(
+    nullptr,
+    nullptr,
+    pcm.data(),
+    GOWave::SF_SIGNEDSHORT_16,
+    1,
+    SECTION_RATE,
+    SECTION_FRAMES,
+    nullptr,
+    BOOL3_DEFAULT,
+    isCompressed,
+    0,
+    0);
+  section.SetupStreamAlignment({&section}, 0);
+}
+
+GOTestSoundStream::~GOTestSoundStream() {}
+
+void GOTestSoundStream::TestAlignedCompressedStream(
+  GOSoundResample::InterpolationType interpolation) {
+  const std::string interpolationName
+    = interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION
+    ? "polyphase"
+    : "linear";
+  std::string message;
+  GOMemoryPool &pool = this->controller->GetMemoryPool();
+  GOSoundResample resample;
+  const std::vector<int16_t> pcm = make_wave(440, 10000);
+  GOSoundAudioSection plainSection(pool);
+  GOSoundAudioSection compressedSection(pool);
+  GOSoundAudioSection otherSection(pool);
+
+  setup_section(plainSection, pcm, false);
+  setup_section(compressedSection, pcm, true);
+  setup_section(otherSection, make_wave(1000, 5000), true);
+  message = "The test section has not been compressed";
+  this->GOAssert(compressedSection.IsCompressed(), message);
+  this->GOAssert(otherSection.IsCompressed(), message);
+
+  std::vector<float> buffer(2 * BLOCK_SAMPLES);
+  // the stream the release is aligned to
+  GOSoundStream attack;
+
+  attack.InitStream(
+    &resample, &plainSection, interpolation, 1.0f / OUTPUT_RATE);
+  for (unsigned i = 0; i < 7; i++)
+    attack.ReadBlock(buffer.data(), BLOCK_SAMPLES);
+
+  GOSoundStream plain;
+  GOSoundStream compressed;
+
+  // the compressed stream has decoded another section before, like a reused
+  // sampler
+  compressed.InitStream(
+    &resample, &otherSection, interpolation, 1.0f / OUTPUT_RATE);
+  for (unsigned i = 0; i < 3; i++)
+    compressed.ReadBlock(buffer.data(), BLOCK_SAMPLES);
+
+  plain.InitAlignedStream(&plainSection, interpolation, &attack);
+  compressed.InitAlignedStream(&compressedSection, interpolation, &attack);
+
+  std::vector<float> compressedBuffer(2 * BLOCK_SAMPLES);
+
+  for (unsigned i = 0; i < N_BLOCKS; i++) {
+    plain.ReadBlock(buffer.data(), BLOCK_SAMPLES);
+    compressed.ReadBlock(compressedBuffer.data(), BLOCK_SAMPLES);
+    for (unsigned j = 0; j < 2 * BLOCK_SAMPLES; j++) {
+      message = "The compressed " + interpolationName
+        + " stream differs from the uncompressed one at the sample "
+        + std::to_string(i * BLOCK_SAMPLES + j / 2);
+      this->GOAssert(
+        std::fabs(compressedBuffer[j] - buffer[j]) < 0.5f, message);
+    }
+  }
+}
+
+void GOTestSoundStream::run() {
+  TestAlignedCompressedStream(GOSoundResample::GO_LINEAR_INTERPOLATION);
+  TestAlignedCompressedStream(GOSoundResample::GO_POLYPHASE_INTERPOLATION);
+}
+
+std::string GOTestSoundStream::GetName() { return name; }
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOTESTSOUNDSTREAM_H
+#define GOTESTSOUNDSTREAM_H
+
+#include "GOTest.h"
+#include "sound/GOSoundResample.h"
+
+class GOTestSoundStream : public GOCommonControllerTest {
+
+private:
+  std::string name = "GOTestSoundStream";
+
+  void TestAlignedCompressedStream(
+    GOSoundResample::InterpolationType interpolation);
+
+public:
+  GOTestSoundStream() { name = "GOTestSoundStream"; }
+  virtual ~GOTestSoundStream();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
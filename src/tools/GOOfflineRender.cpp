@@ -0,0 +1,410 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/image.h>
+#include <wx/stopwatch.h>
+
+#include "ptrvector.h"
+
+#include "config/GOAudioDeviceConfig.h"
+#include "config/GOConfig.h"
+#include "dialogs/GOProgressDialog.h"
+#include "midi/GOMidiEvent.h"
+#include "midi/GOMidiFileReader.h"
+#include "midi/GOMidiMap.h"
+#include "midi/GOMidiPlayerContent.h"
+#include "sound/GOSoundDefs.h"
+#include "sound/GOSoundEngine.h"
+#include "sound/GOSoundRecorder.h"
+#include "sound/scheduler/GOSoundScheduler.h"
+#include "sound/scheduler/GOSoundThread.h"
+
+#include "GOOrgan.h"
+#include "GOOrganController.h"
+
+/**
+ * Reports the loading progress to the log instead of showing a dialog
+ */
+class GOOfflineRenderProgress : public GOProgressDialog {
+private:
+  long m_max;
+  long m_const;
+  unsigned m_LastPercent;
+
+public:
+  GOOfflineRenderProgress() : m_max(1), m_const(0), m_LastPercent(0) {}
+
+  void Setup(long max, const wxString &title, const wxString &msg) override {
+    wxLogMessage(wxT("%s"), title);
+    m_max = max ? max : 1;
+    m_const = 0;
+    m_LastPercent = 0;
+  }
+
+  void Reset(long max, const wxString &msg) override {
+    m_const = m_max;
+    m_max += max;
+  }
+
+  bool Update(unsigned value, const wxString &msg) override {
+    const unsigned percent = 100 * (m_const + value) / m_max;
+
+    if (percent >= m_LastPercent + 10) {
+      m_LastPercent = percent;
+      wxLogMessage(wxT("%u%%"), percent);
+    }
+    return true;
+  }
+};
+
+/**
+ * Renders a MIDI file played on an organ to a wave file as fast as possible
+ * without any audio device.
+ *
+ * The sound engine is driven the same way as GOSound::AudioCallback does, but
+ * the next period is started as soon as the previous one has been calculated.
+ * The engine schedules the MIDI events into the next period, so the events
+ * of each period are dispatched one period ahead, each with its exact frame
+ * offset inside the period. The result does not depend on the rendering
+ * speed.
+ */
+class GOOfflineRenderApp : public wxApp {
+private:
+  static const wxCmdLineEntryDesc m_cmdLineDesc[];
+
+  wxString m_OrganPath;
+  wxString m_MidiPath;
+  wxString m_OutputPath;
+  wxString m_CombinationPath;
+  long m_SampleRate;
+  long m_SamplesPerBuffer;
+  long m_ThreadCount;
+  long m_BytesPerSample;
+  long m_TailMs;
+
+  void SendNotesOff(
+    GOOrganController *organController,
+    unsigned deviceId,
+    unsigned frameOffset);
+  bool Render();
+
+public:
+  GOOfflineRenderApp();
+
+  bool OnInit();
+  int OnRun();
+  void OnInitCmdLine(wxCmdLineParser &parser);
+  bool OnCmdLineParsed(wxCmdLineParser &parser);
+};
+
+DECLARE_APP(GOOfflineRenderApp)
+IMPLEMENT_APP_CONSOLE(GOOfflineRenderApp)
+
+const wxCmdLineEntryDesc GOOfflineRenderApp::m_cmdLineDesc[] = {
+  {wxCMD_LINE_SWITCH,
+   wxTRANSLATE("h"),
+   wxTRANSLATE("help"),
+   wxTRANSLATE("displays help on the command line parameters"),
+   wxCMD_LINE_VAL_NONE,
+   wxCMD_LINE_OPTION_HELP},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("c"),
+   wxTRANSLATE("combination"),
+   wxTRANSLATE("combination file to load after the organ"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("r"),
+   wxTRANSLATE("sample-rate"),
+   wxTRANSLATE("sample rate of the output"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("b"),
+   wxTRANSLATE("samples-per-buffer"),
+   wxTRANSLATE("number of frames rendered in one period"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("j"),
+   wxTRANSLATE("threads"),
+   wxTRANSLATE("number of the sound threads"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("f"),
+   wxTRANSLATE("bytes-per-sample"),
+   wxTRANSLATE("wave format: 1 = 8 bit, 2 = 16 bit, 3 = 24 bit, 4 = float"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("t"),
+   wxTRANSLATE("tail"),
+   wxTRANSLATE("milliseconds rendered after the end of the MIDI file"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("organ definition file"),
+   wxCMD_LINE_VAL_STRING,
+   0},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("MIDI file"),
+   wxCMD_LINE_VAL_STRING,
+   0},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("output wave file"),
+   wxCMD_LINE_VAL_STRING,
+   0},
+  {wxCMD_LINE_NONE}};
+
+GOOfflineRenderApp::GOOfflineRenderApp()
+  : m_SampleRate(0),
+    m_SamplesPerBuffer(0),
+    m_ThreadCount(-1),
+    m_BytesPerSample(0),
+    m_TailMs(5000) {}
+
+bool GOOfflineRenderApp::OnInit() {
+  wxLog *logger = new wxLogStream(&std::cout);
+  wxLog::SetActiveTarget(logger);
+  wxLog::SetLogLevel(wxLOG_Status);
+  wxImage::AddHandler(new wxJPEGHandler);
+  wxImage::AddHandler(new wxGIFHandler);
+  wxImage::AddHandler(new wxPNGHandler);
+  wxImage::AddHandler(new wxBMPHandler);
+  wxImage::AddHandler(new wxICOHandler);
+
+  return wxApp::OnInit();
+}
+
+void GOOfflineRenderApp::OnInitCmdLine(wxCmdLineParser &parser) {
+  parser.SetDesc(m_cmdLineDesc);
+}
+
+bool GOOfflineRenderApp::OnCmdLineParsed(wxCmdLineParser &parser) {
+  m_OrganPath = parser.GetParam(0);
+  m_MidiPath = parser.GetParam(1);
+  m_OutputPath = parser.GetParam(2);
+  parser.Found(wxT("c"), &m_CombinationPath);
+  parser.Found(wxT("r"), &m_SampleRate);
+  parser.Found(wxT("b"), &m_SamplesPerBuffer);
+  parser.Found(wxT("j"), &m_ThreadCount);
+  parser.Found(wxT("f"), &m_BytesPerSample);
+  parser.Found(wxT("t"), &m_TailMs);
+  if (m_TailMs < 0) {
+    wxLogError(wxT("The tail must not be negative"));
+    return false;
+  }
+  return true;
+}
+
+void GOOfflineRenderApp::SendNotesOff(
+  GOOrganController *organController, unsigned deviceId, unsigned frameOffset) {
+  // the same as GOMidiPlayer::StopPlaying() does
+  for (unsigned i = 1; i < 16; i++) {
+    GOMidiEvent e;
+
+    e.SetMidiType(GOMidiEvent::MIDI_CTRL_CHANGE);
+    e.SetChannel(i);
+    e.SetKey(MIDI_CTRL_NOTES_OFF);
+    e.SetValue(0);
+    e.SetDevice(deviceId);
+    e.SetTime(wxGetLocalTimeMillis());
+    organController->ProcessMidi(e, frameOffset);
+  }
+}
+
+bool GOOfflineRenderApp::Render() {
+  GOConfig settings(wxEmptyString);
+
+  // use the same cache, organ settings and midi map as GrandOrgue does
+  settings.Load();
+
+  GOOrganController *organController
+    = new GOOrganController(settings, nullptr, true);
+  GOSoundEngine *engine = new GOSoundEngine();
+  GOSoundRecorder recorder;
+  ptr_vector<GOSoundThread> threads;
+  bool isOk = false;
+
+  try {
+    GOOfflineRenderProgress progress;
+    const wxString error = organController->Load(
+      &progress, GOOrgan(m_OrganPath), m_CombinationPath, false);
+
+    if (!error.IsEmpty()) {
+      if (error != wxT("!"))
+        wxLogError(wxT("%s"), error);
+      throw wxString(_("Unable to load the organ"));
+    }
+
+    const unsigned sampleRate
+      = m_SampleRate > 0 ? m_SampleRate : settings.SampleRate();
+    const unsigned samplesPerBuffer = m_SamplesPerBuffer > 0
+      ? std::min((unsigned)m_SamplesPerBuffer, (unsigned)MAX_FRAME_SIZE)
+      : settings.SamplesPerBuffer();
+    const unsigned nThreads
+      = m_ThreadCount >= 0 ? m_ThreadCount : settings.Concurrency();
+    const unsigned audioGroupCount = settings.GetAudioGroups().size();
+
+    engine->SetSamplesPerBuffer(samplesPerBuffer);
+    engine->SetVolume(organController->GetVolume());
+    engine->SetPolyphonyLimiting(settings.ManagePolyphony());
+    engine->SetHardPolyphony(settings.PolyphonyLimit());
+    engine->SetScaledReleases(settings.ScaleRelease());
+    engine->SetRandomizeSpeaking(settings.RandomizeSpeaking());
+    engine->SetInterpolationType(settings.InterpolationType());
+    engine->SetAudioGroupCount(audioGroupCount);
+    engine->SetSampleRate(sampleRate);
+
+    // one stereo output having all audio groups
+    std::vector<GOAudioOutputConfiguration> engineConfig(1);
+
+    engineConfig[0].channels = 2;
+    engineConfig[0].scale_factors.resize(2);
+    for (unsigned j = 0; j < 2; j++) {
+      std::vector<float> &scaleFactors = engineConfig[0].scale_factors[j];
+
+      scaleFactors.resize(audioGroupCount * 2);
+      for (unsigned k = 0; k < audioGroupCount; k++) {
+        scaleFactors[k * 2] = j == 0 ? 0 : GOAudioDeviceConfig::MUTE_VOLUME;
+        scaleFactors[k * 2 + 1] = j == 1 ? 0 : GOAudioDeviceConfig::MUTE_VOLUME;
+      }
+    }
+    engine->SetAudioOutput(engineConfig);
+    engine->SetupReverb(settings);
+
+    // SetOutputs() and SetBytesPerSample() close the recorder, so it is opened
+    // only after all of them
+    recorder.SetBytesPerSample(
+      m_BytesPerSample > 0 ? m_BytesPerSample
+                           : settings.WaveFormatBytesPerSample());
+    recorder.SetSampleRate(sampleRate);
+    // rendering is faster than the disk may be. Wait for it instead of
+    // dropping the periods
+    recorder.SetBlocking(true);
+    engine->SetAudioRecorder(&recorder, false);
+    engine->Setup(organController, settings.ReleaseConcurrency());
+    organController->PreparePlayback(engine, nullptr, &recorder);
+
+    recorder.Open(m_OutputPath);
+    if (!recorder.IsOpen())
+      throw wxString(_("Unable to open the output file"));
+
+    GOMidiMap &midiMap = settings.GetMidiMap();
+    GOMidiFileReader reader(midiMap);
+    GOMidiPlayerContent content;
+
+    if (
+      !reader.Open(m_MidiPath)
+      || !content.Load(
+        reader,
+        midiMap,
+        organController->GetODFManualCount() - 1,
+        organController->GetFirstManualIndex() == 0)
+      || !reader.Close())
+      throw wxString::Format(_("Failed to load %s"), m_MidiPath);
+
+    const unsigned deviceId
+      = midiMap.GetDeviceIdByLogicalName(_("GrandOrgue MIDI Player"));
+    GOSoundScheduler &scheduler = engine->GetScheduler();
+
+    scheduler.SetWorkerCount(nThreads);
+    for (unsigned i = 0; i < nThreads; i++)
+      threads.push_back(new GOSoundThread(&scheduler, i));
+    for (unsigned i = 0; i < threads.size(); i++)
+      threads[i]->Run();
+
+    std::vector<float> outputBuffer(samplesPerBuffer * 2);
+    bool isPlaying = content.IsLoaded();
+    uint64_t nFrames = 0;
+    uint64_t endFrame = UINT64_MAX;
+    wxStopWatch watch;
+
+    content.Reset();
+    while (nFrames < endFrame) {
+      // the engine plays the events in the period after the current one, so
+      // dispatch all events due before the end of the next period
+      const uint64_t nextPeriodStart = nFrames + samplesPerBuffer;
+
+      while (isPlaying) {
+        GOMidiEvent e = content.GetCurrentEvent();
+        const uint64_t eventFrame = (uint64_t)e.GetTime() * sampleRate / 1000;
+
+        if (eventFrame >= nextPeriodStart + samplesPerBuffer)
+          break;
+
+        // the exact frame is known, so the event time is not converted
+        const unsigned offsetFrames = eventFrame > nextPeriodStart
+          ? (unsigned)(eventFrame - nextPeriodStart)
+          : 0;
+
+        if (!content.Next()) {
+          isPlaying = false;
+          SendNotesOff(organController, deviceId, offsetFrames);
+          endFrame = nFrames + (uint64_t)m_TailMs * sampleRate / 1000;
+          break;
+        }
+        e.SetDevice(deviceId);
+        organController->ProcessMidi(e, offsetFrames);
+      }
+      if (!isPlaying && endFrame == UINT64_MAX)
+        endFrame = nFrames + (uint64_t)m_TailMs * sampleRate / 1000;
+
+      engine->GetAudioOutput(outputBuffer.data(), samplesPerBuffer, 0, true);
+      engine->NextPeriod();
+      for (unsigned i = 0; i < threads.size(); i++)
+        threads[i]->Wakeup();
+      nFrames += samplesPerBuffer;
+    }
+
+    const long wallMs = std::max(watch.Time(), 1l);
+    const double renderedSeconds = (double)nFrames / sampleRate;
+
+    wxLogMessage(
+      wxT("%s: %f seconds rendered in %ld ms with %u threads, %f x realtime"),
+      m_OutputPath,
+      renderedSeconds,
+      wallMs,
+      nThreads,
+      renderedSeconds * 1000.0 / wallMs);
+    isOk = true;
+  } catch (wxString msg) {
+    wxLogError(wxT("Error: %s"), msg.c_str());
+  }
+
+  for (unsigned i = 0; i < threads.size(); i++)
+    threads[i]->Delete();
+  threads.clear();
+  recorder.Close();
+  if (recorder.GetOverflowCount()) {
+    wxLogError(
+      wxT("%u periods have been dropped from %s"),
+      recorder.GetOverflowCount(),
+      m_OutputPath);
+    isOk = false;
+  }
+  organController->Abort();
+  delete engine;
+  delete organController;
+  return isOk;
+}
+
+int GOOfflineRenderApp::OnRun() { return Render() ? 0 : 1; }
@@ -5,127 +5,195 @@
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
+#include <algorithm>
 #include <iostream>
 
 #include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/file.h>
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/image.h>
-#include <wx/stopwatch.h>
+#include <wx/thread.h>
+#include <wx/wfstream.h>
 
 #include "ptrvector.h"
 
 #include "config/GOConfig.h"
+#include "loader/cache/GOCache.h"
+#include "loader/cache/GOCacheWriter.h"
 #include "model/GOWindchest.h"
 #include "sound/GOSoundEngine.h"
 #include "sound/GOSoundProviderWave.h"
 #include "sound/GOSoundRecorder.h"
+#include "sound/scheduler/GOSoundScheduler.h"
+#include "sound/scheduler/GOSoundThread.h"
 
+#include "GOMemoryPool.h"
 #include "GOOrganController.h"
+#include "GOPerfTestMicro.h"
+#include "GOPerfTestReport.h"
 #include "GOStdPath.h"
 
-#ifdef __linux__
-#include <sys/resource.h>
-#include <sys/time.h>
-#endif
-
 class GOPerfTestApp : public wxApp {
-  wxMilliClock_t getCPUTime();
+private:
+  struct EngineTest {
+    unsigned m_BitsPerSample;
+    bool m_Compress;
+    unsigned m_Samplers;
+    unsigned m_SampleRate;
+    unsigned m_Interpolation;
+    unsigned m_SamplesPerBuffer;
+    GOSoundResample::SimdLevel m_SimdLevel;
+    unsigned m_Threads;
+  };
+
+  static const wxCmdLineEntryDesc m_cmdLineDesc[];
+
+  wxString m_TestsDir;
+  wxString m_JsonPath;
+  long m_Repetitions;
+  bool m_IsMicro;
+  bool m_IsMacro;
+
+  void LoadPipes(
+    GOOrganController *organController,
+    unsigned nPipes,
+    unsigned bitsPerSample,
+    bool compress,
+    ptr_vector<GOSoundProvider> &pipes);
+  void RunEngineTest(
+    GOPerfTestReport &report, const wxString &name, const EngineTest &test);
+  /* Runs the test with the scalar resampler and with the best SIMD one */
+  void RunEngineTests(
+    GOPerfTestReport &report, const wxString &name, EngineTest test);
+
+  void RunEngineMatrix(GOPerfTestReport &report);
+  void RunPolyphonySweep(GOPerfTestReport &report);
+  void RunThreadScaling(GOPerfTestReport &report);
+  void RunLoadTests(GOPerfTestReport &report);
 
 public:
   GOPerfTestApp();
   bool OnInit();
   int OnRun();
-  void RunTest(
-    unsigned bits_per_sample,
-    bool compress,
-    unsigned sample_instances,
-    unsigned sample_rate,
-    unsigned interpolation,
-    unsigned samples_per_frame);
+  void OnInitCmdLine(wxCmdLineParser &parser);
+  bool OnCmdLineParsed(wxCmdLineParser &parser);
 };
 
 DECLARE_APP(GOPerfTestApp)
 IMPLEMENT_APP_CONSOLE(GOPerfTestApp)
 
-GOPerfTestApp::GOPerfTestApp() {}
+const wxCmdLineEntryDesc GOPerfTestApp::m_cmdLineDesc[] = {
+  {wxCMD_LINE_SWITCH,
+   wxTRANSLATE("h"),
+   wxTRANSLATE("help"),
+   wxTRANSLATE("displays help on the command line parameters"),
+   wxCMD_LINE_VAL_NONE,
+   wxCMD_LINE_OPTION_HELP},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("j"),
+   wxTRANSLATE("json"),
+   wxTRANSLATE("write the results to this JSON file"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("r"),
+   wxTRANSLATE("repetitions"),
+   wxTRANSLATE("number of measurements of each benchmark"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("s"),
+   wxTRANSLATE("suite"),
+   wxTRANSLATE("benchmarks to run: micro, macro or all"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("test data directory"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_NONE}};
+
+GOPerfTestApp::GOPerfTestApp()
+  : m_Repetitions(5), m_IsMicro(true), m_IsMacro(true) {}
 
-wxMilliClock_t GOPerfTestApp::getCPUTime() {
-#ifdef __linux__
-  struct rusage usage;
-  if (!getrusage(RUSAGE_SELF, &usage)) {
-    wxMilliClock_t t = usage.ru_utime.tv_sec;
-    t *= 1000;
-    t += usage.ru_utime.tv_usec / 1000;
-    return t;
+void GOPerfTestApp::LoadPipes(
+  GOOrganController *organController,
+  unsigned nPipes,
+  unsigned bitsPerSample,
+  bool compress,
+  ptr_vector<GOSoundProvider> &pipes) {
+  for (unsigned i = 0; i < nPipes; i++) {
+    GOSoundProviderWave *w = new GOSoundProviderWave();
+
+    w->SetAmplitude(102, 0);
+
+    std::vector<GOSoundProviderWave::AttackFileInfo> attacks;
+    std::vector<GOSoundProviderWave::ReleaseFileInfo> releases;
+    GOSoundProviderWave::AttackFileInfo ainfo;
+
+    ainfo.filename.Assign(wxString::Format(wxT("%02d.wav"), i % 3));
+    ainfo.m_WaveTremulantStateFor = BOOL3_DEFAULT;
+    ainfo.load_release = true;
+    ainfo.percussive = false;
+    ainfo.min_attack_velocity = 0;
+    ainfo.max_playback_time = -1;
+    ainfo.attack_start = 0;
+    ainfo.cue_point = -1;
+    ainfo.release_end = -1;
+    ainfo.loops.clear();
+    ainfo.m_LoopCrossfadeLength = 0;
+    ainfo.m_ReleaseCrossfadeLength = 0;
+    attacks.push_back(ainfo);
+    w->LoadFromMultipleFiles(
+      organController->GetFileStore(),
+      organController->GetMemoryPool(),
+      attacks,
+      releases,
+      bitsPerSample,
+      2,
+      compress,
+      GOSoundProviderWave::LOOP_LOAD_ALL,
+      true,
+      true);
+    pipes.push_back(w);
   }
-#endif
-  return wxGetLocalTimeMillis();
 }
 
-void GOPerfTestApp::RunTest(
-  unsigned bits_per_sample,
-  bool compress,
-  unsigned sample_instances,
-  unsigned sample_rate,
-  unsigned interpolation,
-  unsigned samples_per_frame) {
+void GOPerfTestApp::RunEngineTest(
+  GOPerfTestReport &report, const wxString &name, const EngineTest &test) {
+  // the decode functions are selected when the samplers are started
+  GOSoundResample::SetMaxSimdLevel(test.m_SimdLevel);
   try {
     GOConfig settings(wxT("perftest"));
     GOOrganController *organController = new GOOrganController(settings);
-    const wxString testsDir = argc >= 2 ? argv[1]
-                                        : GOStdPath::GetResourceDir()
-        + wxFileName::GetPathSeparator() + "perftests";
 
-    organController->InitOrganDirectory(testsDir);
+    organController->InitOrganDirectory(m_TestsDir);
     organController->AddWindchest(new GOWindchest(*organController));
     GOSoundEngine *engine = new GOSoundEngine();
     GOSoundRecorder recorder;
+    ptr_vector<GOSoundThread> threads;
 
     try {
       ptr_vector<GOSoundProvider> pipes;
-      for (unsigned i = 0; i < sample_instances; i++) {
-        GOSoundProviderWave *w = new GOSoundProviderWave();
-
-        w->SetAmplitude(102, 0);
-
-        std::vector<GOSoundProviderWave::AttackFileInfo> attacks;
-        std::vector<GOSoundProviderWave::ReleaseFileInfo> releases;
-        GOSoundProviderWave::AttackFileInfo ainfo;
-
-        ainfo.filename.Assign(wxString::Format(wxT("%02d.wav"), i % 3));
-        ainfo.m_WaveTremulantStateFor = BOOL3_DEFAULT;
-        ainfo.load_release = true;
-        ainfo.percussive = false;
-        ainfo.min_attack_velocity = 0;
-        ainfo.max_playback_time = -1;
-        ainfo.attack_start = 0;
-        ainfo.cue_point = -1;
-        ainfo.release_end = -1;
-        ainfo.loops.clear();
-        ainfo.m_LoopCrossfadeLength = 0;
-        ainfo.m_ReleaseCrossfadeLength = 0;
-        attacks.push_back(ainfo);
-        w->LoadFromMultipleFiles(
-          organController->GetFileStore(),
-          organController->GetMemoryPool(),
-          attacks,
-          releases,
-          bits_per_sample,
-          2,
-          compress,
-          GOSoundProviderWave::LOOP_LOAD_ALL,
-          true,
-          true);
-        pipes.push_back(w);
-      }
-      engine->SetSamplesPerBuffer(samples_per_frame);
+
+      LoadPipes(
+        organController,
+        test.m_Samplers,
+        test.m_BitsPerSample,
+        test.m_Compress,
+        pipes);
+      engine->SetSamplesPerBuffer(test.m_SamplesPerBuffer);
       engine->SetVolume(10);
-      engine->SetSampleRate(sample_rate);
+      engine->SetSampleRate(test.m_SampleRate);
       engine->SetPolyphonyLimiting(false);
       engine->SetHardPolyphony(10000);
       engine->SetScaledReleases(true);
       engine->SetAudioGroupCount(1);
-      engine->SetInterpolationType(interpolation);
+      engine->SetInterpolationType(test.m_Interpolation);
 
       std::vector<GOAudioOutputConfiguration> engine_config;
       engine_config.resize(1);
@@ -142,51 +210,61 @@ void GOPerfTestApp::RunTest(
 
       engine->Setup(organController);
 
-      std::vector<GOSoundSampler *> handles;
-      float output_buffer[samples_per_frame * 2];
+      GOSoundScheduler &scheduler = engine->GetScheduler();
 
-      for (unsigned i = 0; i < pipes.size(); i++) {
-        GOSoundSampler *handle
-          = engine->StartPipeSample(pipes[i], 1, 0, 127, 0, 0);
-        if (handle)
-          handles.push_back(handle);
-      }
+      scheduler.SetWorkerCount(test.m_Threads);
+      for (unsigned i = 0; i < test.m_Threads; i++)
+        threads.push_back(new GOSoundThread(&scheduler, i));
+      for (unsigned i = 0; i < threads.size(); i++)
+        threads[i]->Run();
 
-      wxMilliClock_t start = getCPUTime();
-      wxMilliClock_t end;
-      wxMilliClock_t diff;
-      unsigned batch_size = 1 * engine->GetSampleRate() / samples_per_frame;
-      unsigned blocks = 0;
-      do {
-        for (unsigned i = 0; i < batch_size; i++) {
-          engine->GetAudioOutput(output_buffer, samples_per_frame, 0, false);
-          engine->NextPeriod();
-          blocks++;
-        }
-        end = getCPUTime();
-        diff = end - start;
-      } while (diff < 30000);
-
-      float playback_time
-        = blocks * (double)samples_per_frame / engine->GetSampleRate();
-      wxLogMessage(
-        wxT("%u sampler, %f seconds, %u bits, %u, %s, %s, %u block: "
-            "%ld ms cpu time, limit: %f"),
-        pipes.size(),
-        playback_time,
-        bits_per_sample,
-        sample_rate,
-        wxString(compress ? wxT("Y") : wxT("N")),
-        wxString(interpolation == 0 ? wxT("Linear") : wxT("Polyphase")),
-        samples_per_frame,
-        diff.ToLong(),
-        playback_time * 1000.0 * pipes.size() / diff.ToLong());
+      std::vector<float> output_buffer(test.m_SamplesPerBuffer * 2);
+      unsigned nStarted = 0;
+
+      for (unsigned i = 0; i < pipes.size(); i++)
+        if (engine->StartPipeSample(pipes[i], 1, 0, 127, 0, 0))
+          nStarted++;
+
+      // one second of audio in each repetition
+      const unsigned nPeriods = test.m_SampleRate / test.m_SamplesPerBuffer;
 
+      report.Measure(
+        name,
+        {{wxT("samplers"), wxString::Format(wxT("%u"), nStarted)},
+         {wxT("bits"), wxString::Format(wxT("%u"), test.m_BitsPerSample)},
+         {wxT("compressed"), test.m_Compress ? wxT("true") : wxT("false")},
+         {wxT("sample_rate"), wxString::Format(wxT("%u"), test.m_SampleRate)},
+         {wxT("interpolation"),
+          test.m_Interpolation == 0 ? wxT("linear") : wxT("polyphase")},
+         {wxT("samples_per_buffer"),
+          wxString::Format(wxT("%u"), test.m_SamplesPerBuffer)},
+         {wxT("simd"),
+          wxString::FromAscii(GOSoundResample::GetSimdLevelName(
+            GOSoundResample::GetSimdLevel()))},
+         {wxT("threads"), wxString::Format(wxT("%u"), test.m_Threads)}},
+        wxT("period"),
+        nPeriods,
+        [&]() {
+          for (unsigned i = 0; i < nPeriods; i++) {
+            engine->GetAudioOutput(
+              output_buffer.data(), test.m_SamplesPerBuffer, 0, true);
+            engine->NextPeriod();
+            for (unsigned j = 0; j < threads.size(); j++)
+              threads[j]->Wakeup();
+          }
+        });
+
+      for (unsigned i = 0; i < threads.size(); i++)
+        threads[i]->Delete();
+      threads.clear();
       pipes.clear();
     } catch (wxString msg) {
       wxLogError(wxT("Error: %s"), msg.c_str());
     }
 
+    for (unsigned i = 0; i < threads.size(); i++)
+      threads[i]->Delete();
+    threads.clear();
     delete engine;
     delete organController;
   } catch (wxString msg) {
@@ -194,6 +272,139 @@ void GOPerfTestApp::RunTest(
   }
 }
 
+void GOPerfTestApp::RunEngineTests(
+  GOPerfTestReport &report, const wxString &name, EngineTest test) {
+  GOSoundResample::SetMaxSimdLevel(GOSoundResample::SIMD_AVX2);
+
+  const GOSoundResample::SimdLevel bestLevel = GOSoundResample::GetSimdLevel();
+
+  test.m_SimdLevel = GOSoundResample::SIMD_NONE;
+  RunEngineTest(report, name, test);
+  if (bestLevel != GOSoundResample::SIMD_NONE) {
+    test.m_SimdLevel = bestLevel;
+    RunEngineTest(report, name, test);
+  }
+}
+
+void GOPerfTestApp::RunEngineMatrix(GOPerfTestReport &report) {
+  const unsigned samplers = 300;
+
+  // the configurations measured by the former perftest
+  for (unsigned bits : {8, 16, 24})
+    for (bool compress : {true, false}) {
+      RunEngineTests(
+        report,
+        wxT("engine"),
+        {bits, compress, samplers, 44100, 0, 128, GOSoundResample::SIMD_NONE, 0});
+      RunEngineTests(
+        report,
+        wxT("engine"),
+        {bits, compress, samplers, 48000, 1, 1024, GOSoundResample::SIMD_NONE, 0});
+      RunEngineTests(
+        report,
+        wxT("engine"),
+        {bits, compress, samplers, 48000, 0, 1024, GOSoundResample::SIMD_NONE, 0});
+    }
+}
+
+void GOPerfTestApp::RunPolyphonySweep(GOPerfTestReport &report) {
+  for (unsigned samplers : {50, 100, 200, 400, 800, 1600})
+    RunEngineTests(
+      report,
+      wxT("polyphony_sweep"),
+      {16, false, samplers, 48000, 1, 256, GOSoundResample::SIMD_NONE, 0});
+}
+
+void GOPerfTestApp::RunThreadScaling(GOPerfTestReport &report) {
+  GOSoundResample::SetMaxSimdLevel(GOSoundResample::SIMD_AVX2);
+
+  const GOSoundResample::SimdLevel bestLevel = GOSoundResample::GetSimdLevel();
+  const unsigned nCpus = std::max(wxThread::GetCPUCount(), 1);
+
+  for (unsigned threads = 0; threads <= nCpus;
+       threads = threads ? threads * 2 : 1)
+    RunEngineTest(
+      report,
+      wxT("thread_scaling"),
+      {16, false, 1600, 48000, 1, 256, bestLevel, threads});
+}
+
+void GOPerfTestApp::RunLoadTests(GOPerfTestReport &report) {
+  const unsigned nPipes = 30;
+  const wxString cacheFileName = wxFileName::CreateTempFileName(wxT("goperf"));
+
+  for (unsigned bits : {16, 24})
+    for (bool compress : {false, true}) {
+      try {
+        GOConfig settings(wxT("perftest"));
+        GOOrganController organController(settings);
+        const GOPerfTestReport::Params params
+          = {{wxT("bits"), wxString::Format(wxT("%u"), bits)},
+             {wxT("compressed"), compress ? wxT("true") : wxT("false")}};
+
+        organController.InitOrganDirectory(m_TestsDir);
+        report.Measure(
+          wxT("load_samples"), params, wxT("pipe"), nPipes, [&]() {
+            ptr_vector<GOSoundProvider> pipes;
+
+            LoadPipes(&organController, nPipes, bits, compress, pipes);
+          });
+
+        ptr_vector<GOSoundProvider> pipes;
+
+        LoadPipes(&organController, nPipes, bits, compress, pipes);
+        for (bool compressCache : {false, true}) {
+          GOPerfTestReport::Params cacheParams = params;
+
+          cacheParams.push_back(
+            {wxT("cache_compressed"),
+             compressCache ? wxT("true") : wxT("false")});
+          report.Measure(
+            wxT("cache_write"), cacheParams, wxT("pipe"), nPipes, [&]() {
+              wxFileOutputStream file(cacheFileName);
+              GOCacheWriter writer(
+                file, compressCache, std::max(wxThread::GetCPUCount(), 1));
+              std::vector<GOCacheIndexEntry> entries;
+
+              writer.WriteHeader();
+              for (unsigned i = 0; i < pipes.size(); i++) {
+                writer.StartFrame();
+                entries.push_back({writer.GetPos(), GOHashType()});
+                if (!pipes[i]->SaveCache(writer))
+                  throw wxString(_("Cache write failed"));
+              }
+              if (!writer.WriteIndex(entries))
+                throw wxString(_("Cache write failed"));
+              writer.Close();
+            });
+          report.Measure(
+            wxT("cache_read"), cacheParams, wxT("pipe"), nPipes, [&]() {
+              // mapping the cache file frees the pool, so it needs own one
+              GOMemoryPool pool;
+              wxFile file(cacheFileName);
+              GOCache reader(file, pool);
+              ptr_vector<GOSoundProvider> loaded;
+
+              if (!reader.ReadHeader())
+                throw wxString(_("Cache read failed"));
+              for (unsigned i = 0; i < pipes.size(); i++) {
+                GOSoundProviderWave *w = new GOSoundProviderWave();
+
+                loaded.push_back(w);
+                if (!w->LoadCache(pool, reader))
+                  throw wxString(_("Cache read failed"));
+              }
+              reader.Close();
+              loaded.clear();
+            });
+        }
+      } catch (wxString msg) {
+        wxLogError(wxT("Error: %s"), msg.c_str());
+      }
+    }
+  wxRemoveFile(cacheFileName);
+}
+
 bool GOPerfTestApp::OnInit() {
   wxLog *logger = new wxLogStream(&std::cout);
   wxLog::SetActiveTarget(logger);
@@ -204,32 +415,48 @@ bool GOPerfTestApp::OnInit() {
   wxImage::AddHandler(new wxBMPHandler);
   wxImage::AddHandler(new wxICOHandler);
 
-  if (argc > 2) {
-    wxLogError(wxT("Usage: perftest [test-data-directory]"));
+  return wxApp::OnInit();
+}
+
+void GOPerfTestApp::OnInitCmdLine(wxCmdLineParser &parser) {
+  parser.SetDesc(m_cmdLineDesc);
+}
+
+bool GOPerfTestApp::OnCmdLineParsed(wxCmdLineParser &parser) {
+  wxString suite;
+
+  m_TestsDir = parser.GetParamCount() ? parser.GetParam(0)
+                                      : GOStdPath::GetResourceDir()
+      + wxFileName::GetPathSeparator() + "perftests";
+  parser.Found(wxT("j"), &m_JsonPath);
+  parser.Found(wxT("r"), &m_Repetitions);
+  if (m_Repetitions < 1) {
+    wxLogError(wxT("The number of repetitions must be positive"));
     return false;
   }
+  if (parser.Found(wxT("s"), &suite)) {
+    m_IsMicro = suite == wxT("micro") || suite == wxT("all");
+    m_IsMacro = suite == wxT("macro") || suite == wxT("all");
+    if (!m_IsMicro && !m_IsMacro) {
+      wxLogError(wxT("Unknown suite %s"), suite);
+      return false;
+    }
+  }
   return true;
 }
 
 int GOPerfTestApp::OnRun() {
-  const int samplers = 300;
-  RunTest(8, true, samplers, 44100, 0, 128);
-  RunTest(8, false, samplers, 44100, 0, 128);
-  RunTest(16, true, samplers, 44100, 0, 128);
-  RunTest(16, false, samplers, 44100, 0, 128);
-  RunTest(24, true, samplers, 44100, 0, 128);
-  RunTest(24, false, samplers, 44100, 0, 128);
-  RunTest(8, true, samplers, 48000, 1, 1024);
-  RunTest(8, false, samplers, 48000, 1, 1024);
-  RunTest(16, true, samplers, 48000, 1, 1024);
-  RunTest(16, false, samplers, 48000, 1, 1024);
-  RunTest(24, true, samplers, 48000, 1, 1024);
-  RunTest(24, false, samplers, 48000, 1, 1024);
-  RunTest(8, true, samplers, 48000, 0, 1024);
-  RunTest(8, false, samplers, 48000, 0, 1024);
-  RunTest(16, true, samplers, 48000, 0, 1024);
-  RunTest(16, false, samplers, 48000, 0, 1024);
-  RunTest(24, true, samplers, 48000, 0, 1024);
-  RunTest(24, false, samplers, 48000, 0, 1024);
+  GOPerfTestReport report(m_Repetitions);
+
+  if (m_IsMicro)
+    GOPerfTestMicro(report).Run();
+  if (m_IsMacro) {
+    RunEngineMatrix(report);
+    RunPolyphonySweep(report);
+    RunThreadScaling(report);
+    RunLoadTests(report);
+  }
+  if (!m_JsonPath.IsEmpty() && !report.WriteJson(m_JsonPath))
+    return 1;
   return 0;
 }
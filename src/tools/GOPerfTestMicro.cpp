@@ -0,0 +1,363 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOPerfTestMicro.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "ptrvector.h"
+
+#include "sound/GOSoundAudioSection.h"
+#include "sound/GOSoundBufferItem.h"
+#include "sound/GOSoundCompress.h"
+#include "sound/GOSoundDefs.h"
+#include "sound/GOSoundFader.h"
+#include "sound/GOSoundFilter.h"
+#include "sound/GOSoundResample.h"
+#include "sound/GOSoundReverbEngine.h"
+#include "sound/GOSoundStream.h"
+#include "sound/scheduler/GOSoundOutputTask.h"
+
+#include "GOInt.h"
+#include "GOPerfTestReport.h"
+#include "GOWave.h"
+#include "GOWaveLoop.h"
+
+static const unsigned SOURCE_SAMPLE_RATE = 44100;
+static const unsigned TARGET_SAMPLE_RATE = 48000;
+// the length of the synthetic samples and of the work of one repetition
+static const unsigned SOURCE_FRAMES = SOURCE_SAMPLE_RATE * 2;
+static const unsigned TARGET_FRAMES = TARGET_SAMPLE_RATE;
+static const unsigned PERIOD_FRAMES = 128;
+
+/* An audio group buffer with constant content */
+class GOPerfTestBufferItem : public GOSoundBufferItem {
+public:
+  GOPerfTestBufferItem(unsigned samplesPerBuffer)
+    : GOSoundBufferItem(samplesPerBuffer, 2) {
+    for (unsigned i = 0; i < samplesPerBuffer * 2; i++)
+      m_Buffer[i] = 0.001f * (i % 100);
+  }
+
+  void Finish(bool stop, GOSoundThread *pThread) override {}
+};
+
+static wxString simd_level_name(GOSoundResample::SimdLevel level) {
+  return wxString::FromAscii(GOSoundResample::GetSimdLevelName(level));
+}
+
+GOPerfTestMicro::GOPerfTestMicro(GOPerfTestReport &report)
+  : r_report(report), m_pool() {}
+
+template <class T>
+static void fill_tone(unsigned char *data, unsigned channels, int amplitude) {
+  T *samples = (T *)data;
+
+  // an organ-like tone with a few harmonics and a bit of noise
+  for (unsigned i = 0; i < SOURCE_FRAMES; i++)
+    for (unsigned j = 0; j < channels; j++) {
+      const double t = 2 * M_PI * 440.0 * i / SOURCE_SAMPLE_RATE + j;
+      const double v = 0.6 * sin(t) + 0.25 * sin(2 * t) + 0.1 * sin(3 * t)
+        + 0.05 * ((i * 7919 + j * 104729) % 1000 / 500.0 - 1.0);
+
+      samples[i * channels + j] = (int)(v * amplitude);
+    }
+}
+
+GOSoundAudioSection *GOPerfTestMicro::CreateSection(
+  unsigned bitsPerSample, bool compress, unsigned channels) {
+  const unsigned bytesPerSample = (bitsPerSample + 7) / 8;
+  std::vector<unsigned char> pcm(SOURCE_FRAMES * channels * bytesPerSample);
+  GOWave::SAMPLE_FORMAT format;
+
+  if (bitsPerSample <= 8) {
+    format = GOWave::SF_SIGNEDBYTE_8;
+    fill_tone<GOInt8>(pcm.data(), channels, 0x7f);
+  } else if (bitsPerSample <= 16) {
+    format = GOWave::SF_SIGNEDSHORT_16;
+    fill_tone<GOInt16>(pcm.data(), channels, 0x7fff);
+  } else {
+    format = GOWave::SF_SIGNEDINT24_24;
+    fill_tone<GOInt24>(pcm.data(), channels, 0x7fffff);
+  }
+
+  std::vector<GOWaveLoop> loops(1);
+
+  loops[0].m_StartPosition = SOURCE_FRAMES / 4;
+  loops[0].m_EndPosition = SOURCE_FRAMES - 1;
+
+  GOSoundAudioSection *section = new GOSoundAudioSection(m_pool);
+
+  section->Setup(
+    nullptr,
+    nullptr,
+    pcm.data(),
+    format,
+    channels,
+    SOURCE_SAMPLE_RATE,
+    SOURCE_FRAMES,
+    &loops,
+    BOOL3_DEFAULT,
+    compress,
+    0,
+    0);
+  return section;
+}
+
+void GOPerfTestMicro::RunResampler() {
+  const GOSoundResample::SimdLevel bestLevel
+    = GOSoundResample::GetSimdLevel();
+  GOSoundResample resample;
+  float buffer[PERIOD_FRAMES * 2];
+
+  for (unsigned bits : {8, 16, 24})
+    for (bool compress : {false, true}) {
+      if (compress && bits <= 8)
+        // 8 bit samples are never compressed
+        continue;
+
+      std::unique_ptr<GOSoundAudioSection> section(
+        CreateSection(bits, compress, 2));
+
+      for (auto interpolation :
+           {GOSoundResample::GO_LINEAR_INTERPOLATION,
+            GOSoundResample::GO_POLYPHASE_INTERPOLATION})
+        for (auto level : {GOSoundResample::SIMD_NONE, bestLevel}) {
+          if (level == bestLevel && level == GOSoundResample::SIMD_NONE)
+            // already measured
+            continue;
+          GOSoundResample::SetMaxSimdLevel(level);
+
+          GOSoundStream stream;
+
+          // the decode functions are selected on the initialisation
+          stream.InitStream(
+            &resample,
+            section.get(),
+            interpolation,
+            1.0f / TARGET_SAMPLE_RATE);
+          r_report.Measure(
+            wxT("resampler"),
+            {{wxT("bits"), wxString::Format(wxT("%u"), bits)},
+             {wxT("compressed"), compress ? wxT("true") : wxT("false")},
+             {wxT("interpolation"),
+              interpolation == GOSoundResample::GO_LINEAR_INTERPOLATION
+                ? wxT("linear")
+                : wxT("polyphase")},
+             {wxT("simd"), simd_level_name(level)}},
+            wxT("frame"),
+            TARGET_FRAMES,
+            [&]() {
+              for (unsigned i = 0; i < TARGET_FRAMES; i += PERIOD_FRAMES)
+                stream.ReadBlock(buffer, PERIOD_FRAMES);
+            });
+        }
+      GOSoundResample::SetMaxSimdLevel(bestLevel);
+    }
+}
+
+/* Returns a checksum of the decompressed samples, so they must be computed */
+template <bool format16, unsigned channels>
+static unsigned decompress_section(const GOSoundAudioSection &section) {
+  const GOSoundAudioSection::StartSegment &start = section.GetStartSegment(0);
+  const GOSoundAudioSection::EndSegment &end = section.GetEndSegment(0);
+  DecompressionCache cache = start.cache;
+  int block[MAX_FRAME_SIZE * channels];
+  // unsigned, so the overflow is defined
+  unsigned sum = 0;
+
+  cache.ptr = section.GetData() + (intptr_t)cache.ptr;
+  for (unsigned pos = start.start_offset; pos < end.transition_offset;) {
+    const unsigned n
+      = std::min(end.transition_offset - pos, (unsigned)MAX_FRAME_SIZE);
+
+    DecompressBlock<format16, channels>(cache, block, n);
+    for (unsigned i = 0; i < n * channels; i++)
+      sum += (unsigned)block[i];
+    pos += n;
+  }
+  return sum;
+}
+
+void GOPerfTestMicro::RunDecompression() {
+  for (unsigned bits : {16, 24})
+    for (unsigned channels : {1, 2}) {
+      std::unique_ptr<GOSoundAudioSection> section(
+        CreateSection(bits, true, channels));
+      const GOSoundAudioSection &s = *section;
+      const unsigned nFrames = s.GetEndSegment(0).transition_offset
+        - s.GetStartSegment(0).start_offset;
+      // prevents optimising the decompression away
+      volatile unsigned sum = 0;
+
+      r_report.Measure(
+        wxT("decompression"),
+        {{wxT("bits"), wxString::Format(wxT("%u"), bits)},
+         {wxT("channels"), wxString::Format(wxT("%u"), channels)}},
+        wxT("frame"),
+        nFrames,
+        [&]() {
+          if (bits < 20) {
+            if (channels == 1)
+              sum = sum + decompress_section<true, 1>(s);
+            else
+              sum = sum + decompress_section<true, 2>(s);
+          } else {
+            if (channels == 1)
+              sum = sum + decompress_section<false, 1>(s);
+            else
+              sum = sum + decompress_section<false, 2>(s);
+          }
+        });
+    }
+}
+
+void GOPerfTestMicro::RunFader() {
+  const unsigned nPeriods = TARGET_FRAMES / PERIOD_FRAMES;
+  GOSoundFader fader;
+  // prevents optimising the fader away
+  volatile float sum = 0;
+
+  for (bool isRamp : {false, true})
+    r_report.Measure(
+      wxT("fader"),
+      {{wxT("ramp"), isRamp ? wxT("true") : wxT("false")}},
+      wxT("period"),
+      nPeriods,
+      [&]() {
+        // the ramp fader increases the volume during all the periods
+        fader.Setup(0.5f, 1.0f, isRamp ? TARGET_FRAMES : 0);
+        for (unsigned i = 0; i < nPeriods; i++) {
+          const GOSoundFader::Ramp ramp = fader.NextRamp(PERIOD_FRAMES, 0.9f);
+
+          sum = sum + ramp.m_Volume + ramp.m_DeltaPerFrame;
+        }
+      });
+}
+
+template <bool isRamp, bool isFilter>
+static void mix_buffers(
+  GOSoundFilter::FilterState &state,
+  const float *pIn,
+  float *pOut,
+  unsigned nFrames) {
+  float volume = 0.5f;
+
+  for (unsigned i = 0; i < nFrames; i += PERIOD_FRAMES)
+    state.MixBuffer<isRamp, isFilter>(
+      PERIOD_FRAMES, pIn, pOut, volume, isRamp ? 1e-7f : 0.0f);
+}
+
+void GOPerfTestMicro::RunFilter() {
+  GOSoundFilter filter;
+  GOSoundFilter::FilterState state;
+  std::vector<float> in(PERIOD_FRAMES * 2);
+  std::vector<float> out(PERIOD_FRAMES * 2);
+
+  for (unsigned i = 0; i < in.size(); i++)
+    in[i] = sin(i * 0.1);
+  filter.SetSamplerate(TARGET_SAMPLE_RATE);
+  filter.Init(GOSoundFilter::FilterType::TYPE_HIGH_SHELF, 1000, 6);
+  state.Init(&filter);
+  for (bool isRamp : {false, true})
+    for (bool isFilter : {false, true})
+      r_report.Measure(
+        wxT("tone_balance_filter"),
+        {{wxT("ramp"), isRamp ? wxT("true") : wxT("false")},
+         {wxT("filter"), isFilter ? wxT("true") : wxT("false")}},
+        wxT("frame"),
+        TARGET_FRAMES,
+        [&]() {
+          if (isRamp && isFilter)
+            mix_buffers<true, true>(state, in.data(), out.data(), TARGET_FRAMES);
+          else if (isRamp)
+            mix_buffers<true, false>(
+              state, in.data(), out.data(), TARGET_FRAMES);
+          else if (isFilter)
+            mix_buffers<false, true>(
+              state, in.data(), out.data(), TARGET_FRAMES);
+          else
+            mix_buffers<false, false>(
+              state, in.data(), out.data(), TARGET_FRAMES);
+        });
+}
+
+void GOPerfTestMicro::RunOutputMixing() {
+  for (unsigned samplesPerBuffer : {128, 1024})
+    for (unsigned nGroups : {1, 4, 16}) {
+      ptr_vector<GOPerfTestBufferItem> groups;
+      std::vector<GOSoundBufferItem *> outputs;
+      // all groups go to both channels
+      std::vector<float> scaleFactors(2 * nGroups * 2, 0.5f);
+
+      for (unsigned i = 0; i < nGroups; i++) {
+        groups.push_back(new GOPerfTestBufferItem(samplesPerBuffer));
+        outputs.push_back(groups[i]);
+      }
+
+      GOSoundOutputTask task(2, scaleFactors, samplesPerBuffer);
+      const unsigned nPeriods = TARGET_FRAMES / samplesPerBuffer;
+
+      task.SetOutputs(outputs);
+      r_report.Measure(
+        wxT("output_mixing"),
+        {{wxT("samples_per_buffer"),
+          wxString::Format(wxT("%u"), samplesPerBuffer)},
+         {wxT("groups"), wxString::Format(wxT("%u"), nGroups)}},
+        wxT("frame"),
+        nPeriods * samplesPerBuffer,
+        [&]() {
+          for (unsigned i = 0; i < nPeriods; i++) {
+            task.Reset();
+            task.Run();
+          }
+        });
+    }
+}
+
+void GOPerfTestMicro::RunReverbPartition() {
+  // a two seconds exponentially decaying impulse response
+  std::vector<float> ir(TARGET_SAMPLE_RATE * 2);
+
+  for (unsigned i = 0; i < ir.size(); i++)
+    ir[i] = exp(-3.0 * i / TARGET_SAMPLE_RATE)
+      * ((i * 7919 % 1000) / 500.0 - 1.0);
+
+  for (unsigned samplesPerBuffer : {64, 128, 256, 512, 1024}) {
+    GOSoundReverbEngine engine(samplesPerBuffer);
+    std::vector<float> in(samplesPerBuffer);
+    std::vector<float> out(samplesPerBuffer);
+    const unsigned nPeriods = TARGET_FRAMES / samplesPerBuffer;
+
+    for (unsigned i = 0; i < in.size(); i++)
+      in[i] = sin(i * 0.1);
+    engine.AddIR(ir.data(), 0, ir.size());
+    r_report.Measure(
+      wxT("reverb_partition"),
+      {{wxT("samples_per_buffer"),
+        wxString::Format(wxT("%u"), samplesPerBuffer)},
+       {wxT("ir_length"), wxString::Format(wxT("%u"), (unsigned)ir.size())}},
+      wxT("frame"),
+      nPeriods * samplesPerBuffer,
+      [&]() {
+        for (unsigned i = 0; i < nPeriods; i++)
+          engine.Process(out.data(), in.data(), samplesPerBuffer);
+      });
+  }
+}
+
+void GOPerfTestMicro::Run() {
+  RunResampler();
+  RunDecompression();
+  RunFader();
+  RunFilter();
+  RunOutputMixing();
+  RunReverbPartition();
+}
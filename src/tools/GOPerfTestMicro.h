@@ -0,0 +1,42 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOPERFTESTMICRO_H
+#define GOPERFTESTMICRO_H
+
+#include "GOMemoryPool.h"
+
+class GOPerfTestReport;
+class GOSoundAudioSection;
+
+/**
+ * The benchmarks of the separate building blocks of the sound engine. They
+ * work on synthetic data, so they need neither test files nor an organ
+ */
+class GOPerfTestMicro {
+private:
+  GOPerfTestReport &r_report;
+  GOMemoryPool m_pool;
+
+  /* Creates a looped section of a synthetic stereo tone */
+  GOSoundAudioSection *CreateSection(
+    unsigned bitsPerSample, bool compress, unsigned channels);
+
+  void RunResampler();
+  void RunDecompression();
+  void RunFader();
+  void RunFilter();
+  void RunOutputMixing();
+  void RunReverbPartition();
+
+public:
+  GOPerfTestMicro(GOPerfTestReport &report);
+
+  void Run();
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOPerfTestReport.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <wx/datetime.h>
+#include <wx/ffile.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/thread.h>
+
+#include "go_defs.h"
+
+GOPerfTestReport::GOPerfTestReport(unsigned repetitions)
+  : m_Repetitions(std::max(repetitions, 1u)), m_Results() {}
+
+GOPerfTestReport::Statistic GOPerfTestReport::calcStatistic(
+  std::vector<double> values) {
+  Statistic s = {0, 0, 0, 0, 0, 0};
+  const unsigned n = values.size();
+
+  if (!n)
+    return s;
+  std::sort(values.begin(), values.end());
+  s.m_Min = values.front();
+  s.m_Max = values.back();
+  for (double v : values)
+    s.m_Mean += v;
+  s.m_Mean /= n;
+  s.m_Median
+    = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+  for (double v : values)
+    s.m_StdDev += (v - s.m_Mean) * (v - s.m_Mean);
+  // the sample standard deviation
+  s.m_StdDev = n > 1 ? sqrt(s.m_StdDev / (n - 1)) : 0;
+  // the nearest-rank method
+  s.m_P90 = values[std::min(n - 1, (unsigned)ceil(0.9 * n) - 1)];
+  return s;
+}
+
+void GOPerfTestReport::AddResult(
+  const wxString &name,
+  const Params &params,
+  const wxString &unit,
+  const std::vector<double> &values) {
+  Result r;
+
+  r.m_Name = name;
+  r.m_Params = params;
+  r.m_Unit = unit;
+  r.m_Values = values;
+  r.m_Statistic = calcStatistic(values);
+  m_Results.push_back(r);
+
+  wxString paramStr;
+
+  for (const auto &param : params)
+    paramStr += wxString::Format(wxT(" %s=%s"), param.first, param.second);
+  wxLogMessage(
+    wxT("%s%s: median %.3f %s, min %.3f, stddev %.3f"),
+    name,
+    paramStr,
+    r.m_Statistic.m_Median,
+    unit,
+    r.m_Statistic.m_Min,
+    r.m_Statistic.m_StdDev);
+}
+
+static wxString json_string(const wxString &str) {
+  wxString res = wxT("\"");
+
+  for (wxUniChar c : str) {
+    if (c == '"' || c == '\\')
+      res << wxT('\\') << c;
+    else if (c < 0x20)
+      res << wxString::Format(wxT("\\u%04x"), (unsigned)c.GetValue());
+    else
+      res << c;
+  }
+  res << wxT("\"");
+  return res;
+}
+
+static wxString json_number(double value) {
+  // JSON does not have NaN and infinity
+  return std::isfinite(value) ? wxString::FromCDouble(value, 3) : wxT("null");
+}
+
+bool GOPerfTestReport::WriteJson(const wxString &fileName) const {
+  wxString out;
+
+  out << wxT("{\n");
+  out << wxT("  \"version\": ") << json_string(wxT(APP_VERSION)) << wxT(",\n");
+  out << wxT("  \"date\": ")
+      << json_string(wxDateTime::Now().FormatISOCombined()) << wxT(",\n");
+  out << wxT("  \"cpus\": ") << wxThread::GetCPUCount() << wxT(",\n");
+  out << wxT("  \"repetitions\": ") << m_Repetitions << wxT(",\n");
+  out << wxT("  \"benchmarks\": [");
+  for (unsigned i = 0; i < m_Results.size(); i++) {
+    const Result &r = m_Results[i];
+    const Statistic &s = r.m_Statistic;
+
+    out << (i ? wxT(",\n") : wxT("\n"));
+    out << wxT("    {\n");
+    out << wxT("      \"name\": ") << json_string(r.m_Name) << wxT(",\n");
+    out << wxT("      \"params\": {");
+    for (unsigned j = 0; j < r.m_Params.size(); j++)
+      out << (j ? wxT(", ") : wxT("")) << json_string(r.m_Params[j].first)
+          << wxT(": ") << json_string(r.m_Params[j].second);
+    out << wxT("},\n");
+    out << wxT("      \"unit\": ") << json_string(r.m_Unit) << wxT(",\n");
+    out << wxT("      \"min\": ") << json_number(s.m_Min) << wxT(",\n");
+    out << wxT("      \"max\": ") << json_number(s.m_Max) << wxT(",\n");
+    out << wxT("      \"mean\": ") << json_number(s.m_Mean) << wxT(",\n");
+    out << wxT("      \"median\": ") << json_number(s.m_Median) << wxT(",\n");
+    out << wxT("      \"stddev\": ") << json_number(s.m_StdDev) << wxT(",\n");
+    out << wxT("      \"p90\": ") << json_number(s.m_P90) << wxT(",\n");
+    out << wxT("      \"values\": [");
+    for (unsigned j = 0; j < r.m_Values.size(); j++)
+      out << (j ? wxT(", ") : wxT("")) << json_number(r.m_Values[j]);
+    out << wxT("]\n");
+    out << wxT("    }");
+  }
+  out << wxT("\n  ]\n}\n");
+
+  wxFFile file(fileName, wxT("w"));
+
+  if (!file.IsOpened() || !file.Write(out, wxConvUTF8) || !file.Close()) {
+    wxLogError(_("Unable to write '%s'"), fileName);
+    return false;
+  }
+  return true;
+}
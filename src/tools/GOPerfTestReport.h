@@ -0,0 +1,101 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOPERFTESTREPORT_H
+#define GOPERFTESTREPORT_H
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include <wx/string.h>
+
+/**
+ * Collects the results of the benchmarks and writes them as JSON.
+ *
+ * Each benchmark is repeated several times. A repetition does a fixed amount
+ * of work, so the time per unit of work is comparable between the runs and
+ * the releases. The statistical summary of the repetitions is stored together
+ * with the raw values.
+ */
+class GOPerfTestReport {
+public:
+  /* The benchmark parameters as the name-value pairs */
+  typedef std::vector<std::pair<wxString, wxString>> Params;
+
+  struct Statistic {
+    double m_Min;
+    double m_Max;
+    double m_Mean;
+    double m_Median;
+    double m_StdDev;
+    // 90th percentile
+    double m_P90;
+  };
+
+private:
+  struct Result {
+    wxString m_Name;
+    Params m_Params;
+    wxString m_Unit;
+    std::vector<double> m_Values;
+    Statistic m_Statistic;
+  };
+
+  unsigned m_Repetitions;
+  std::vector<Result> m_Results;
+
+public:
+  GOPerfTestReport(unsigned repetitions);
+
+  unsigned GetRepetitions() const { return m_Repetitions; }
+
+  static Statistic calcStatistic(std::vector<double> values);
+
+  /* Stores the values measured and logs the summary */
+  void AddResult(
+    const wxString &name,
+    const Params &params,
+    const wxString &unit,
+    const std::vector<double> &values);
+
+  /**
+   * Runs func once for warming up the caches and then GetRepetitions() times
+   * measuring the wall time of each run
+   * @param name the benchmark name
+   * @param params the benchmark parameters
+   * @param unit the name of a unit of work
+   * @param nUnits the number of the work units done by one run of func
+   * @param func the work to measure
+   */
+  template <class FuncT>
+  void Measure(
+    const wxString &name,
+    const Params &params,
+    const wxString &unit,
+    double nUnits,
+    FuncT func) {
+    std::vector<double> values;
+
+    func();
+    for (unsigned i = 0; i < m_Repetitions; i++) {
+      const auto start = std::chrono::steady_clock::now();
+
+      func();
+
+      const std::chrono::duration<double, std::nano> diff
+        = std::chrono::steady_clock::now() - start;
+
+      values.push_back(diff.count() / nUnits);
+    }
+    AddResult(name, params, wxT("ns/") + unit, values);
+  }
+
+  bool WriteJson(const wxString &fileName) const;
+};
+
+#endif